@@ -0,0 +1,15 @@
+#pragma once
+#include <stdio.h>
+#include "image.h"
+#include "samples.h"
+
+/*
+ * Bulk symbolization: one line per distinct address, in address order,
+ * with its count, containing function+offset and the instruction at that
+ * address. An address in the middle of an instruction shows the
+ * instruction it falls into; addresses outside the code print "?".
+ *
+ * Each function is decoded once, forward from its start and only as far
+ * as its last requested address (a merge join of both sorted streams).
+ */
+void addrs_report(FILE *out, const Image *img, const SampleIndex *addrs, const char *label);
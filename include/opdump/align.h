@@ -0,0 +1,14 @@
+#pragma once
+#include <stdio.h>
+#include "image.h"
+
+/*
+ * JCC-erratum and loop-alignment checks.
+ *
+ * A branch (jcc/jmp/call/ret, or a macro-fused cmp/test+jcc pair counted as
+ * one unit) is flagged when it crosses a 32-byte boundary ("cross32") or its
+ * last byte is the last byte of a 32-byte chunk ("end32").
+ * A loop head (target of a backward jcc/jmp inside the same function) is
+ * flagged when it is not aligned to loop_align bytes ("loop-align").
+ */
+void align_report(FILE *out, const Image *img, unsigned loop_align, const char *label);
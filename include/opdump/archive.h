@@ -0,0 +1,38 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * ar archives (static libraries), GNU and BSD member names.
+ *
+ * The archive is mapped once, private and writable so that member
+ * relocations can be applied in place; members are ranges of that mapping.
+ */
+typedef struct {
+  char name[256];
+  uint8_t *data;
+  size_t size;
+} ArMember;
+
+typedef struct {
+  uint8_t *buf;
+  size_t n;
+  ArMember *members;
+  size_t count;
+} Archive;
+
+// 1 when path starts with the "!<arch>\n" magic.
+int  archive_probe(const char *path);
+// IMG_OK, IMG_ERR_READ, or IMG_ERR_ELF for a malformed archive.
+int  archive_open(const char *path, Archive *ar);
+void archive_close(Archive *ar);
+
+typedef void (*ArMemberFn)(FILE *out, const ArMember *m, void *user);
+
+/**
+ * Calls fn for every member from up to `threads` workers. Each call writes
+ * to its own memory stream; the streams are copied to out in member order
+ * as they complete, so the output matches a sequential run.
+ */
+void archive_run(FILE *out, const Archive *ar, size_t threads, ArMemberFn fn, void *user);
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Bump allocator over a list of malloc'd chunks.
+ *
+ * Allocations are 16-byte aligned and never freed one by one: a mark taken
+ * before a piece of work is reset afterwards, and the chunks it used are
+ * kept for the next one, so repeated work of the same size (per function,
+ * per segment, per archive member) stops calling malloc after the first
+ * round. Chunks larger than the chunk size hold a single big allocation
+ * and are freed on reset instead. arena_free releases the whole arena at
+ * once; its chunks go to a small per-thread pool that the next arena on
+ * the thread draws from, so loading one archive member after another
+ * stops calling malloc too.
+ *
+ * Each image owns an arena for its ELF tables; each thread has a scratch
+ * arena (arena_thread) for decode batches and region lists.
+ */
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+  ArenaChunk *head;     // chunk being filled; earlier ones follow
+  ArenaChunk *spare;    // chunks released by arena_reset, for reuse
+  size_t chunk;         // minimum chunk size
+  size_t used, peak;    // bytes handed out (with alignment), high-water mark
+  size_t reserved;      // bytes in all chunks
+  size_t mallocs;       // chunks allocated
+} Arena;
+
+typedef struct {
+  ArenaChunk *head;
+  size_t head_used;
+  size_t used;
+} ArenaMark;
+
+// chunk 0 picks the default (256 KiB).
+void  arena_init(Arena *a, size_t chunk);
+// n bytes, 16-byte aligned; NULL when out of memory. n == 0 returns a valid pointer.
+void* arena_alloc(Arena *a, size_t n);
+ArenaMark arena_mark(const Arena *a);
+// Releases everything allocated since m; default-size chunks are kept.
+void  arena_reset(Arena *a, ArenaMark m);
+// Releases all chunks (to the thread's pool) and adds the arena to arena_stats.
+void  arena_free(Arena *a);
+
+// Scratch arena of the calling thread; it and the pool are released when the thread exits.
+Arena* arena_thread(void);
+
+/**
+ * "# arena: ..." line: arenas seen, the largest peak use of any one arena,
+ * the most bytes held in chunks at any time (all threads, pooled chunks
+ * included) and the number of chunk mallocs.
+ */
+void  arena_stats(FILE *out);
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Instruction boundaries of a linear sweep, without full decoding.
+ *
+ * Lengths of the common encodings (optional REX + the one-byte and 0F
+ * rows of g_ops) come from tables built from g_ops at first use; group
+ * rows (81/83/C6/FF/F6/F7) learn which ModRM.reg values read an operand by
+ * probing decode_one. Where AVX2 is available, 32 candidate starts are
+ * measured at once for REX + 89/8B/8D/85/31/39/01/29/83/E8/E9/C3/50-5F/
+ * 70-7F/0F 1F/0F 8x. Prefixed, VEX/EVEX and SSE forms and the last bytes
+ * of the buffer go through decode_one, so the result always matches the
+ * instruction stream of decode_batch (undecodable bytes count as 1).
+ *
+ * Build with -DBOUNDARY_NO_SIMD to use the scalar tables only.
+ */
+
+/**
+ * Sets bit i of bits (n bits, cleared first) for every instruction start
+ * in p[0, n). Returns the instruction count.
+ */
+size_t insn_boundaries(const uint8_t *p, size_t n, uint64_t *bits);
+
+/**
+ * Offset of the instruction covering target in a sweep that starts at
+ * p[0]; n when target >= n.
+ */
+size_t insn_sync(const uint8_t *p, size_t n, size_t target);
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "image.h"
+
+/*
+ * Static call graph of one image.
+ *
+ * Nodes are the regions of every executable segment (functions, plus
+ * unnamed ones such as the PLT), sorted by address. Edges are stored as
+ * CSR: the callees of node i are edge[row[i] .. row[i+1]), sorted by callee.
+ * A call rel adds a call site to its edge; a jmp/jcc rel that leaves the
+ * function for another node is a tail call. Indirect calls and jumps are
+ * only counted per node.
+ */
+typedef struct {
+  uint64_t addr, size;
+  const char *name;     // NULL: unnamed region
+  uint32_t indirect;    // call reg / call [mem]
+  uint32_t ind_jumps;   // jmp reg / jmp [mem]: jump tables or tail calls
+  uint32_t ext_calls;   // call / tail jmp rel outside every node, or to an
+                        // unresolved relocation (.o)
+  uint32_t callers;     // distinct callers
+} CgNode;
+
+typedef struct {
+  uint32_t callee;
+  uint32_t calls;       // call sites
+  uint32_t tails;       // jmp / jcc sites
+} CgEdge;
+
+typedef struct {
+  CgNode *nodes;
+  size_t nnodes;
+  uint32_t *row;        // nnodes + 1 entries
+  CgEdge *edge;
+  size_t nedges;
+} CallGraph;
+
+typedef enum { CG_NONE = 0, CG_TEXT, CG_DOT, CG_BIN } CgFormat;
+
+// CG_* for "text", "dot" or "bin"; -1 otherwise.
+int  callgraph_format(const char *name);
+
+// Symbols must be loaded. Decodes on up to `threads` threads. Returns 1 on success.
+int  callgraph_build(const Image *img, size_t threads, CallGraph *cg);
+void callgraph_free(CallGraph *cg);
+
+/**
+ * CG_TEXT: one row per node with edges (callees, callers, call sites,
+ *   tail and indirect counts), then a totals line.
+ * CG_DOT: a digraph; tail calls are dashed, counts > 1 label the edge.
+ * CG_BIN: "OPDCG01\n", u64 nodes, u64 edges, u64 string bytes, then
+ *   nodes x { u64 addr, u32 size, u32 name offset (~0: none), u32 indirect,
+ *   u32 ind_jumps, u32 ext_calls, u32 callers }, u32 row[nodes + 1],
+ *   edges x { u32 callee, u32 calls, u32 tails }, and the NUL-terminated
+ *   names; all little-endian.
+ * Returns 1 unless writing failed.
+ */
+int  callgraph_write(FILE *out, const CallGraph *cg, CgFormat fmt, const char *label);
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdio.h>
+
+/*
+ * Build-to-build code diff.
+ *
+ * Instructions are normalized before hashing: addresses are dropped, branch
+ * targets inside the function become function offsets, targets and
+ * RIP-relative operands elsewhere become symbol+offset (or <data> when no
+ * function symbol covers them). Functions are matched by name, then the
+ * leftovers by hash (renames); only changed functions get an instruction
+ * diff. Both files are loaded and hashed on separate threads.
+ *
+ * Returns 0 when no function changed, 1 when some did, or an IMG_ERR_* code.
+ */
+int code_diff(FILE *out, const char *old_path, const char *new_path);
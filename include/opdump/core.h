@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "arena.h"
+
+/*
+ * ELF core files (ET_CORE): the executable mappings of a crashed process.
+ *
+ * The core is mapped, not read: opening it touches the program headers and
+ * the notes, and a listing touches only the pages of the windows it shows.
+ * NT_FILE ties each mapping to the file it came from; that file supplies
+ * the bytes the kernel left out of the dump (read-only file pages usually
+ * are) and the symbols. NT_PRSTATUS gives the registers of every thread,
+ * the first being the one that took the fatal signal.
+ */
+
+// One NT_FILE entry: [start, end) maps path from file offset `offset`.
+typedef struct {
+  uint64_t start, end;
+  uint64_t offset;
+  const char *path;     // points into the core
+} CoreFile;
+
+// One NT_PRSTATUS note (x86-64 register layout).
+typedef struct {
+  uint32_t pid;
+  uint32_t signo;       // pr_cursig, 0 for threads that were only stopped
+  uint64_t pc, sp;
+} CoreThread;
+
+// One executable PT_LOAD; bytes past filesz are not in the core.
+typedef struct {
+  uint64_t start, end;
+  uint64_t offset;      // of start in the core
+  uint64_t filesz;
+  const CoreFile *file; // NT_FILE entry covering start, or NULL (anonymous / JIT)
+} CoreMap;
+
+typedef struct {
+  const char *path;
+  const uint8_t *buf;   // the core, mapped read-only
+  size_t n;
+
+  Arena arena;          // maps, files, threads
+
+  CoreMap *maps;        // by address
+  size_t map_count;
+  CoreFile *files;
+  size_t file_count;
+  CoreThread *threads;
+  size_t thread_count;
+} Core;
+
+// True when path starts with an ELF64 header of type ET_CORE.
+int  core_probe(const char *path);
+// IMG_* error codes (image.h).
+int  core_open(const char *path, Core *c);
+void core_close(Core *c);
+
+// The mapping holding addr, or NULL.
+const CoreMap* core_find(const Core *c, uint64_t addr);
+
+/**
+ * Copies [addr, addr+len) of mapping m into buf: what the core holds, then
+ * the rest from the NT_FILE backing file. Bytes found in neither are
+ * zero-filled. Returns how many bytes were found.
+ */
+size_t core_read(const Core *c, const CoreMap *m, uint64_t addr, size_t len, uint8_t *buf);
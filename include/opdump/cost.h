@@ -0,0 +1,55 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include "insn.h"
+#include "image.h"
+
+/*
+ * Static throughput / latency estimate (llvm-mca style, much simpler).
+ *
+ * Every Op maps to a cost class; each microarchitecture profile gives a
+ * class its fused uops, result latency, execution ports and port occupancy.
+ * Memory operands add load / store uops on top of the class cost.
+ */
+
+typedef enum {
+  COST_ALU, COST_MOV, COST_LEA, COST_CMOV, COST_SETCC, COST_IMUL, COST_DIV,
+  COST_BRANCH, COST_CALL, COST_RET, COST_PUSH, COST_POP, COST_LEAVE, COST_NOP,
+  COST_VMOV, COST_VLOGIC, COST_VIADD, COST_VIMUL, COST_VSHUF, COST_VPERM,
+  COST_FADD, COST_FMUL, COST_FMA, COST_FDIV, COST_FSQRT, COST_FCMP,
+  COST_MOVD, COST_KMASK, COST_VZERO,
+  COST_COUNT
+} CostClass;
+
+typedef struct {
+  uint8_t  uops;   // fused-domain uops (register form)
+  uint8_t  lat;    // result latency in cycles
+  uint16_t ports;  // execution ports (bit mask into UarchProfile.port_names)
+  uint8_t  occ;    // cycles a port stays busy per uop (dividers)
+} CostEntry;
+
+enum { COST_MAX_PORTS = 16 };
+
+typedef struct {
+  const char *name;
+  unsigned width;        // fused uops issued per cycle
+  unsigned load_lat;     // L1 load-to-use
+  unsigned nloads;       // loads per cycle
+  unsigned nstores;      // stores per cycle
+  uint16_t zmm_ports;    // ports usable by 512-bit uops, 0 = no restriction
+  unsigned nports;
+  const char *port_names[COST_MAX_PORTS];
+  CostEntry cls[COST_COUNT];
+} UarchProfile;
+
+// "skl" (Skylake / Skylake-X) or "zen3"; NULL if unknown.
+const UarchProfile* cost_profile(const char *name);
+
+CostClass cost_class(const Insn *in);
+
+/**
+ * For every backward-branch loop: estimated cycles per iteration and the
+ * bottleneck (frontend, a port, loads, stores or the loop-carried chain).
+ * Then one line per function with its straight-line blocks' total estimate.
+ */
+void cost_report(FILE *out, const Image *img, const UarchProfile *prof, const char *label);
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include "image.h"
+
+/*
+ * Data embedded in executable segments, found ahead of the listing sweep
+ * so it can be shown as hex instead of decoded into garbage.
+ *
+ *   table    jump tables: 8-byte entries behind jmp [idx*8 + T], int32
+ *            entries behind lea r, [rip + T] ... jmp r, and (ET_REL) runs
+ *            of absolute / 32-bit relocations too dense to be code
+ *   object   sized STT_OBJECT symbols
+ *   string   12+ printable bytes ending in a NUL
+ *   fill     16+ copies of one byte other than nop / int3 (entropy 0)
+ *   invalid  128+ bytes dense in opcodes this decoder does not know, with
+ *            entropy near the maximum (compiled code stays well below)
+ *
+ * Heuristic ranges stop at the next function symbol, and an invalid range
+ * followed shortly by one runs up to it, so decoding restarts at a likely
+ * instruction boundary. Where kinds overlap the earlier one in the list
+ * wins. Sorted by address, non-overlapping.
+ */
+typedef enum {
+  DATA_TABLE, DATA_OBJECT, DATA_STRING, DATA_FILL, DATA_INVALID, DATA_KINDS
+} DataKind;
+
+typedef struct {
+  uint64_t addr, end;
+  DataKind kind;
+} DataRange;
+
+/**
+ * Data ranges of every executable segment (load the symbols first).
+ * *out (allocated in a) gets *n ranges. Returns 0, with no ranges, when
+ * memory runs out.
+ */
+int data_scan(const Image *img, Arena *a, DataRange **out, size_t *n);
+
+const char* data_kind_name(DataKind k);
+
+// "# data-in-code: ..." ranges and bytes per kind, against the code bytes of img.
+void data_stats(FILE *out, const Image *img, const DataRange *r, size_t n, const char *label);
@@ -9,3 +9,12 @@ typedef struct {
 
 // returns bytes consumed; 0 = failed/invalid
 size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t addr, Insn *out);
+
+// Decodes up to cap instructions starting at p. Undecodable bytes become
+// 1-byte OP_INVALID entries so the stream always advances.
+// Returns the instruction count; *used receives the bytes consumed.
+size_t decode_batch(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t addr,
+                    Insn *out, size_t cap, size_t *used);
+
+// Padding: a nop, or an undecoded int3 / zero byte.
+int insn_is_fill(const Insn *in);
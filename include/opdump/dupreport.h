@@ -0,0 +1,25 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+  size_t threads;       // hashing workers
+  uint64_t min_bytes;   // smaller functions are ignored
+} DupOptions;
+
+/*
+ * Duplicate-code report over one or more binaries (archives contribute
+ * every member).
+ *
+ * Instructions are normalized before hashing: addresses are dropped, jumps
+ * inside the function keep their function offset, and calls, other branch
+ * targets and RIP-relative displacements are masked. Each function gets a
+ * whole-function hash (identical copies) and a MinHash signature over
+ * rolling hashes of instruction 4-grams; signatures that collide in an LSH
+ * band and agree in most slots make a near-identical group. Groups are
+ * ranked by wasted bytes: everything but the largest copy.
+ *
+ * Returns 0, or the IMG_ERR_* code of the last input that failed to load.
+ */
+int dup_report(FILE *out, const char *const *paths, size_t npaths, const DupOptions *opt);
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "image.h"
+
+/*
+ * Address -> (file, line) table built from DWARF 2-5 .debug_line.
+ *
+ * Only the units whose code overlaps the requested window are decoded:
+ * .debug_aranges picks the compile units, their DW_AT_stmt_list gives the
+ * line program. Without .debug_aranges every line program is run and rows
+ * outside the window are dropped. Compressed debug sections are not read.
+ */
+
+typedef struct {
+  uint64_t addr;
+  uint32_t file;   // index into LineTable.files; UINT32_MAX ends a sequence
+  uint32_t line;
+} LineRow;
+
+typedef struct {
+  const char *dir;  // may be NULL
+  const char *name;
+} LineFile;
+
+typedef struct {
+  LineRow *rows;    // sorted by addr
+  size_t n;
+  LineFile *files;
+  size_t nfiles;
+} LineTable;
+
+// Returns 1 when the image has .debug_line (the table may still be empty).
+int  line_table_load(const Image *img, uint64_t lo, uint64_t hi, LineTable *out);
+void line_table_free(LineTable *t);
+
+// Walks rows in address order: *cur starts at line_table_seek(t, a0).
+size_t line_table_seek(const LineTable *t, uint64_t addr);
+
+// Row in effect at addr (advancing *cur), or NULL outside any sequence.
+const LineRow* line_table_at(const LineTable *t, size_t *cur, uint64_t addr);
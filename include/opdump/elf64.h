@@ -8,6 +8,7 @@ typedef struct {
   uint64_t filesz;  // p_filesz
   uint64_t offset;  // file offset
   uint32_t flags;   // p_flags
+  uint32_t shndx;   // ET_REL: section index; 0 for PT_LOAD segments
 } ElfExecSeg;
 
 typedef struct {
@@ -21,8 +22,15 @@ typedef struct {
   uint64_t phoff;
   uint16_t phentsz;
   uint16_t phnum;
+
+  uint64_t shoff;
+  uint16_t shentsz;
+  uint16_t shnum;
+  uint16_t shstrndx;
 } ElfInfo;
 
+enum { ET_REL = 1, ET_EXEC = 2, ET_DYN = 3, ET_CORE = 4 };
+
 int elf64_parse_info(const uint8_t *buf, size_t n, ElfInfo *out);
 
 /**
@@ -31,3 +39,14 @@ int elf64_parse_info(const uint8_t *buf, size_t n, ElfInfo *out);
  */
 size_t elf64_collect_exec_segments(const uint8_t *buf, size_t n,
                                    ElfExecSeg *out_segs, size_t cap);
+
+/**
+ * ET_REL: SHF_EXECINSTR sections laid out back to back from address 0 (each
+ * at its sh_addralign), the way a linker would place them. Symbol values
+ * and relocations of section k are relative to the vaddr given here.
+ */
+size_t elf64_collect_exec_sections(const uint8_t *buf, size_t n,
+                                   ElfExecSeg *out_segs, size_t cap);
+
+// Name of section idx from .shstrtab, or NULL.
+const char* elf64_section_name(const uint8_t *buf, size_t n, uint32_t idx);
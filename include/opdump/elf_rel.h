@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "elf64.h"
+
+/*
+ * Relocations of ET_REL objects (SHT_RELA sections that patch code).
+ *
+ * Addresses are in the layout of elf64_collect_exec_sections(). PC32 /
+ * PLT32 fixups whose symbol is defined in one of the laid-out sections are
+ * applied to the buffer, so calls and jumps between functions decode to
+ * their real target; everything else is only labeled.
+ */
+typedef struct {
+  uint64_t addr;      // patched field
+  uint32_t type;      // R_X86_64_*
+  int64_t addend;
+  const char *sym;    // symbol or section name (points into the buffer), or ""
+  int applied;        // field now holds the resolved displacement
+} ElfReloc;
+
+/**
+ * Collects (and applies, see above) the relocations of segs, sorted by
+ * address. buf must be writable. Returns the count; *out is malloc'd.
+ */
+size_t elf_rel_collect(uint8_t *buf, size_t n, const ElfExecSeg *segs, size_t nseg,
+                       ElfReloc **out);
+
+// First relocation with addr >= a.
+size_t elf_rel_lower_bound(const ElfReloc *rel, size_t n, uint64_t a);
+
+// "R_X86_64_PLT32"; unknown types as "R_X86_64_<n>" in a static buffer.
+const char* elf_rel_type_name(uint32_t type);
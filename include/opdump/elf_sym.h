@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "elf64.h"
+#include "arena.h"
+
+typedef struct {
+  uint64_t addr;
+  uint64_t size;      // zero-size symbols are extended up to the next one
+  const char *name;   // points into the file buffer
+} ElfSym;
+
+/**
+ * Function symbols (STT_FUNC / STT_GNU_IFUNC) from .symtab, or .dynsym when
+ * the file is stripped. Sorted by address, one entry per address.
+ * Returns the count; *out is allocated in a (NULL when there are none).
+ */
+size_t elf64_collect_func_symbols(const uint8_t *buf, size_t n, Arena *a, ElfSym **out);
+
+// Sized data symbols (STT_OBJECT), same source and order; sizes kept as is.
+size_t elf64_collect_object_symbols(const uint8_t *buf, size_t n, Arena *a, ElfSym **out);
+
+// Symbol whose [addr, addr+size) contains addr, or NULL.
+const ElfSym* elf_sym_lookup(const ElfSym *syms, size_t count, uint64_t addr);
+
+typedef struct {
+  const char *name;   // NULL for bytes not covered by any symbol
+  uint64_t addr;
+  uint64_t size;
+  uint64_t offset;    // file offset of addr
+} Region;
+
+// name, or "<region_ADDR>" written to buf for bytes outside any symbol.
+const char* region_name(const char *name, uint64_t addr, char *buf, size_t cap);
+
+/**
+ * Splits an executable segment along function symbols; uncovered gaps
+ * become unnamed regions. Returns the count; *out is allocated in a
+ * (usually the thread's scratch arena, reset once the regions are done).
+ */
+size_t elf_split_regions(const ElfExecSeg *seg, const ElfSym *syms, size_t count,
+                         Arena *a, Region **out);
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "insn.h"
+
+// Growable array holding one function's decoded instructions.
+typedef struct {
+  Insn *v;
+  size_t n, cap;
+} InsnVec;
+
+// Decodes [addr, addr+size) into vec (previous contents are dropped).
+// Returns 0 on allocation failure.
+int  insn_vec_decode(InsnVec *vec, const uint8_t *p, uint64_t size, uint64_t addr);
+void insn_vec_free(InsnVec *vec);
+
+// Index of the instruction starting exactly at addr, or (size_t)-1.
+size_t insn_vec_find(const InsnVec *vec, uint64_t addr);
+
+// A backward-branch region: instructions head..tail, tail is the branch.
+typedef struct {
+  size_t head, tail;
+} Loop;
+
+/**
+ * Finds loops closed by backward jcc/jmp rel whose target is an instruction
+ * of the same vector; one loop per head (the farthest back-edge wins).
+ * Sorted by head. Returns the count; *out is grown with realloc.
+ */
+size_t flow_find_loops(const InsnVec *vec, Loop **out, size_t *cap);
+
+// True for instructions that end a basic block.
+int flow_ends_block(const Insn *in);
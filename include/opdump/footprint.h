@@ -0,0 +1,28 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include "image.h"
+
+/*
+ * Code footprint per function: size, instruction count, alignment padding,
+ * 64-byte i-cache lines and 4 KiB pages touched, and undecodable bytes.
+ *
+ * Padding counts nop instructions inside the function plus the nop / int3 /
+ * zero fill between it and the next function (that fill is not a row of its
+ * own). One decode pass over each executable segment.
+ */
+
+typedef enum {
+  FP_SORT_ADDR = 0, FP_SORT_NAME, FP_SORT_BYTES, FP_SORT_INSNS, FP_SORT_PAD,
+  FP_SORT_LINES, FP_SORT_PAGES, FP_SORT_DB
+} FootSort;
+
+// "addr", "name", "bytes", "insns", "pad", "lines", "pages", "db"; -1 if unknown.
+int footprint_sort_key(const char *name);
+
+/**
+ * Rows sorted by key (descending, except addr and name), then a total row.
+ * csv selects comma-separated output with a header line; with a label the
+ * first column is the file.
+ */
+void footprint_report(FILE *out, const Image *img, FootSort key, int csv, const char *label);
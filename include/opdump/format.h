@@ -5,3 +5,7 @@
 void format_intel(FILE *out, const Insn *in);
 const char* reg_name64(uint8_t r);
 const char* cc_name(Cond cc);
+const char* op_name(Op op);
+
+// One listing line: address, raw bytes padded to a fixed column, Intel text.
+void format_line(FILE *out, const Insn *in);
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "elf64.h"
+#include "elf_sym.h"
+#include "elf_rel.h"
+#include "arena.h"
+
+// Error codes double as the process exit status.
+enum { IMG_OK = 0, IMG_ERR_READ = 2, IMG_ERR_ELF = 3, IMG_ERR_NOEXEC = 4 };
+
+typedef struct {
+  const char *path;
+  uint8_t *buf;
+  size_t n;
+  int mapped;         // buf is an mmap of the file (image_map)
+  int borrowed;       // buf belongs to the caller (image_from_memory)
+  ElfInfo info;
+
+  Arena arena;        // segs and syms; released by image_free
+
+  ElfExecSeg *segs;   // ET_REL objects can have thousands of sections
+  size_t seg_count;
+
+  ElfSym *syms;       // filled by image_load_symbols()
+  size_t sym_count;
+
+  ElfReloc *relocs;   // ET_REL: code relocations, already applied where possible
+  size_t reloc_count;
+} Image;
+
+int  image_load(const char *path, Image *img);
+// Same as image_load, but maps the file (private, copy-on-write) instead of reading it.
+int  image_map(const char *path, Image *img);
+// Parses n bytes at buf (e.g. an archive member); buf must stay valid and writable.
+int  image_from_memory(const char *path, uint8_t *buf, size_t n, Image *img);
+void image_load_symbols(Image *img);
+void image_free(Image *img);
+const char* image_strerror(int err);
@@ -35,6 +35,49 @@ typedef enum {
 
   OP_CMOVCC,
 
+  OP_DIV, OP_IDIV, OP_IMUL,
+  OP_XADD, OP_CMPXCHG,
+
+  // SSE / AVX / AVX-512 (see g_vops); VEX/EVEX forms print with a 'v' prefix
+  OP_MOVUPS, OP_MOVUPD, OP_MOVSS, OP_MOVSD,
+  OP_MOVAPS, OP_MOVAPD,
+  OP_MOVD, OP_MOVQ, OP_MOVDQA, OP_MOVDQU,
+  OP_UCOMISS, OP_UCOMISD, OP_COMISS, OP_COMISD,
+  OP_SQRTPS, OP_SQRTPD, OP_SQRTSS, OP_SQRTSD,
+  OP_ANDPS, OP_ANDPD, OP_ANDNPS, OP_ANDNPD,
+  OP_ORPS, OP_ORPD, OP_XORPS, OP_XORPD,
+  OP_ADDPS, OP_ADDPD, OP_ADDSS, OP_ADDSD,
+  OP_MULPS, OP_MULPD, OP_MULSS, OP_MULSD,
+  OP_SUBPS, OP_SUBPD, OP_SUBSS, OP_SUBSD,
+  OP_MINPS, OP_MINPD, OP_MINSS, OP_MINSD,
+  OP_DIVPS, OP_DIVPD, OP_DIVSS, OP_DIVSD,
+  OP_MAXPS, OP_MAXPD, OP_MAXSS, OP_MAXSD,
+  OP_CMPPS, OP_CMPPD, OP_CMPSS, OP_CMPSD, // predicate in the imm8
+  OP_UNPCKLPS, OP_UNPCKLPD, OP_UNPCKHPS, OP_UNPCKHPD,
+  OP_SHUFPS, OP_SHUFPD,
+  OP_PSHUFD, OP_PSHUFHW, OP_PSHUFLW, OP_PSHUFB, OP_PALIGNR,
+  OP_PINSRW, OP_PEXTRW,
+  OP_PCMPEQB, OP_PCMPEQW, OP_PCMPEQD, OP_PMOVMSKB,
+  OP_PAND, OP_PANDN, OP_POR,
+  OP_PADDB, OP_PADDW, OP_PADDD, OP_PADDQ,
+  OP_PSUBB, OP_PSUBW, OP_PSUBD, OP_PSUBQ,
+  OP_PMULLD, OP_PMULUDQ,
+  OP_PSRLW, OP_PSRLD, OP_PSRLQ, OP_PSRLDQ,
+  OP_PSRAW, OP_PSRAD,
+  OP_PSLLW, OP_PSLLD, OP_PSLLQ, OP_PSLLDQ,
+
+  OP_VZEROUPPER, OP_VZEROALL,
+  OP_VBROADCASTSS, OP_VBROADCASTSD,
+  OP_VPBROADCASTB, OP_VPBROADCASTW, OP_VPBROADCASTD, OP_VPBROADCASTQ,
+  OP_VPERMD, OP_VPERM2F128, OP_VPERM2I128,
+  OP_VINSERTF128, OP_VEXTRACTF128, OP_VINSERTI128, OP_VEXTRACTI128,
+  OP_VFMADD132PS, OP_VFMADD132PD, OP_VFMADD132SS, OP_VFMADD132SD,
+  OP_VFMADD213PS, OP_VFMADD213PD, OP_VFMADD213SS, OP_VFMADD213SD,
+  OP_VFMADD231PS, OP_VFMADD231PD, OP_VFMADD231SS, OP_VFMADD231SD,
+  OP_VPTERNLOGD, OP_VPTERNLOGQ,
+  OP_KMOV, OP_KORTEST, // b/w/d/q suffix from vesize
+
+  OP__COUNT // sentinel: number of Op values, keep last
 } Op;
 
 
@@ -45,13 +88,31 @@ typedef enum {
   CC_S, CC_NS, CC_P, CC_NP, CC_L, CC_GE, CC_LE, CC_G
 } Cond;
 
-typedef enum { O_NONE=0, O_REG, O_IMM, O_MEM } OperandKind;
+typedef enum { O_NONE=0, O_REG, O_IMM, O_MEM, O_KREG } OperandKind;
+
+// Legacy prefixes in front of the opcode (Insn.prefixes)
+enum {
+  PFX_LOCK   = 1<<0,  // F0
+  PFX_REP    = 1<<1,  // F3
+  PFX_REPNE  = 1<<2,  // F2
+  PFX_OPSIZE = 1<<3,  // 66
+  PFX_ADDR   = 1<<4,  // 67
+  PFX_FS     = 1<<5,  // 64
+  PFX_GS     = 1<<6,  // 65
+  PFX_SEG    = 1<<7   // 2E/36/3E/26 (branch hints in 64-bit code)
+};
+
+// Register numbers the analyses single out (Operand.reg, mem.base)
+enum { GPR_SP = 4, GPR_BP = 5, MEM_RIP = 16 };
+
+typedef enum { ENC_LEGACY=0, ENC_VEX, ENC_EVEX } VecEnc;
+typedef enum { VK_NONE=0, VK_SCALAR, VK_PACKED } VecKind;
 
 typedef struct {
   OperandKind kind;
-  uint8_t width; // bits: 8/16/32/64
+  uint16_t width; // bits: 8/16/32/64, vector 128/256/512
   union {
-    uint8_t reg;      // 0..15 (or 16 for RIP in our printer)
+    uint8_t reg;      // 0..15 (or 16 for RIP in our printer), vector 0..31, k0..k7
     int64_t imm;
     struct {
       uint8_t base;   // 0..16, or 0xFF none
@@ -68,9 +129,12 @@ typedef struct {
   uint8_t bytes[16];
   uint8_t bytes_len;
 
+  uint8_t prefixes; // PFX_*
+  uint8_t rex;      // REX byte, 0 = none
+
   Op op;
   uint8_t op_count;
-  Operand ops[3];
+  Operand ops[4];
 
   uint8_t has_cc;
   Cond cc;
@@ -78,4 +142,14 @@ typedef struct {
   uint8_t has_rel;
   int64_t rel;
   uint8_t rel_width;
+
+  // SIMD: encoding, kind and vector length in bits (0 for scalar/GPR ops)
+  uint8_t  enc;     // VecEnc
+  uint8_t  vkind;   // VecKind
+  uint16_t vl;
+  uint8_t  vesize;  // element bytes
+  uint8_t  vw;      // VEX/EVEX.W
+  uint8_t  kmask;   // EVEX {k1..k7}, 0 = unmasked
+  uint8_t  zeroing; // EVEX {z}
+  uint8_t  bcast;   // EVEX {1toN} on the memory operand, 0 = none
 } Insn;
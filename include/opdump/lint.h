@@ -0,0 +1,22 @@
+#pragma once
+#include <stdio.h>
+#include "image.h"
+#include "samples.h"
+
+/*
+ * Performance lint: encodings known to cost cycles, found in one decode
+ * pass per function.
+ *
+ *   lcp       66 prefix with a 16-bit immediate (length-changing prefix)
+ *   lock      lock-prefixed read-modify-write
+ *   div       div / idiv
+ *   partial   8/16-bit register write, then a 32/64-bit read
+ *   leave     leave (3 uops on Intel)
+ *   lea3      lea with base, index and displacement
+ *   indirect  call / jmp through memory
+ *
+ * One row per finding (address, rule, function+offset, instruction), then
+ * one summary row per rule. With samples, "lock" only reports functions
+ * that were sampled.
+ */
+void lint_report(FILE *out, const Image *img, const SampleIndex *smp, const char *label);
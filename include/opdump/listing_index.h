@@ -0,0 +1,47 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "elf_sym.h"
+
+/*
+ * Sidecar index of a listing: address -> byte offset of its line.
+ *
+ * Entries are taken at every function start and every `stride`
+ * instructions in between, in listing (= address) order. On disk:
+ *   "OPDIDX1\n", u32 stride, u32 0, u64 listing bytes, u64 count,
+ *   then count x { u64 addr, u64 offset }, all little-endian.
+ */
+typedef struct {
+  uint64_t addr;
+  uint64_t off;
+} IndexEntry;
+
+typedef struct {
+  IndexEntry *v;
+  size_t n, cap;
+  unsigned stride;
+  uint64_t since;       // instructions since the last entry
+  const ElfSym *syms;   // function starts, sorted
+  size_t nsyms, next;
+} ListingIndex;
+
+void listing_index_init(ListingIndex *ix, unsigned stride, const ElfSym *syms, size_t nsyms);
+void listing_index_free(ListingIndex *ix);
+
+/**
+ * Call with the address of every instruction before its line is written to
+ * out; out must be seekable (ftello is only asked when an entry is taken).
+ */
+void listing_index_insn(ListingIndex *ix, FILE *out, uint64_t addr);
+
+// listing_size: final size of the listing, checked by listing_lookup. Returns 1 on success.
+int listing_index_write(const char *path, const ListingIndex *ix, uint64_t listing_size);
+
+/**
+ * Prints the listing from the line of the instruction holding addr, for
+ * max_lines lines or, when stop is not UINT64_MAX, up to address stop.
+ * index_path NULL means "<listing>.idx". Returns the exit status.
+ */
+int listing_lookup(FILE *out, const char *listing, const char *index_path, uint64_t addr,
+                   uint64_t stop, size_t max_lines);
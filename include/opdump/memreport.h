@@ -0,0 +1,29 @@
+#pragma once
+#include <stdio.h>
+#include "image.h"
+
+/*
+ * Memory-access patterns per loop and per function, from one decode pass
+ * per function.
+ *
+ * Every memory operand (and the implicit stack access of push, pop, call
+ * and ret) is put in one class:
+ *
+ *   rip     RIP-relative: a constant address
+ *   stack   rsp / rbp base without an index
+ *   gather  index register holding a loaded value (a[b[i]])
+ *   chase   base register holding a loaded value (p = p->next)
+ *   stride  base or index that moves by a constant per iteration, or any
+ *           other indexed access
+ *   other   loop-invariant or unknown base
+ *
+ * "Loaded" follows register copies and arithmetic, and a loop body is
+ * walked twice so values loaded late in one iteration count in the next.
+ * A loop is flagged "chase" when a register's next value is loaded through
+ * an address derived from its own value (loop-carried pointer chasing).
+ *
+ * Loop rows count one iteration; strides are bytes per iteration. The
+ * function row covers every instruction once and lists the strides of its
+ * loops.
+ */
+void mem_report(FILE *out, const Image *img, const char *label);
@@ -26,12 +26,64 @@ enum {
 
   OF_SETCC       = 1<<8,  // 0F 90..9F /r
   OF_BYTE        = 1<<9,  // force width=8 for ModRM instruction
-  OF_GRP_C6      = 1<<10, // C6 /0: mov r/m8, imm8
+  OF_GRP_C6      = 1<<10, // C6/C7 /0: mov r/m, imm8/16/32
 
   OF_PFX66       = 1<<11,
 
-  OF_GRP_FF      = 1<<12  // FF /2 call r/m64, /4 jmp r/m64
+  OF_GRP_FF      = 1<<12, // FF /2 call r/m64, /4 jmp r/m64
+
+  OF_GRP_F7      = 1<<13, // F6/F7 /0 /1 test r/m, imm; /6 div, /7 idiv
+  OF_ACC_IMM     = 1<<14, // op al/ax/eax/rax, imm (05 0D 25 2D 35 3D A9)
+  OF_IMUL_IMM    = 1<<15  // 69 imul r, r/m, imm16/32; 6B imm8
 };
 
 extern const OpEntry g_ops[];
 extern const unsigned g_ops_count;
+
+// SSE / VEX / EVEX opcode table. Legacy SSE encodings use the same rows,
+// selected by the mandatory prefix (66/F3/F2) and the 0F / 0F38 / 0F3A map.
+typedef enum { VM_0F=1, VM_0F38=2, VM_0F3A=3 } VecMap;
+typedef enum { VP_NP=0, VP_66=1, VP_F3=2, VP_F2=3 } VecPfx;
+typedef enum { VW_0=0, VW_1=1, VW_ANY=2 } VecW;
+
+typedef enum {
+  VF_NONE,  // no operands (vzeroupper)
+  VF_RM,    // reg, r/m
+  VF_MR,    // r/m, reg
+  VF_RVM,   // reg, vvvv, r/m  (legacy: reg, r/m)
+  VF_RMI,   // reg, r/m, imm8
+  VF_MRI,   // r/m, reg, imm8
+  VF_RVMI,  // reg, vvvv, r/m, imm8
+  VF_VMI    // vvvv, r/m, imm8  (legacy: r/m, imm8)
+} VecForm;
+
+enum {
+  VX_NONE      = 0,
+  VX_VEX_ONLY  = 1<<0,  // no legacy SSE encoding
+  VX_NO_EVEX   = 1<<1,  // no EVEX encoding
+  VX_EVEX_ONLY = 1<<2,
+  VX_SCALAR    = 1<<3,  // scalar element op: xmm regs, element-sized memory
+  VX_MERGE_REG = 1<<4,  // movss/movsd: register form takes vvvv as well
+  VX_ESIZE_W   = 1<<5,  // element size from W (4/8) instead of esize
+  VX_RM_X128   = 1<<6,  // r/m is always xmm / 16 bytes (inserts, extracts)
+  VX_BCAST_SRC = 1<<7,  // broadcast source: r/m is xmm / one element
+  VX_RM_GPR    = 1<<8,  // r/m is a general register (W selects 32/64)
+  VX_REG_GPR   = 1<<9,  // reg is a general register
+  VX_RM_K      = 1<<10, // r/m is a mask register
+  VX_REG_K     = 1<<11, // reg is a mask register
+  VX_GRP_SHIFT = 1<<12  // 0F 71-73 shift by imm8: ModRM.reg selects the op
+};
+
+typedef struct {
+  uint8_t  map;    // VecMap
+  uint8_t  opc;
+  uint8_t  pp;     // VecPfx
+  uint8_t  w;      // VecW
+  Op       op;
+  uint8_t  form;   // VecForm
+  uint8_t  esize;  // element bytes
+  uint16_t flags;  // VX_*
+} VecEntry;
+
+extern const VecEntry g_vops[];
+extern const unsigned g_vops_count;
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdio.h>
+#include "image.h"
+#include "samples.h"
+
+/*
+ * Code layout across 4 KiB and 2 MiB pages.
+ *
+ * One row per page of every executable segment: code bytes, padding
+ * (nop / int3 / zero fill) and the functions living there; with samples,
+ * the page's share of the weight. Then, per page size, the smallest set of
+ * pages holding cover_pct percent of the sampled weight inside the code.
+ */
+void page_map(FILE *out, const Image *img, const SampleIndex *smp, double cover_pct,
+              const char *label);
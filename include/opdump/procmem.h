@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// One executable mapping from /proc/PID/maps.
+typedef struct {
+  uint64_t start, end;
+  uint64_t offset;     // file offset of start
+  char path[256];      // backing file, "[vdso]", or "" for anonymous memory
+} ProcMap;
+
+/**
+ * Executable mappings of a live process (the /proc analogue of
+ * elf64_collect_exec_segments). Returns the count, or (size_t)-1 when
+ * /proc/PID/maps cannot be read; *out is malloc'd.
+ */
+size_t proc_exec_maps(int pid, ProcMap **out);
+
+/**
+ * Copies [addr, addr+len) of the process into buf with batched
+ * process_vm_readv calls (falling back to /proc/PID/mem). Unreadable pages
+ * are zero-filled. Returns the number of bytes actually read.
+ */
+size_t proc_read(int pid, uint64_t addr, size_t len, uint8_t *buf);
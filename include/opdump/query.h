@@ -0,0 +1,53 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "insn.h"
+
+/*
+ * Instruction query language, compiled once and evaluated per Insn.
+ *
+ *   query := expr ( ('then' | 'within' N) expr )*
+ *   expr  := term ( ('||' | 'or') term )*
+ *   term  := unary ( ('&&' | 'and') unary )*
+ *   unary := ('!' | 'not') unary | '(' expr ')' | field [ cmp value ]
+ *   cmp   := '=' | '==' | '!=' | '<' | '<=' | '>' | '>='
+ *
+ * Fields: op, cc, size, nops, rel (flag), mem (flag: has memory operand) and
+ * per operand <sel>.{kind,width,reg,base,index,scale,disp,imm} where sel is
+ * dst/o0, src/o1, o2, o3, or mem (the memory operand, if any).
+ * Names: op=mov, op=jcc, op=je (op+cc), kind=mem|kreg, base=rip, index=none.
+ *
+ * 'then' requires the next step on the following instruction,
+ * 'within N' on one of the next N instructions.
+ *
+ * Examples:
+ *   op=mov && src.base=rip
+ *   mem.index!=none && mem.scale=8
+ *   op=cmovcc within 3 op=jcc
+ */
+
+enum { QUERY_MAX_STEPS = 8, QUERY_MAX_WINDOW = 64 };
+
+typedef struct Query Query;
+
+// Returns NULL on error, with a message in err.
+Query* query_compile(const char *src, char *err, size_t errcap);
+void   query_free(Query *q);
+
+// Upper bound of instructions covered by one match (first..last inclusive).
+unsigned query_span(const Query *q);
+
+typedef struct {
+  uint64_t seq;                          // stream index of the next instruction
+  int64_t  at[QUERY_MAX_STEPS];          // where prefix 0..j last matched, -1 none
+  int64_t  start[QUERY_MAX_STEPS];       // first instruction of that prefix
+} QueryCursor;
+
+void query_cursor_init(QueryCursor *c);
+
+// Called for each full match with stream indexes of its first/last instruction.
+typedef void (*QueryHitFn)(void *user, uint64_t first, uint64_t last);
+
+// Feeds a batch of consecutive instructions. Returns the number of matches.
+size_t query_feed(const Query *q, QueryCursor *c, const Insn *ins, size_t count,
+                  QueryHitFn hit, void *user);
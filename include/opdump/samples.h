@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Instruction-pointer samples aggregated into a sorted address index.
+ *
+ * Accepted line formats (blank lines and '#' comments are skipped):
+ *   ADDR [COUNT]                       hex address, optional decimal count
+ *   perf script (default fields)       "comm pid [cpu] time: period event: IP sym (dso)"
+ *   perf script -F ip[,sym,...]        "IP sym+off (dso)"
+ */
+typedef struct {
+  uint64_t *addr;   // sorted, unique
+  uint64_t *count;
+  size_t n;
+  uint64_t total;
+} SampleIndex;
+
+// Returns 1 on success. path "-" reads stdin.
+int  samples_load(const char *path, SampleIndex *out);
+void samples_free(SampleIndex *s);
+
+// First entry with addr >= a.
+size_t samples_lower_bound(const SampleIndex *s, uint64_t a);
+
+// Sum of counts in [a0, a1).
+uint64_t samples_range(const SampleIndex *s, uint64_t a0, uint64_t a1);
+
+// Indexes of the k heaviest addresses, heaviest first. Returns how many.
+size_t samples_top(const SampleIndex *s, size_t k, size_t *out);
@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+
+/*
+ * Resident disassembly server on a Unix stream socket.
+ *
+ * Binaries stay mapped with their segment and symbol indexes in an LRU
+ * cache keyed by path + inode + mtime (a rebuilt file is reloaded). Worker
+ * threads each serve one connection at a time; a connection carries any
+ * number of requests, one per line:
+ *
+ *   range PATH START END     instructions in [START, END) (hex addresses)
+ *   sym   PATH NAME          the whole function NAME
+ *   addr  PATH ADDR [N]      symbol+offset of ADDR, then N instructions (1)
+ *                            from the instruction containing ADDR
+ *   stats                    cache entries, hits, misses
+ *
+ * Every reply is "ok" or "err MESSAGE", listing lines, then a line ".".
+ */
+
+typedef struct {
+  size_t cache_entries;  // binaries kept mapped
+  size_t threads;        // worker threads
+} ServeOptions;
+
+// Runs until the process is killed. Returns nonzero if the socket cannot be set up.
+int serve(const char *sock_path, const ServeOptions *opt);
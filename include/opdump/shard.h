@@ -0,0 +1,43 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "image.h"
+
+/*
+ * Listing a large set of binaries as independent shards.
+ *
+ * shard_plan cuts the executable segments of the inputs into pieces so
+ * that each of N shards gets about the same number of bytes; cuts inside a
+ * segment move to the nearest function start. The manifest is text:
+ *
+ *   # opdump plan v1
+ *   plan ID shards N files F pieces P bytes B
+ *   file I SIZE PATH
+ *   piece P SHARD FILE SEG START END      (START/END: hex addresses)
+ *   shard K BYTES PIECES
+ *
+ * ID is an FNV-1a hash of the file and piece lines. shard_run resyncs every
+ * piece against the linear sweep of its segment (boundary.h), so a piece
+ * holds exactly the instructions that start inside it; its output is
+ * "#@ plan ID shard K", then "#@ piece P" before each piece's listing.
+ * shard_merge puts the pieces of all shard outputs back in plan order,
+ * which reproduces the listing of a single run over the same inputs.
+ */
+
+// Writes the manifest. Archives are rejected. Returns 0 or an IMG_ERR_* code.
+int shard_plan(FILE *out, const char *const *paths, size_t npaths, size_t nshards);
+
+// Lists [off0, off1) of seg (file offsets, on instruction boundaries).
+typedef void (*ShardDumpFn)(FILE *out, const Image *img, const ElfExecSeg *seg,
+                            uint64_t off0, uint64_t off1, void *user);
+
+// Runs the pieces of shard k. Returns 0, 1 for a bad manifest, or an IMG_ERR_* code.
+int shard_run(FILE *out, const char *manifest, size_t k, ShardDumpFn fn, void *user);
+
+/**
+ * Writes the pieces found in the shard outputs in plan order, with the
+ * "path:" headers of a multi-file run, and a "# merged ..." line to stderr.
+ * Every piece must appear exactly once. Returns 0, 1 or IMG_ERR_READ.
+ */
+int shard_merge(FILE *out, const char *manifest, const char *const *outputs, size_t noutputs);
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdio.h>
+#include "image.h"
+#include "samples.h"
+
+/*
+ * Register spills inside loops, from one decode pass per function.
+ *
+ * A stack slot is [rsp+X] or [rbp+X] without an index, written or read by
+ * a plain register move (mov and the SSE/AVX moves). A spill is a store to
+ * a slot the function also reads; a reload is a read of a slot the
+ * function also writes (incoming stack arguments are neither). Per loop
+ * (backward-branch region): spills, reloads, slots both spilled and
+ * reloaded inside the loop (pairs), and density = (spills + reloads) /
+ * instructions.
+ *
+ * Loops are ranked by density, or with samples by density times the
+ * loop's share of all samples; then one row per function with spilling
+ * loops and a totals line.
+ */
+void spill_report(FILE *out, const Image *img, const SampleIndex *smp, const char *label);
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include "insn.h"
+#include "image.h"
+
+// Per-region SIMD usage: scalar FP (ss/sd) vs packed ops by vector length.
+typedef struct {
+  uint64_t insns;
+  uint64_t scalar;
+  uint64_t xmm;   // SSE / VEX.128 / EVEX.128
+  uint64_t ymm;   // AVX / AVX2 / EVEX.256
+  uint64_t zmm;   // AVX-512
+} VecStats;
+
+void vec_stats_add(VecStats *st, const Insn *in);
+
+// Widest class in use: "avx512", "avx2", "sse", "scalar" or "none".
+const char* vec_stats_width(const VecStats *st);
+
+/**
+ * Prints one line per function (or unnamed region) that executes any
+ * scalar or packed FP/SIMD instruction, then a total line.
+ */
+void vector_report(FILE *out, const Image *img, const char *label);
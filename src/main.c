@@ -1,104 +1,1053 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "opdump/elf64.h"
+#include "opdump/image.h"
 #include "opdump/decode.h"
 #include "opdump/format.h"   // format_intel(...)
 #include "opdump/insn.h"
+#include "opdump/query.h"
+#include "opdump/vecreport.h"
+#include "opdump/samples.h"
+#include "opdump/align.h"
+#include "opdump/cost.h"
+#include "opdump/footprint.h"
+#include "opdump/codediff.h"
+#include "opdump/pagemap.h"
+#include "opdump/serve.h"
+#include "opdump/addrs.h"
+#include "opdump/procmem.h"
+#include "opdump/dwarf_line.h"
+#include "opdump/lint.h"
+#include "opdump/archive.h"
+#include "opdump/listing_index.h"
+#include "opdump/dupreport.h"
+#include "opdump/callgraph.h"
+#include "opdump/boundary.h"
+#include "opdump/arena.h"
+#include "opdump/shard.h"
+#include "opdump/memreport.h"
+#include "opdump/spills.h"
+#include "opdump/core.h"
+#include "opdump/datascan.h"
 
-static int read_all(const char *path, uint8_t **out_buf, size_t *out_sz) {
-  *out_buf = NULL; *out_sz = 0;
-  FILE *f = fopen(path, "rb");
-  if (!f) return 0;
-  if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return 0; }
-  long len = ftell(f);
-  if (len < 0) { fclose(f); return 0; }
-  if (fseek(f, 0, SEEK_SET) != 0) { fclose(f); return 0; }
+// Sample column: share of all samples landing inside the instruction.
+static void print_sample_col(FILE *out, const SampleIndex *smp, size_t *k, uint64_t addr,
+                             uint64_t size) {
+  uint64_t hits = 0;
+  while (*k < smp->n && smp->addr[*k] < addr) (*k)++;
+  while (*k < smp->n && smp->addr[*k] < addr + size) hits += smp->count[(*k)++];
 
-  uint8_t *buf = (uint8_t*)malloc((size_t)len);
-  if (!buf) { fclose(f); return 0; }
+  if (hits) fprintf(out, "%6.2f%%  ", 100.0 * (double)hits / (double)smp->total);
+  else      fprintf(out, "         ");
+}
 
-  size_t got = fread(buf, 1, (size_t)len, f);
-  fclose(f);
-  if (got != (size_t)len) { free(buf); return 0; }
+// "; file:line" whenever the source line changes.
+static void print_line_col(FILE *out, const LineTable *lt, size_t *cur, uint64_t addr,
+                           const LineRow **last) {
+  const LineRow *r = line_table_at(lt, cur, addr);
+  if (!r || (*last && (*last)->file == r->file && (*last)->line == r->line)) return;
+  const LineFile *f = &lt->files[r->file];
+  if (f->dir) fprintf(out, "; %s/%s:%u\n", f->dir, f->name, (unsigned)r->line);
+  else        fprintf(out, "; %s:%u\n", f->name, (unsigned)r->line);
+  *last = r;
+}
 
-  *out_buf = buf;
-  *out_sz = (size_t)len;
-  return 1;
+// "; R_X86_64_PLT32 foo-0x4" for each relocation inside [addr, addr+size).
+static void print_reloc_col(FILE *out, const ElfReloc *rel, size_t nrel, size_t *k,
+                            uint64_t addr, uint64_t size) {
+  while (*k < nrel && rel[*k].addr < addr) (*k)++;
+  for (; *k < nrel && rel[*k].addr < addr + size; (*k)++) {
+    const ElfReloc *r = &rel[*k];
+    fprintf(out, "; %s %s", elf_rel_type_name(r->type), r->sym[0] ? r->sym : "*ABS*");
+    if (r->addend < 0)      fprintf(out, "-0x%llx", (unsigned long long)-(uint64_t)r->addend);
+    else if (r->addend > 0) fprintf(out, "+0x%llx", (unsigned long long)r->addend);
+    fprintf(out, "\n");
+  }
 }
 
-static void dump_segment(const uint8_t *buf, size_t n, const ElfExecSeg *seg) {
-  const uint64_t off0 = seg->offset;
-  const uint64_t off1 = seg->offset + seg->filesz;
+// Per-instruction annotations of a listing; any of them may be NULL / 0.
+typedef struct {
+  const SampleIndex *smp;
+  const LineTable *lines;
+  const ElfReloc *rel;
+  size_t nrel;
+  ListingIndex *idx;   // --index-out
+  const DataRange *data;   // --data-scan, sorted
+  size_t ndata;
+} Annot;
+
+enum { DATA_LINE = 12 };
+
+// [off0, off1) of a data range as hex, DATA_LINE bytes per line; a header
+// names the kind where the range starts.
+static void dump_data(FILE *out, const uint8_t *buf, const ElfExecSeg *seg, uint64_t off0,
+                      uint64_t off1, const DataRange *r, const Annot *an, size_t *k, size_t *rk) {
+  uint64_t a0 = seg->vaddr + (off0 - seg->offset);
+  if (a0 == r->addr) {
+    fprintf(out, "; data: %s, %llu bytes\n", data_kind_name(r->kind),
+      (unsigned long long)(r->end - r->addr));
+  }
+  for (uint64_t off = off0; off < off1; off += DATA_LINE) {
+    uint64_t addr = seg->vaddr + (off - seg->offset);
+    size_t len = off1 - off < DATA_LINE ? (size_t)(off1 - off) : DATA_LINE;
+    if (an->idx) listing_index_insn(an->idx, out, addr);
+    if (an->smp) print_sample_col(out, an->smp, k, addr, len);
+    char hex[DATA_LINE * 3 + 1];
+    for (size_t i = 0; i < len; i++) snprintf(hex + 3 * i, 4, "%02x ", buf[off + i]);
+    hex[3 * len - 1] = 0;
+    fprintf(out, "%016llx  %-36s db\n", (unsigned long long)addr, hex);
+    if (an->nrel) print_reloc_col(out, an->rel, an->nrel, rk, addr, len);
+  }
+}
 
+static void dump_range(FILE *out, const uint8_t *buf, const ElfExecSeg *seg, uint64_t off0,
+                       uint64_t off1, const Annot *an) {
   DecodeCtx ctx = {0};
   ctx.is64 = 1;
 
+  const SampleIndex *smp = an->smp;
+  uint64_t a0 = seg->vaddr + (off0 - seg->offset);
+  size_t k = smp ? samples_lower_bound(smp, a0) : 0;
+  size_t lc = an->lines ? line_table_seek(an->lines, a0) : 0;
+  size_t rk = an->nrel ? elf_rel_lower_bound(an->rel, an->nrel, a0) : 0;
+  const LineRow *last_line = NULL;
+  size_t dk = 0;
+  while (dk < an->ndata && an->data[dk].end <= a0) dk++;
+
   uint64_t cursor = off0;
   while (cursor < off1) {
-    uint64_t addr = seg->vaddr + (cursor - off0);
+    uint64_t addr = seg->vaddr + (cursor - seg->offset);
+    // data ranges are listed as hex; decoding stops short of the next one
+    uint64_t limit = off1;
+    if (dk < an->ndata) {
+      const DataRange *r = &an->data[dk];
+      if (r->addr <= addr) {
+        uint64_t end = seg->offset + (r->end - seg->vaddr);
+        if (end > off1) end = off1;
+        dump_data(out, buf, seg, cursor, end, r, an, &k, &rk);
+        cursor = end;
+        dk++;
+        continue;
+      }
+      uint64_t start = seg->offset + (r->addr - seg->vaddr);
+      if (start < limit) limit = start;
+    }
+    if (an->idx) listing_index_insn(an->idx, out, addr);
+    if (an->lines) print_line_col(out, an->lines, &lc, addr, &last_line);
 
     Insn ins;
-    size_t remain = (size_t)(off1 - cursor);
+    size_t remain = (size_t)(limit - cursor);
     size_t used = decode_one(&ctx, buf + cursor, remain, addr, &ins);
 
     if (used == 0) {
       // fallback safe: emit db for 1 byte to avoid infinite loop
-      printf("%016llx  %02x                      db\n",
+      if (smp) print_sample_col(out, smp, &k, addr, 1);
+      fprintf(out, "%016llx  %02x                      db\n",
         (unsigned long long)addr, (unsigned)buf[cursor]);
       cursor += 1;
       continue;
     }
 
-    // print bytes (up to 16)
-    printf("%016llx  ", (unsigned long long)ins.addr);
-    for (uint8_t i = 0; i < ins.bytes_len; i++) {
-      printf("%02x ", (unsigned)ins.bytes[i]);
+    if (smp) print_sample_col(out, smp, &k, addr, used);
+    format_line(out, &ins);
+    if (an->nrel) print_reloc_col(out, an->rel, an->nrel, &rk, addr, used);
+
+    cursor += used;
+  }
+}
+
+// --shard: one piece of a plan, with the annotations of a plain listing.
+static void dump_piece(FILE *out, const Image *img, const ElfExecSeg *seg, uint64_t off0,
+                       uint64_t off1, void *user) {
+  Annot an = { (const SampleIndex*)user, NULL, img->relocs, img->reloc_count, NULL, NULL, 0 };
+  dump_range(out, img->buf, seg, off0, off1, &an);
+}
+
+static void dump_segment(FILE *out, const uint8_t *buf, const ElfExecSeg *seg,
+                         const SampleIndex *smp) {
+  Annot an = { smp, NULL, NULL, 0, NULL, NULL, 0 };
+  dump_range(out, buf, seg, seg->offset, seg->offset + seg->filesz, &an);
+}
+
+typedef struct {
+  uint64_t a0, a1;   // address window
+  size_t seg;
+  const char *name;  // containing function, if known
+} HotWindow;
+
+static int cmp_hot(const void *a, const void *b) {
+  const HotWindow *x = (const HotWindow*)a, *y = (const HotWindow*)b;
+  return (x->a0 > y->a0) - (x->a0 < y->a0);
+}
+
+enum { HOT_CONTEXT = 256 };
+
+// Decodes only the functions (or +-HOT_CONTEXT bytes without symbols)
+// around the top sampled addresses, merged and in address order.
+static void dump_hot(FILE *out, const Image *img, size_t top, const Annot *an) {
+  const SampleIndex *smp = an->smp;
+  size_t *idx = (size_t*)malloc((top ? top : 1) * sizeof(size_t));
+  HotWindow *w = (HotWindow*)malloc((top ? top : 1) * sizeof(HotWindow));
+  if (!idx || !w) { free(idx); free(w); return; }
+
+  size_t nt = samples_top(smp, top, idx);
+  size_t nw = 0;
+  for (size_t t = 0; t < nt; t++) {
+    uint64_t a = smp->addr[idx[t]];
+    for (size_t s = 0; s < img->seg_count; s++) {
+      const ElfExecSeg *seg = &img->segs[s];
+      if (a < seg->vaddr || a >= seg->vaddr + seg->filesz) continue;
+
+      const ElfSym *sym = elf_sym_lookup(img->syms, img->sym_count, a);
+      HotWindow *h = &w[nw++];
+      h->seg = s;
+      h->name = sym ? sym->name : NULL;
+      h->a0 = sym ? sym->addr : (a > seg->vaddr + HOT_CONTEXT ? a - HOT_CONTEXT : seg->vaddr);
+      h->a1 = sym ? sym->addr + sym->size : a + HOT_CONTEXT;
+      if (h->a0 < seg->vaddr) h->a0 = seg->vaddr;
+      if (h->a1 > seg->vaddr + seg->filesz) h->a1 = seg->vaddr + seg->filesz;
+      break;
     }
-    // simple padding
-    for (uint8_t i = ins.bytes_len; i < 12; i++) printf("   ");
+  }
 
-    format_intel(stdout, &ins);
-    printf("\n");
+  qsort(w, nw, sizeof(HotWindow), cmp_hot);
+  for (size_t i = 0; i < nw; i++) {
+    HotWindow h = w[i];
+    int more = 0;
+    while (i + 1 < nw && w[i + 1].seg == h.seg && w[i + 1].a0 <= h.a1) {
+      if (w[i + 1].a1 > h.a1) h.a1 = w[i + 1].a1;
+      if (w[i + 1].name != h.name) more = 1;
+      i++;
+    }
 
-    cursor += used;
+    const ElfExecSeg *seg = &img->segs[h.seg];
+    uint64_t hits = samples_range(smp, h.a0, h.a1);
+    fprintf(out, "\n; %s%s [%016llx, %016llx)  %.2f%% of samples\n",
+      h.name ? h.name : "<no symbol>", more ? " .." : "",
+      (unsigned long long)h.a0, (unsigned long long)h.a1,
+      100.0 * (double)hits / (double)smp->total);
+    dump_range(out, img->buf, seg, seg->offset + (h.a0 - seg->vaddr),
+               seg->offset + (h.a1 - seg->vaddr), an);
   }
+
+  free(idx);
+  free(w);
 }
 
-int main(int argc, char **argv) {
-  if (argc < 2) {
-    fprintf(stderr, "usage: %s <elf>\n", argv[0]);
-    return 1;
+// Function symbols of the ELF behind a file mapping of [start, ...) from
+// file offset `offset`, moved to where the mapping puts them. Returns the
+// count; *out is allocated in a.
+static size_t mapping_symbols(const char *path, uint64_t start, uint64_t offset, Image *img,
+                              Arena *a, ElfSym **out) {
+  *out = NULL;
+  if (path[0] != '/' || image_map(path, img) != IMG_OK) return 0;
+  image_load_symbols(img);
+
+  // file offset X is vaddr X + (p_vaddr - p_offset) in the segment holding it
+  const ElfExecSeg *seg = NULL;
+  for (size_t s = 0; s < img->seg_count; s++) {
+    uint64_t lo = img->segs[s].offset & ~(uint64_t)0xFFF;
+    if (offset >= lo && offset < img->segs[s].offset + img->segs[s].filesz) seg = &img->segs[s];
   }
+  if (!seg || img->sym_count == 0) return 0;
+  ElfSym *v = (ElfSym*)arena_alloc(a, img->sym_count * sizeof(ElfSym));
+  if (!v) return 0;
+
+  uint64_t bias = start - (offset + seg->vaddr - seg->offset);
+  for (size_t i = 0; i < img->sym_count; i++) {
+    v[i] = img->syms[i];
+    v[i].addr += bias;
+  }
+  *out = v;
+  return img->sym_count;
+}
 
-  uint8_t *buf = NULL;
-  size_t n = 0;
-  if (!read_all(argv[1], &buf, &n)) {
-    fprintf(stderr, "Error: cannot read file\n");
+// Every executable mapping of a live process, read in large batches; file
+// mappings get "; function" headers from their ELF symbols.
+static int dump_process(int pid, const SampleIndex *smp) {
+  ProcMap *maps = NULL;
+  size_t nm = proc_exec_maps(pid, &maps);
+  if (nm == (size_t)-1) {
+    fprintf(stderr, "Error: pid %d: cannot read /proc/%d/maps\n", pid, pid);
     return 2;
   }
 
-  ElfInfo info;
-  if (!elf64_parse_info(buf, n, &info)) {
-    fprintf(stderr, "Error: not supported ELF64 (LE)\n");
-    free(buf);
-    return 3;
+  Arena *sa = arena_thread();
+  for (size_t i = 0; i < nm; i++) {
+    const ProcMap *m = &maps[i];
+    size_t len = (size_t)(m->end - m->start);
+    ArenaMark mark = arena_mark(sa);
+    uint8_t *buf = (uint8_t*)arena_alloc(sa, len);
+    if (!buf) continue;
+
+    printf("%s%016llx-%016llx %s\n", i ? "\n" : "", (unsigned long long)m->start,
+      (unsigned long long)m->end, m->path[0] ? m->path : "[anon]");
+    if (proc_read(pid, m->start, len, buf) == 0) {
+      printf("; unreadable\n");
+      arena_reset(sa, mark);
+      continue;
+    }
+
+    ElfExecSeg seg = { m->start, len, len, 0, 0, 0 };
+    Image img;
+    memset(&img, 0, sizeof(img));
+    ElfSym *syms = NULL;
+    size_t ns = mapping_symbols(m->path, m->start, m->offset, &img, sa, &syms);
+    if (ns == 0) {
+      dump_segment(stdout, buf, &seg, smp);
+    } else {
+      Region *regs = NULL;
+      size_t nr = elf_split_regions(&seg, syms, ns, sa, &regs);
+      Annot an = { smp, NULL, NULL, 0, NULL, NULL, 0 };
+      for (size_t r = 0; r < nr; r++) {
+        if (regs[r].name) printf("; %s\n", regs[r].name);
+        dump_range(stdout, buf, &seg, regs[r].offset, regs[r].offset + regs[r].size, &an);
+      }
+    }
+    image_free(&img);
+    arena_reset(sa, mark);
+  }
+  free(maps);
+  return 0;
+}
+
+enum { QUERY_BATCH = 4096, LOOKUP_LINES = 32 };
+
+typedef struct {
+  FILE *out;
+  const char *label;   // file name prefix, NULL for a single input
+  const Insn *win;     // win[0] is stream index win_seq
+  uint64_t win_seq;
+} QueryOut;
+
+static void on_query_hit(void *user, uint64_t first, uint64_t last) {
+  const QueryOut *qo = (const QueryOut*)user;
+  if (first != last) fprintf(qo->out, "--\n");
+  for (uint64_t s = first; s <= last; s++) {
+    if (qo->label) fprintf(qo->out, "%s: ", qo->label);
+    format_line(qo->out, &qo->win[s - qo->win_seq]);
+  }
+}
+
+// Decodes in batches; the last span-1 instructions of each batch are kept in
+// front of the next one so sequence matches can be printed across batches.
+static size_t query_segment(FILE *out, const Query *q, Insn *win, const uint8_t *buf,
+                            const ElfExecSeg *seg, const char *label) {
+  const size_t keep = query_span(q) - 1;
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  QueryCursor cur;
+  query_cursor_init(&cur);
+  QueryOut qo = { out, label, win, 0 };
+
+  size_t hits = 0, have = 0;
+  uint64_t off = 0;
+  while (off < seg->filesz) {
+    size_t used = 0;
+    size_t got = decode_batch(&ctx, buf + seg->offset + off, (size_t)(seg->filesz - off),
+                              seg->vaddr + off, win + have, QUERY_BATCH, &used);
+    qo.win_seq = cur.seq - have;
+    hits += query_feed(q, &cur, win + have, got, on_query_hit, &qo);
+    off += used;
+
+    size_t total = have + got;
+    size_t next = total < keep ? total : keep;
+    memmove(win, win + (total - next), next * sizeof(Insn));
+    have = next;
+  }
+  return hits;
+}
+
+// What to do with every input image; filled in from the command line.
+typedef struct {
+  const Query *q;
+  const SampleIndex *smp;
+  const SampleIndex *addrs;   // --addrs, or NULL
+  const UarchProfile *prof;
+  int vec_report, align_rep, cost, footprint, csv, page_rep, lint, mem_rep, spills, show_lines;
+  unsigned loop_align;
+  FootSort fp_key;
+  CgFormat callgraph;
+  size_t threads;             // --callgraph decoding
+  double cover_pct;
+  size_t hot_top;
+  uint64_t start, stop;
+  int crash;                  // core files: only around the crashing pc
+  int data_scan;              // list data in code as hex, stats to stderr
+  ListingIndex *idx;          // --index-out, or NULL
+} RunOptions;
+
+// --start inside a function: the instruction covering addr, found by a
+// boundary sweep from the function start.
+static uint64_t sync_start(Image *img, const ElfExecSeg *seg, uint64_t addr) {
+  image_load_symbols(img);
+  const ElfSym *s = elf_sym_lookup(img->syms, img->sym_count, addr);
+  if (!s || s->addr < seg->vaddr) return addr;
+  return s->addr + insn_sync(img->buf + seg->offset + (s->addr - seg->vaddr),
+                             (size_t)(seg->vaddr + seg->filesz - s->addr), (size_t)(addr - s->addr));
+}
+
+// [a0, a1) of a core mapping, from the core or its backing file; a0 inside
+// a function is synced by a sweep from the function start.
+static void dump_core_window(FILE *out, const Core *c, const CoreMap *m, const ElfSym *syms,
+                             size_t ns, uint64_t a0, uint64_t a1, const SampleIndex *smp) {
+  Arena *sa = arena_thread();
+  ArenaMark mark = arena_mark(sa);
+  const ElfSym *s = elf_sym_lookup(syms, ns, a0);
+  uint64_t from = s && s->addr >= m->start && s->addr < a0 ? s->addr : a0;
+  size_t len = (size_t)(a1 - from);
+
+  const uint8_t *buf;
+  if (from - m->start + len <= m->filesz) {
+    buf = c->buf + m->offset + (from - m->start);   // dumped: list in place
+  } else {
+    uint8_t *b = (uint8_t*)arena_alloc(sa, len);
+    size_t got = b ? core_read(c, m, from, len, b) : 0;
+    if (from + got <= a0) {
+      fprintf(out, "; not in the core%s\n", m->file ? " and backing file unreadable" : "");
+      arena_reset(sa, mark);
+      return;
+    }
+    if (got < len) {
+      fprintf(out, "; [%016llx, %016llx) missing\n", (unsigned long long)(from + got),
+        (unsigned long long)a1);
+      len = got;
+    }
+    buf = b;
+  }
+
+  ElfExecSeg seg = { from, len, len, 0, 0, 0 };
+  uint64_t off0 = from < a0 ? insn_sync(buf, len, (size_t)(a0 - from)) : 0;
+  Annot an = { smp, NULL, NULL, 0, NULL, NULL, 0 };
+  if (ns == 0) {
+    dump_range(out, buf, &seg, off0, len, &an);
+  } else {
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&seg, syms, ns, sa, &regs);
+    for (size_t r = 0; r < nr; r++) {
+      uint64_t o0 = regs[r].offset > off0 ? regs[r].offset : off0;
+      uint64_t o1 = regs[r].offset + regs[r].size;
+      if (o0 >= o1) continue;
+      if (regs[r].name) fprintf(out, "; %s\n", regs[r].name);
+      dump_range(out, buf, &seg, o0, o1, &an);
+    }
+  }
+  arena_reset(sa, mark);
+}
+
+// A core file: the registers of every thread, then its executable mappings
+// clipped to --start/--stop (or to +-HOT_CONTEXT around the crashing pc).
+// Each mapping header says where its bytes come from: core, file,
+// core+file, or partial / missing when neither has them all.
+static int dump_core(FILE *out, const char *path, const RunOptions *o, const char *label) {
+  Core c;
+  int err = core_open(path, &c);
+  if (err != IMG_OK) {
+    fprintf(stderr, "Error: %s: %s\n", path, image_strerror(err));
+    return err;
   }
 
-  ElfExecSeg segs[32];
-  size_t seg_count = elf64_collect_exec_segments(buf, n, segs, 32);
-  if (seg_count == 0) {
-    fprintf(stderr, "Error: no executable PT_LOAD segments\n");
-    free(buf);
-    return 4;
+  uint64_t w0 = o->start, w1 = o->stop;
+  if (o->crash) {
+    if (c.thread_count == 0) {
+      fprintf(stderr, "Error: %s: no thread registers (NT_PRSTATUS)\n", path);
+      core_close(&c);
+      return IMG_ERR_ELF;
+    }
+    uint64_t pc = c.threads[0].pc;
+    w0 = pc > HOT_CONTEXT ? pc - HOT_CONTEXT : 0;
+    w1 = pc + HOT_CONTEXT;
   }
 
-  for (size_t i = 0; i < seg_count && i < 32; i++) {
-    dump_segment(buf, n, &segs[i]);
+  if (label) fprintf(out, "%s:\n", label);
+  for (size_t t = 0; t < c.thread_count; t++) {
+    const CoreThread *th = &c.threads[t];
+    fprintf(out, "; thread %u pc %016llx sp %016llx", (unsigned)th->pid,
+      (unsigned long long)th->pc, (unsigned long long)th->sp);
+    if (th->signo) fprintf(out, " signal %u", (unsigned)th->signo);
+    fprintf(out, "\n");
   }
 
-  free(buf);
+  Arena *sa = arena_thread();
+  int first = c.thread_count == 0;
+  for (size_t i = 0; i < c.map_count; i++) {
+    const CoreMap *m = &c.maps[i];
+    uint64_t a0 = w0 > m->start ? w0 : m->start;
+    uint64_t a1 = w1 < m->end ? w1 : m->end;
+    if (a0 >= a1) continue;
+
+    const char *src = m->filesz == m->end - m->start ? "core"
+                    : m->file ? (m->filesz ? "core+file" : "file")
+                    : m->filesz ? "partial" : "missing";
+    fprintf(out, "%s%016llx-%016llx %s (%s)\n", first ? "" : "\n", (unsigned long long)m->start,
+      (unsigned long long)m->end, m->file ? m->file->path : "[anon]", src);
+    first = 0;
+
+    ArenaMark mark = arena_mark(sa);
+    Image img;
+    memset(&img, 0, sizeof(img));
+    ElfSym *syms = NULL;
+    size_t ns = m->file ? mapping_symbols(m->file->path, m->file->start, m->file->offset, &img,
+                                          sa, &syms) : 0;
+    dump_core_window(out, &c, m, syms, ns, a0, a1, o->smp);
+    image_free(&img);
+    arena_reset(sa, mark);
+  }
+  core_close(&c);
   return 0;
 }
+
+static void process_image(FILE *out, Image *img, const RunOptions *o, const char *label) {
+  if (o->vec_report) {
+    image_load_symbols(img);
+    vector_report(out, img, label);
+    return;
+  }
+  if (o->align_rep) {
+    image_load_symbols(img);
+    align_report(out, img, o->loop_align, label);
+    return;
+  }
+  if (o->cost) {
+    image_load_symbols(img);
+    cost_report(out, img, o->prof, label);
+    return;
+  }
+  if (o->footprint) {
+    image_load_symbols(img);
+    footprint_report(out, img, o->fp_key, o->csv, label);
+    return;
+  }
+  if (o->addrs) {
+    image_load_symbols(img);
+    addrs_report(out, img, o->addrs, label);
+    return;
+  }
+  if (o->page_rep) {
+    image_load_symbols(img);
+    page_map(out, img, o->smp, o->cover_pct, label);
+    return;
+  }
+  if (o->lint) {
+    image_load_symbols(img);
+    lint_report(out, img, o->smp, label);
+    return;
+  }
+  if (o->mem_rep) {
+    image_load_symbols(img);
+    mem_report(out, img, label);
+    return;
+  }
+  if (o->spills) {
+    image_load_symbols(img);
+    spill_report(out, img, o->smp, label);
+    return;
+  }
+  if (o->callgraph) {
+    image_load_symbols(img);
+    CallGraph cg;
+    if (!callgraph_build(img, o->threads, &cg)) {
+      fprintf(stderr, "Error: %s: out of memory building the call graph\n", img->path);
+      return;
+    }
+    if (!callgraph_write(out, &cg, o->callgraph, label)) {
+      fprintf(stderr, "Error: %s: cannot write the call graph\n", img->path);
+    }
+    callgraph_free(&cg);
+    return;
+  }
+
+  if (o->q) {
+    Arena *sa = arena_thread();
+    ArenaMark mark = arena_mark(sa);
+    Insn *win = (Insn*)arena_alloc(sa, (QUERY_BATCH + query_span(o->q)) * sizeof(Insn));
+    if (!win) return;
+    for (size_t i = 0; i < img->seg_count; i++) {
+      query_segment(out, o->q, win, img->buf, &img->segs[i], label);
+    }
+    arena_reset(sa, mark);
+    return;
+  }
+
+  LineTable lt;
+  Annot an = { o->smp, NULL, img->relocs, img->reloc_count, o->idx, NULL, 0 };
+  if (o->idx) {
+    image_load_symbols(img);
+    o->idx->syms = img->syms;
+    o->idx->nsyms = img->sym_count;
+    o->idx->next = 0;
+  }
+  if (o->show_lines && line_table_load(img, o->start, o->stop, &lt)) an.lines = &lt;
+  Arena *sa = arena_thread();
+  ArenaMark mark = arena_mark(sa);
+  if (o->data_scan) {
+    DataRange *data = NULL;
+    image_load_symbols(img);
+    if (!data_scan(img, sa, &data, &an.ndata)) {
+      fprintf(stderr, "Error: %s: out of memory in --data-scan\n", img->path);
+      arena_reset(sa, mark);
+      if (an.lines) line_table_free(&lt);
+      if (o->idx) o->idx->syms = NULL;
+      return;
+    }
+    an.data = data;
+  }
+
+  if (o->hot_top) {
+    image_load_symbols(img);
+    if (label) fprintf(out, "%s:\n", label);
+    dump_hot(out, img, o->hot_top, &an);
+  } else {
+    for (size_t i = 0; i < img->seg_count; i++) {
+      const ElfExecSeg *seg = &img->segs[i];
+      if (label && i == 0) fprintf(out, "%s:\n", label);
+      uint64_t a0 = o->start > seg->vaddr ? o->start : seg->vaddr;
+      uint64_t a1 = o->stop < seg->vaddr + seg->filesz ? o->stop : seg->vaddr + seg->filesz;
+      if (a0 >= a1) continue;
+      if (a0 > seg->vaddr) a0 = sync_start(img, seg, a0);
+      dump_range(out, img->buf, seg, seg->offset + (a0 - seg->vaddr),
+                 seg->offset + (a1 - seg->vaddr), &an);
+    }
+  }
+
+  if (o->data_scan) data_stats(stderr, img, an.data, an.ndata, label);
+  arena_reset(sa, mark);
+  if (an.lines) line_table_free(&lt);
+  if (o->idx) o->idx->syms = NULL;
+}
+
+typedef struct {
+  const RunOptions *opt;
+  const char *path;
+} ArchiveJob;
+
+// One archive member, labeled "lib.a(member.o)"; members without code are skipped.
+static void process_member(FILE *out, const ArMember *m, void *user) {
+  const ArchiveJob *job = (const ArchiveJob*)user;
+  char label[512];
+  snprintf(label, sizeof(label), "%s(%s)", job->path, m->name);
+
+  Image img;
+  int err = image_from_memory(label, m->data, m->size, &img);
+  if (err == IMG_ERR_NOEXEC) return;
+  if (err != IMG_OK) {
+    fprintf(stderr, "Error: %s: %s\n", label, image_strerror(err));
+    return;
+  }
+  process_image(out, &img, job->opt, label);
+  image_free(&img);
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+    "usage: %s [options] <elf|.o|.a>...\n"
+    "  --query EXPR      print instructions matching EXPR (see query.h)\n"
+    "  --vector-report   per-function SIMD width (scalar/sse/avx2/avx512)\n"
+    "  --samples FILE    annotate the listing with IP sample percentages\n"
+    "  --hot-only [N]    with --samples: only the regions around the top N (20) addresses\n"
+    "  --align-report    JCC-erratum (32-byte) branches and misaligned loop heads\n"
+    "  --loop-align N    loop head alignment checked by --align-report (16)\n"
+    "  --cost            static cycles/iteration per loop and per function\n"
+    "  --uarch NAME      cost model for --cost: skl, zen3 (skl)\n"
+    "  --footprint       per-function bytes, insns, padding, 64B lines, 4K pages, db\n"
+    "  --sort KEY        --footprint order: addr name bytes insns pad lines pages db\n"
+    "  --csv             comma-separated --footprint output\n"
+    "  --diff OLD NEW    functions whose normalized code changed between builds\n"
+    "  --page-map        code bytes, padding, functions and samples per 4K / 2M page\n"
+    "  --cover PCT       --page-map: fewest pages holding PCT%% of samples (90)\n"
+    "  --serve SOCKET    answer range/sym/addr requests on a Unix socket (serve.h)\n"
+    "  --threads N       --serve workers / archive members / --dup-report, --callgraph (4)\n"
+    "  --cache N         --serve binaries kept mapped (16)\n"
+    "  --addrs FILE      symbolize and decode the addresses in FILE (- for stdin)\n"
+    "  --pid PID         disassemble the executable mappings of a live process\n"
+    "  --lines           interleave file:line from .debug_line\n"
+    "  --start ADDR      list from the instruction covering ADDR (hex)\n"
+    "  --stop ADDR       list up to ADDR (hex, exclusive)\n"
+    "  --crash           core files: list +-256 bytes around the crashing thread's pc\n"
+    "  --data-scan       list jump tables, strings, fills and undecodable runs as hex\n"
+    "  --lint            slow encodings (lcp, lock, div, partial regs, leave, lea3, indirect)\n"
+    "  --mem-report      memory operands per loop / function: rip, stack, chase, gather, stride\n"
+    "  --spills          stack spills / reloads per loop, ranked by density (x samples)\n"
+    "  --index-out FILE  write an address -> listing offset index (stdout must be a file)\n"
+    "  --index-every N   --index-out: an entry every N instructions and per function (256)\n"
+    "  --lookup ADDR LISTING  print LISTING from ADDR (hex) via LISTING.idx or --index-out\n"
+    "  --dup-report      identical / near-identical functions across all inputs, by wasted bytes\n"
+    "  --dup-min N       --dup-report: ignore functions under N bytes (32)\n"
+    "  --callgraph FMT   caller -> callee edges with call/tail/indirect counts: text, dot, bin\n"
+    "  --alloc-stats     print arena peak / reserved bytes to stderr at exit\n"
+    "  --plan N          manifest splitting the inputs' code into N shards of equal bytes\n"
+    "  --shard K MANIFEST  list shard K of a --plan manifest (inputs come from MANIFEST)\n"
+    "  --merge MANIFEST  join shard outputs (the inputs) into the listing of one run\n",
+    argv0);
+}
+
+// files has room for argc entries; positional inputs land there.
+static int run(int argc, char **argv, const char **files) {
+  const char *query_src = NULL;
+  int vec_report = 0;
+  const char *samples_path = NULL;
+  size_t hot_top = 0;
+  int align_rep = 0;
+  unsigned loop_align = 16;
+  int cost = 0;
+  const char *uarch = "skl";
+  int footprint = 0;
+  const char *sort_key = "addr";
+  int csv = 0;
+  int page_rep = 0;
+  int lint = 0;
+  int mem_rep = 0;
+  int spills = 0;
+  int crash = 0;
+  int data_scan = 0;
+  const char *index_out = NULL;
+  unsigned index_every = 256;
+  const char *lookup_listing = NULL;
+  uint64_t lookup_addr = 0;
+  int dup = 0;
+  uint64_t dup_min = 32;
+  const char *cg_format = NULL;
+  int alloc_stats = 0;
+  int plan = 0;
+  size_t plan_shards = 0;
+  const char *shard_manifest = NULL, *merge_manifest = NULL;
+  size_t shard_k = 0;
+  double cover_pct = 90.0;
+  const char *addrs_path = NULL;
+  int pid = 0;
+  int show_lines = 0;
+  uint64_t start = 0, stop = UINT64_MAX;
+  const char *serve_path = NULL;
+  ServeOptions serve_opt = { 16, 4 };
+  const char *diff_old = NULL, *diff_new = NULL;
+  size_t nfiles = 0;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--query") == 0 && a + 1 < argc) {
+      query_src = argv[++a];
+    } else if (strcmp(argv[a], "--vector-report") == 0) {
+      vec_report = 1;
+    } else if (strcmp(argv[a], "--samples") == 0 && a + 1 < argc) {
+      samples_path = argv[++a];
+    } else if (strcmp(argv[a], "--align-report") == 0) {
+      align_rep = 1;
+    } else if (strcmp(argv[a], "--loop-align") == 0 && a + 1 < argc) {
+      loop_align = (unsigned)strtoul(argv[++a], NULL, 0);
+    } else if (strcmp(argv[a], "--cost") == 0) {
+      cost = 1;
+    } else if (strcmp(argv[a], "--uarch") == 0 && a + 1 < argc) {
+      uarch = argv[++a];
+    } else if (strcmp(argv[a], "--footprint") == 0) {
+      footprint = 1;
+    } else if (strcmp(argv[a], "--sort") == 0 && a + 1 < argc) {
+      sort_key = argv[++a];
+    } else if (strcmp(argv[a], "--csv") == 0) {
+      csv = 1;
+    } else if (strcmp(argv[a], "--diff") == 0 && a + 2 < argc) {
+      diff_old = argv[++a];
+      diff_new = argv[++a];
+    } else if (strcmp(argv[a], "--page-map") == 0) {
+      page_rep = 1;
+    } else if (strcmp(argv[a], "--cover") == 0 && a + 1 < argc) {
+      cover_pct = strtod(argv[++a], NULL);
+    } else if (strcmp(argv[a], "--serve") == 0 && a + 1 < argc) {
+      serve_path = argv[++a];
+    } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+      serve_opt.threads = (size_t)strtoull(argv[++a], NULL, 10);
+    } else if (strcmp(argv[a], "--cache") == 0 && a + 1 < argc) {
+      serve_opt.cache_entries = (size_t)strtoull(argv[++a], NULL, 10);
+    } else if (strcmp(argv[a], "--addrs") == 0 && a + 1 < argc) {
+      addrs_path = argv[++a];
+    } else if (strcmp(argv[a], "--pid") == 0 && a + 1 < argc) {
+      pid = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--lines") == 0) {
+      show_lines = 1;
+    } else if (strcmp(argv[a], "--start") == 0 && a + 1 < argc) {
+      start = strtoull(argv[++a], NULL, 16);
+    } else if (strcmp(argv[a], "--stop") == 0 && a + 1 < argc) {
+      stop = strtoull(argv[++a], NULL, 16);
+    } else if (strcmp(argv[a], "--crash") == 0) {
+      crash = 1;
+    } else if (strcmp(argv[a], "--data-scan") == 0) {
+      data_scan = 1;
+    } else if (strcmp(argv[a], "--index-out") == 0 && a + 1 < argc) {
+      index_out = argv[++a];
+    } else if (strcmp(argv[a], "--index-every") == 0 && a + 1 < argc) {
+      index_every = (unsigned)strtoul(argv[++a], NULL, 10);
+    } else if (strcmp(argv[a], "--lookup") == 0 && a + 2 < argc) {
+      lookup_addr = strtoull(argv[++a], NULL, 16);
+      lookup_listing = argv[++a];
+    } else if (strcmp(argv[a], "--dup-report") == 0) {
+      dup = 1;
+    } else if (strcmp(argv[a], "--dup-min") == 0 && a + 1 < argc) {
+      dup_min = strtoull(argv[++a], NULL, 10);
+    } else if (strcmp(argv[a], "--callgraph") == 0 && a + 1 < argc) {
+      cg_format = argv[++a];
+    } else if (strcmp(argv[a], "--plan") == 0 && a + 1 < argc) {
+      plan = 1;
+      plan_shards = (size_t)strtoull(argv[++a], NULL, 10);
+    } else if (strcmp(argv[a], "--shard") == 0 && a + 2 < argc) {
+      shard_k = (size_t)strtoull(argv[++a], NULL, 10);
+      shard_manifest = argv[++a];
+    } else if (strcmp(argv[a], "--merge") == 0 && a + 1 < argc) {
+      merge_manifest = argv[++a];
+    } else if (strcmp(argv[a], "--alloc-stats") == 0) {
+      alloc_stats = 1;
+    } else if (strcmp(argv[a], "--lint") == 0) {
+      lint = 1;
+    } else if (strcmp(argv[a], "--mem-report") == 0) {
+      mem_rep = 1;
+    } else if (strcmp(argv[a], "--spills") == 0) {
+      spills = 1;
+    } else if (strcmp(argv[a], "--hot-only") == 0) {
+      hot_top = 20;
+      // an optional N: only an argument that is wholly a number, so inputs
+      // named like "2024-build.bin" stay inputs
+      if (a + 1 < argc && argv[a + 1][0] >= '0' && argv[a + 1][0] <= '9') {
+        char *end;
+        unsigned long long v = strtoull(argv[a + 1], &end, 10);
+        if (*end == '\0') {
+          hot_top = (size_t)v;
+          a++;
+        }
+      }
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      usage(argv[0]);
+      return 1;
+    } else {
+      files[nfiles++] = argv[a];
+    }
+  }
+
+  if (diff_old) return code_diff(stdout, diff_old, diff_new);
+  if (serve_path) return serve(serve_path, &serve_opt);
+  if (lookup_listing) {
+    return listing_lookup(stdout, lookup_listing, index_out, lookup_addr, stop, LOOKUP_LINES);
+  }
+
+  if (merge_manifest) return shard_merge(stdout, merge_manifest, files, nfiles);
+  if (shard_manifest && (nfiles || query_src || vec_report || align_rep || cost || footprint ||
+                         page_rep || lint || mem_rep || spills || dup || cg_format || addrs_path || hot_top ||
+                         show_lines || index_out || pid || data_scan)) {
+    fprintf(stderr, "Error: --shard takes its inputs from the manifest and only lists code\n");
+    return 1;
+  }
+
+  if (nfiles == 0 && !pid && !shard_manifest) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (plan) {
+    if (plan_shards == 0 || plan_shards > 1000000) {
+      fprintf(stderr, "Error: --plan takes 1 to 1000000 shards\n");
+      return 1;
+    }
+    return shard_plan(stdout, files, nfiles, plan_shards);
+  }
+
+  if (dup) {
+    DupOptions dopt = { serve_opt.threads, dup_min };
+    int drc = dup_report(stdout, files, nfiles, &dopt);
+    if (alloc_stats) arena_stats(stderr);
+    return drc;
+  }
+
+  if (loop_align == 0 || (loop_align & (loop_align - 1)) != 0 || loop_align > 4096) {
+    fprintf(stderr, "Error: --loop-align must be a power of two\n");
+    return 1;
+  }
+
+  const UarchProfile *prof = cost_profile(uarch);
+  if (!prof) {
+    fprintf(stderr, "Error: unknown --uarch %s\n", uarch);
+    return 1;
+  }
+
+  int fp_key = footprint_sort_key(sort_key);
+  if (fp_key < 0) {
+    fprintf(stderr, "Error: unknown --sort key %s\n", sort_key);
+    return 1;
+  }
+
+  if (!(cover_pct > 0.0 && cover_pct <= 100.0)) {
+    fprintf(stderr, "Error: --cover must be in (0, 100]\n");
+    return 1;
+  }
+
+  if (index_out && (nfiles != 1 || archive_probe(files[0]))) {
+    fprintf(stderr, "Error: --index-out needs a single ELF input\n");
+    return 1;
+  }
+  if (index_out && ftello(stdout) < 0) {
+    fprintf(stderr, "Error: --index-out needs stdout redirected to a file\n");
+    return 1;
+  }
+
+  int cg_fmt = cg_format ? callgraph_format(cg_format) : CG_NONE;
+  if (cg_fmt < 0) {
+    fprintf(stderr, "Error: unknown --callgraph format %s\n", cg_format);
+    return 1;
+  }
+  if (cg_fmt == CG_BIN && (nfiles != 1 || archive_probe(files[0]))) {
+    fprintf(stderr, "Error: --callgraph bin needs a single ELF input\n");
+    return 1;
+  }
+
+  if (hot_top && !samples_path) {
+    fprintf(stderr, "Error: --hot-only needs --samples\n");
+    return 1;
+  }
+
+  SampleIndex smp_store;
+  const SampleIndex *smp = NULL;
+  if (samples_path) {
+    if (!samples_load(samples_path, &smp_store)) {
+      fprintf(stderr, "Error: cannot read samples %s\n", samples_path);
+      return 2;
+    }
+    smp = &smp_store;
+  }
+
+  SampleIndex addrs;
+  if (addrs_path && !samples_load(addrs_path, &addrs)) {
+    fprintf(stderr, "Error: cannot read addresses %s\n", addrs_path);
+    return 2;
+  }
+
+  if (shard_manifest) {
+    int src = shard_run(stdout, shard_manifest, shard_k, dump_piece, (void*)smp);
+    if (smp) samples_free(&smp_store);
+    if (alloc_stats) arena_stats(stderr);
+    return src;
+  }
+
+  if (pid) {
+    int prc = dump_process(pid, smp);
+    if (smp) samples_free(&smp_store);
+    if (addrs_path) samples_free(&addrs);
+    if (alloc_stats) arena_stats(stderr);
+    return prc;
+  }
+
+  Query *q = NULL;
+  if (query_src) {
+    char err[128];
+    q = query_compile(query_src, err, sizeof(err));
+    if (!q) {
+      fprintf(stderr, "Error: bad query: %s\n", err);
+      return 1;
+    }
+  }
+
+  RunOptions opt;
+  memset(&opt, 0, sizeof(opt));
+  opt.q = q;
+  opt.smp = smp;
+  opt.addrs = addrs_path ? &addrs : NULL;
+  opt.prof = prof;
+  opt.vec_report = vec_report;
+  opt.align_rep = align_rep;
+  opt.cost = cost;
+  opt.footprint = footprint;
+  opt.csv = csv;
+  opt.page_rep = page_rep;
+  opt.lint = lint;
+  opt.mem_rep = mem_rep;
+  opt.spills = spills;
+  opt.show_lines = show_lines && !q;
+  opt.loop_align = loop_align;
+  opt.fp_key = (FootSort)fp_key;
+  opt.callgraph = (CgFormat)cg_fmt;
+  opt.threads = serve_opt.threads;
+  opt.cover_pct = cover_pct;
+  opt.hot_top = hot_top;
+  opt.start = start;
+  opt.stop = stop;
+  opt.crash = crash;
+  opt.data_scan = data_scan;
+
+  ListingIndex ix;
+  if (index_out) {
+    listing_index_init(&ix, index_every, NULL, 0);
+    opt.idx = &ix;
+  }
+
+  // core files only have listings
+  int core_ok = !(q || vec_report || align_rep || cost || footprint || page_rep || lint ||
+                  mem_rep || spills || cg_format || addrs_path || hot_top || show_lines || index_out ||
+                  data_scan);
+
+  int rc = 0;
+  for (size_t f = 0; f < nfiles; f++) {
+    if (core_probe(files[f])) {
+      if (!core_ok) {
+        fprintf(stderr, "Error: %s: core files only support listings (--start, --stop, --crash, --samples)\n",
+          files[f]);
+        rc = 1;
+        continue;
+      }
+      int err = dump_core(stdout, files[f], &opt, nfiles > 1 ? files[f] : NULL);
+      if (err != IMG_OK) rc = err;
+      continue;
+    }
+    if (archive_probe(files[f])) {
+      Archive ar;
+      int err = archive_open(files[f], &ar);
+      if (err != IMG_OK) {
+        fprintf(stderr, "Error: %s: %s\n", files[f], image_strerror(err));
+        rc = err;
+        continue;
+      }
+      // members already run in parallel
+      RunOptions mopt = opt;
+      mopt.threads = 1;
+      ArchiveJob job = { &mopt, files[f] };
+      archive_run(stdout, &ar, serve_opt.threads, process_member, &job);
+      archive_close(&ar);
+      continue;
+    }
+
+    const char *label = nfiles > 1 ? files[f] : NULL;
+    Image img;
+    int err = image_load(files[f], &img);
+    if (err != IMG_OK) {
+      fprintf(stderr, "Error: %s: %s\n", files[f], image_strerror(err));
+      rc = err;
+      continue;
+    }
+    process_image(stdout, &img, &opt, label);
+    image_free(&img);
+  }
+
+  if (index_out) {
+    fflush(stdout);
+    if (!listing_index_write(index_out, &ix, (uint64_t)ftello(stdout))) {
+      fprintf(stderr, "Error: cannot write index %s\n", index_out);
+      rc = 2;
+    }
+    listing_index_free(&ix);
+  }
+
+  query_free(q);
+  if (smp) samples_free(&smp_store);
+  if (addrs_path) samples_free(&addrs);
+  if (alloc_stats) arena_stats(stderr);
+  return rc;
+}
+
+int main(int argc, char **argv) {
+  const char **files = (const char**)malloc((size_t)argc * sizeof(const char*));
+  if (!files) {
+    fprintf(stderr, "Error: out of memory\n");
+    return 2;
+  }
+  int rc = run(argc, argv, files);
+  free(files);
+  return rc;
+}
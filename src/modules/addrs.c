@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include "opdump/addrs.h"
+#include "opdump/decode.h"
+#include "opdump/format.h"
+#include "opdump/boundary.h"
+#include "opdump/arena.h"
+
+static void print_head(FILE *out, const SampleIndex *a, size_t k, const char *label) {
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%016llx %8llu  ", (unsigned long long)a->addr[k], (unsigned long long)a->count[k]);
+}
+
+static void print_unknown(FILE *out, const SampleIndex *a, size_t k, const char *label) {
+  print_head(out, a, k, label);
+  fprintf(out, "?\n");
+}
+
+// Addresses of one region, from index *k on. Only the instructions holding
+// them are decoded; the boundary sweep skips the ones in between.
+static void join_region(FILE *out, const Image *img, const Region *r, const SampleIndex *a,
+                        size_t *k, const char *label) {
+  const uint64_t end = r->addr + r->size;
+  const uint8_t *p = img->buf + r->offset;
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  uint64_t off = 0;   // an instruction start
+  while (*k < a->n && a->addr[*k] < end) {
+    off += insn_sync(p + off, (size_t)(r->size - off), (size_t)(a->addr[*k] - r->addr - off));
+    Insn in;
+    size_t used = 0;
+    decode_batch(&ctx, p + off, (size_t)(r->size - off), r->addr + off, &in, 1, &used);
+    while (*k < a->n && a->addr[*k] < in.addr + in.size) {
+      uint64_t at = a->addr[*k];
+      print_head(out, a, *k, label);
+      char gap[40];
+      fprintf(out, "%s+0x%llx  ", region_name(r->name, r->addr, gap, sizeof(gap)),
+              (unsigned long long)(at - r->addr));
+      format_intel(out, &in);
+      if (at != in.addr) fprintf(out, "  ; inside %llx+%llu", (unsigned long long)in.addr,
+                                 (unsigned long long)(at - in.addr));
+      fprintf(out, "\n");
+      (*k)++;
+    }
+  }
+}
+
+static _Thread_local const Image *g_img; // qsort has no context argument
+
+static int cmp_seg(const void *x, const void *y) {
+  uint64_t a = g_img->segs[*(const size_t*)x].vaddr, b = g_img->segs[*(const size_t*)y].vaddr;
+  return (a > b) - (a < b);
+}
+
+void addrs_report(FILE *out, const Image *img, const SampleIndex *addrs, const char *label) {
+  Arena *sa = arena_thread();
+  ArenaMark order_mark = arena_mark(sa);
+  size_t *order = (size_t*)arena_alloc(sa, img->seg_count * sizeof(size_t));
+  if (!order) return;
+  for (size_t s = 0; s < img->seg_count; s++) order[s] = s;
+  g_img = img;
+  qsort(order, img->seg_count, sizeof(size_t), cmp_seg);
+
+  fprintf(out, "# address            count  function+offset  instruction\n");
+  size_t k = 0;
+  for (size_t o = 0; o < img->seg_count && k < addrs->n; o++) {
+    const ElfExecSeg *seg = &img->segs[order[o]];
+    while (k < addrs->n && addrs->addr[k] < seg->vaddr) print_unknown(out, addrs, k++, label);
+    if (k == addrs->n || addrs->addr[k] >= seg->vaddr + seg->filesz) continue;
+
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(seg, img->syms, img->sym_count, sa, &regs);
+    for (size_t r = 0; r < nr && k < addrs->n; r++) {
+      if (addrs->addr[k] >= regs[r].addr + regs[r].size) continue;
+      join_region(out, img, &regs[r], addrs, &k, label);
+    }
+    arena_reset(sa, mark);
+  }
+  while (k < addrs->n) print_unknown(out, addrs, k++, label);
+  arena_reset(sa, order_mark);
+}
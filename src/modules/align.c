@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/align.h"
+#include "opdump/decode.h"
+#include "opdump/format.h"
+#include "opdump/arena.h"
+
+enum { ALIGN_BATCH = 4096 };
+
+typedef struct {
+  uint64_t branches;
+  uint64_t cross32;
+  uint64_t end32;
+  uint64_t loops;
+  uint64_t misaligned;
+} AlignStats;
+
+static int is_branch(Op op) {
+  return op == OP_JCC_REL || op == OP_JMP_REL || op == OP_JMP_RM ||
+         op == OP_CALL_REL || op == OP_CALL_RM || op == OP_RET;
+}
+
+// cmp/test + jcc decode as one uop unless the cmp/test has both mem and imm
+static int fuses(const Insn *first, const Insn *jcc) {
+  if (jcc->op != OP_JCC_REL) return 0;
+  if (first->op != OP_CMP && first->op != OP_TEST) return 0;
+  if (first->addr + first->size != jcc->addr) return 0;
+  int mem = 0, imm = 0;
+  for (uint8_t i = 0; i < first->op_count; i++) {
+    if (first->ops[i].kind == O_MEM) mem = 1;
+    if (first->ops[i].kind == O_IMM) imm = 1;
+  }
+  return !(mem && imm);
+}
+
+static unsigned natural_align(uint64_t a) {
+  unsigned al = 1;
+  while (al < 64 && (a & al) == 0) al <<= 1;
+  return al;
+}
+
+static void print_where(FILE *out, const char *label, const char *kind, uint64_t addr,
+                        uint64_t len, const char *fn, uint64_t fn_addr) {
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%-10s %016llx %3llu  ", kind, (unsigned long long)addr, (unsigned long long)len);
+  char gap[40];
+  fprintf(out, "%s+0x%llx  ", region_name(fn, fn_addr, gap, sizeof(gap)),
+          (unsigned long long)(addr - fn_addr));
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+static void scan_region(FILE *out, const Image *img, const Region *r, unsigned loop_align,
+                        Insn *batch, uint64_t **heads, size_t *heads_cap,
+                        AlignStats *st, const char *label) {
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  size_t nheads = 0;
+  Insn prev;
+  int have_prev = 0;
+
+  const uint8_t *p = img->buf + r->offset;
+  uint64_t off = 0;
+  while (off < r->size) {
+    size_t used = 0;
+    size_t got = decode_batch(&ctx, p + off, (size_t)(r->size - off), r->addr + off,
+                              batch, ALIGN_BATCH, &used);
+    off += used;
+
+    for (size_t k = 0; k < got; k++) {
+      const Insn *in = &batch[k];
+      if (is_branch(in->op)) {
+        const Insn *first = (have_prev && fuses(&prev, in)) ? &prev : in;
+        uint64_t a0 = first->addr, a1 = in->addr + in->size;
+        st->branches++;
+
+        const char *kind = NULL;
+        if ((a0 >> 5) != ((a1 - 1) >> 5)) { kind = "cross32"; st->cross32++; }
+        else if ((a1 & 31) == 0)         { kind = "end32";   st->end32++; }
+        if (kind) {
+          print_where(out, label, kind, a0, a1 - a0, r->name, r->addr);
+          if (first != in) { format_intel(out, first); fprintf(out, "; "); }
+          format_intel(out, in);
+          fprintf(out, "\n");
+        }
+
+        // backward jump inside the function: the target is a loop head
+        if ((in->op == OP_JCC_REL || in->op == OP_JMP_REL) && in->op_count == 1) {
+          uint64_t tgt = (uint64_t)in->ops[0].imm;
+          if (tgt <= in->addr && tgt >= r->addr) {
+            if (nheads == *heads_cap) {
+              size_t nc = *heads_cap ? *heads_cap * 2 : 64;
+              uint64_t *nh = (uint64_t*)realloc(*heads, nc * sizeof(uint64_t));
+              if (!nh) continue;
+              *heads = nh;
+              *heads_cap = nc;
+            }
+            (*heads)[nheads++] = tgt;
+          }
+        }
+      }
+      prev = *in;
+      have_prev = 1;
+    }
+  }
+
+  if (nheads) qsort(*heads, nheads, sizeof(uint64_t), cmp_u64);
+  for (size_t i = 0; i < nheads; i++) {
+    if (i && (*heads)[i] == (*heads)[i - 1]) continue;
+    uint64_t h = (*heads)[i];
+    st->loops++;
+    if (h % loop_align == 0) continue;
+    st->misaligned++;
+    print_where(out, label, "loop-align", h, 0, r->name, r->addr);
+    fprintf(out, "head aligned to %u, want %u\n", natural_align(h), loop_align);
+  }
+}
+
+static void print_totals(FILE *out, const char *label, const char *tag,
+                         const AlignStats *st, const char *name) {
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%-5s %8llu %8llu %8llu %8llu %8llu  %s\n", tag,
+    (unsigned long long)st->branches, (unsigned long long)st->cross32,
+    (unsigned long long)st->end32, (unsigned long long)st->loops,
+    (unsigned long long)st->misaligned, name);
+}
+
+void align_report(FILE *out, const Image *img, unsigned loop_align, const char *label) {
+  if (loop_align == 0) loop_align = 16;
+
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, ALIGN_BATCH * sizeof(Insn));
+  if (!batch) return;
+
+  uint64_t *heads = NULL;
+  size_t heads_cap = 0;
+
+  // per-function totals are collected here and printed after the findings
+  typedef struct { AlignStats st; const char *name; uint64_t addr; } FnRow;
+  FnRow *rows = NULL;
+  size_t nrows = 0, rows_cap = 0;
+
+  AlignStats all = {0};
+  fprintf(out, "# kind      address          len  where  instruction\n");
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+    for (size_t r = 0; r < nr; r++) {
+      AlignStats st = {0};
+      scan_region(out, img, &regs[r], loop_align, batch, &heads, &heads_cap, &st, label);
+
+      all.branches += st.branches; all.cross32 += st.cross32; all.end32 += st.end32;
+      all.loops += st.loops; all.misaligned += st.misaligned;
+
+      if (st.cross32 + st.end32 + st.misaligned == 0) continue;
+      if (nrows == rows_cap) {
+        size_t nc = rows_cap ? rows_cap * 2 : 256;
+        FnRow *nrw = (FnRow*)realloc(rows, nc * sizeof(FnRow));
+        if (!nrw) continue;
+        rows = nrw;
+        rows_cap = nc;
+      }
+      rows[nrows].st = st;
+      rows[nrows].name = regs[r].name;
+      rows[nrows].addr = regs[r].addr;
+      nrows++;
+    }
+    arena_reset(sa, mark);
+  }
+
+  fprintf(out, "#     branches  cross32    end32    loops misalign  function\n");
+  for (size_t i = 0; i < nrows; i++) {
+    char gap[40];
+    print_totals(out, label, "func", &rows[i].st,
+                 region_name(rows[i].name, rows[i].addr, gap, sizeof(gap)));
+  }
+  print_totals(out, label, "total", &all, "<total>");
+
+  free(rows);
+  free(heads);
+  arena_reset(sa, batch_mark);
+}
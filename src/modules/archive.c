@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "opdump/archive.h"
+#include "opdump/image.h"
+
+enum { AR_HDR = 60, AR_AHEAD = 4 }; // completed members kept per worker
+
+static const char k_magic[8] = { '!', '<', 'a', 'r', 'c', 'h', '>', '\n' };
+
+int archive_probe(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return 0;
+  char m[8];
+  ssize_t got = pread(fd, m, sizeof(m), 0);
+  close(fd);
+  return got == (ssize_t)sizeof(m) && memcmp(m, k_magic, sizeof(m)) == 0;
+}
+
+static uint64_t parse_dec(const uint8_t *p, size_t len) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < len && p[i] >= '0' && p[i] <= '9'; i++) v = v * 10 + (uint64_t)(p[i] - '0');
+  return v;
+}
+
+static void copy_name(char *dst, size_t cap, const uint8_t *src, size_t len) {
+  size_t k = 0;
+  while (k < len && k + 1 < cap && src[k] && src[k] != '\n') k++;
+  memcpy(dst, src, k);
+  // GNU names end in '/', short ones are space padded
+  while (k && (dst[k - 1] == ' ' || dst[k - 1] == '/')) k--;
+  dst[k] = 0;
+}
+
+int archive_open(const char *path, Archive *ar) {
+  memset(ar, 0, sizeof(*ar));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return IMG_ERR_READ;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(k_magic)) { close(fd); return IMG_ERR_READ; }
+  void *p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return IMG_ERR_READ;
+  ar->buf = (uint8_t*)p;
+  ar->n = (size_t)st.st_size;
+  if (memcmp(ar->buf, k_magic, sizeof(k_magic)) != 0) {
+    archive_close(ar);
+    return IMG_ERR_ELF;
+  }
+
+  const uint8_t *longnames = NULL;
+  size_t longnames_len = 0, cap = 0;
+  size_t off = sizeof(k_magic);
+  while (off + AR_HDR <= ar->n) {
+    const uint8_t *h = ar->buf + off;
+    if (h[58] != '`' || h[59] != '\n') break;
+    size_t size = (size_t)parse_dec(h + 48, 10);
+    size_t data = off + AR_HDR;
+    if (size > ar->n - data) break;
+    off = data + size + (size & 1);
+
+    ArMember m;
+    m.data = ar->buf + data;
+    m.size = size;
+    if (h[0] == '/' && h[1] == '/') {                     // GNU long name table
+      longnames = m.data;
+      longnames_len = size;
+      continue;
+    }
+    if (h[0] == '/' && (h[1] == ' ' || memcmp(h, "/SYM64/", 7) == 0)) continue; // symbol index
+    if (h[0] == '/' && h[1] >= '0' && h[1] <= '9') {       // "/123": offset into the table
+      size_t at = (size_t)parse_dec(h + 1, 15);
+      if (!longnames || at >= longnames_len) continue;
+      copy_name(m.name, sizeof(m.name), longnames + at, longnames_len - at);
+    } else if (memcmp(h, "#1/", 3) == 0) {                 // BSD: name in front of the data
+      size_t len = (size_t)parse_dec(h + 3, 13);
+      if (len > size) continue;
+      copy_name(m.name, sizeof(m.name), m.data, len);
+      m.data += len;
+      m.size -= len;
+    } else {
+      copy_name(m.name, sizeof(m.name), h, 16);
+    }
+    if (strncmp(m.name, "__.SYMDEF", 9) == 0) continue;
+
+    if (ar->count == cap) {
+      size_t nc = cap ? cap * 2 : 64;
+      ArMember *nm = (ArMember*)realloc(ar->members, nc * sizeof(ArMember));
+      if (!nm) break;
+      ar->members = nm;
+      cap = nc;
+    }
+    ar->members[ar->count++] = m;
+  }
+  return IMG_OK;
+}
+
+void archive_close(Archive *ar) {
+  free(ar->members);
+  if (ar->buf) munmap(ar->buf, ar->n);
+  memset(ar, 0, sizeof(*ar));
+}
+
+typedef struct {
+  const Archive *ar;
+  ArMemberFn fn;
+  void *user;
+
+  pthread_mutex_t mu;
+  pthread_cond_t cv;
+  size_t next;        // next member to start
+  size_t emitted;     // members already copied to out
+  size_t ahead;       // how far workers may run ahead of emitted
+  char **text;
+  size_t *len;
+  uint8_t *done;
+} ArRun;
+
+static void* ar_worker(void *arg) {
+  ArRun *r = (ArRun*)arg;
+  for (;;) {
+    pthread_mutex_lock(&r->mu);
+    size_t i = r->next++;
+    while (i < r->ar->count && i >= r->emitted + r->ahead) pthread_cond_wait(&r->cv, &r->mu);
+    pthread_mutex_unlock(&r->mu);
+    if (i >= r->ar->count) return NULL;
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *f = open_memstream(&text, &len);
+    if (f) {
+      r->fn(f, &r->ar->members[i], r->user);
+      fclose(f);
+    }
+
+    pthread_mutex_lock(&r->mu);
+    r->text[i] = text;
+    r->len[i] = len;
+    r->done[i] = 1;
+    pthread_cond_broadcast(&r->cv);
+    pthread_mutex_unlock(&r->mu);
+  }
+}
+
+void archive_run(FILE *out, const Archive *ar, size_t threads, ArMemberFn fn, void *user) {
+  if (threads > ar->count) threads = ar->count;
+  if (threads <= 1) {
+    for (size_t i = 0; i < ar->count; i++) fn(out, &ar->members[i], user);
+    return;
+  }
+
+  ArRun r;
+  memset(&r, 0, sizeof(r));
+  r.ar = ar;
+  r.fn = fn;
+  r.user = user;
+  r.ahead = threads * AR_AHEAD;
+  r.text = (char**)calloc(ar->count, sizeof(char*));
+  r.len = (size_t*)calloc(ar->count, sizeof(size_t));
+  r.done = (uint8_t*)calloc(ar->count, 1);
+  pthread_t *tids = (pthread_t*)malloc(threads * sizeof(pthread_t));
+  if (!r.text || !r.len || !r.done || !tids) {
+    free(r.text); free(r.len); free(r.done); free(tids);
+    for (size_t i = 0; i < ar->count; i++) fn(out, &ar->members[i], user);
+    return;
+  }
+  pthread_mutex_init(&r.mu, NULL);
+  pthread_cond_init(&r.cv, NULL);
+
+  size_t started = 0;
+  for (; started < threads; started++) {
+    if (pthread_create(&tids[started], NULL, ar_worker, &r) != 0) break;
+  }
+  if (started == 0) {
+    // no threads: run everything here, nothing is emitted until the end
+    r.ahead = SIZE_MAX;
+    ar_worker(&r);
+  }
+
+  for (size_t i = 0; i < ar->count; i++) {
+    pthread_mutex_lock(&r.mu);
+    while (!r.done[i]) pthread_cond_wait(&r.cv, &r.mu);
+    pthread_mutex_unlock(&r.mu);
+
+    if (r.text[i]) fwrite(r.text[i], 1, r.len[i], out);
+    free(r.text[i]);
+    r.text[i] = NULL;
+
+    pthread_mutex_lock(&r.mu);
+    r.emitted = i + 1;
+    pthread_cond_broadcast(&r.cv);
+    pthread_mutex_unlock(&r.mu);
+  }
+
+  for (size_t t = 0; t < started; t++) pthread_join(tids[t], NULL);
+  pthread_cond_destroy(&r.cv);
+  pthread_mutex_destroy(&r.mu);
+  free(r.text); free(r.len); free(r.done); free(tids);
+}
@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "opdump/arena.h"
+
+enum { ARENA_CHUNK = 256 * 1024 };
+
+struct ArenaChunk {
+  ArenaChunk *next;
+  size_t size, used;
+  _Alignas(16) unsigned char data[];
+};
+
+enum { POOL_MAX = 8, POOL_CHUNK_MAX = 4 * 1024 * 1024 };
+
+static struct {
+  pthread_mutex_t mu;
+  size_t arenas, max_peak;  // released arenas
+  size_t live, live_peak;   // bytes in chunks, including pooled ones
+  size_t mallocs;
+} g_stats = { PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, 0, 0 };
+
+// chunks of released arenas, kept for the next arena of this thread
+static _Thread_local ArenaChunk *t_pool;
+static _Thread_local size_t t_pooled;
+
+void arena_init(Arena *a, size_t chunk) {
+  memset(a, 0, sizeof(*a));
+  a->chunk = chunk ? chunk : ARENA_CHUNK;
+}
+
+static void push_head(Arena *a, ArenaChunk *c) {
+  c->used = 0;
+  c->next = a->head;
+  a->head = c;
+}
+
+static ArenaChunk *take_chunk(Arena *a, size_t need) {
+  for (ArenaChunk **pp = &a->spare; *pp; pp = &(*pp)->next) {
+    ArenaChunk *c = *pp;
+    if (c->size < need) continue;
+    *pp = c->next;
+    push_head(a, c);
+    return c;
+  }
+  for (ArenaChunk **pp = &t_pool; *pp; pp = &(*pp)->next) {
+    ArenaChunk *c = *pp;
+    if (c->size < need) continue;
+    *pp = c->next;
+    t_pooled--;
+    push_head(a, c);
+    a->reserved += c->size;
+    return c;
+  }
+  size_t size = need > a->chunk ? need : a->chunk;
+  ArenaChunk *c = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+  if (!c) return NULL;
+  c->size = size;
+  push_head(a, c);
+  a->reserved += size;
+  a->mallocs++;
+
+  pthread_mutex_lock(&g_stats.mu);
+  g_stats.live += size;
+  if (g_stats.live > g_stats.live_peak) g_stats.live_peak = g_stats.live;
+  g_stats.mallocs++;
+  pthread_mutex_unlock(&g_stats.mu);
+  return c;
+}
+
+void *arena_alloc(Arena *a, size_t n) {
+  if (!a->chunk) a->chunk = ARENA_CHUNK;
+  size_t need = n ? (n + 15) & ~(size_t)15 : 16;
+  if (need < n) return NULL;
+  ArenaChunk *c = a->head;
+  if (!c || c->size - c->used < need) {
+    c = take_chunk(a, need);
+    if (!c) return NULL;
+  }
+  void *p = c->data + c->used;
+  c->used += need;
+  a->used += need;
+  if (a->used > a->peak) a->peak = a->used;
+  return p;
+}
+
+ArenaMark arena_mark(const Arena *a) {
+  ArenaMark m = { a->head, a->head ? a->head->used : 0, a->used };
+  return m;
+}
+
+static void free_chunk(ArenaChunk *c) {
+  pthread_mutex_lock(&g_stats.mu);
+  g_stats.live -= c->size;
+  pthread_mutex_unlock(&g_stats.mu);
+  free(c);
+}
+
+void arena_reset(Arena *a, ArenaMark m) {
+  while (a->head && a->head != m.head) {
+    ArenaChunk *c = a->head;
+    a->head = c->next;
+    // an oversized chunk served one big allocation (a whole mapping, an
+    // LCS table): keeping it would pin that peak for the life of the arena
+    if (c->size > a->chunk) {
+      a->reserved -= c->size;
+      free_chunk(c);
+      continue;
+    }
+    c->next = a->spare;
+    a->spare = c;
+  }
+  if (a->head) a->head->used = m.head_used;
+  a->used = m.used;
+}
+
+static void release_list(ArenaChunk *c) {
+  while (c) {
+    ArenaChunk *next = c->next;
+    if (t_pooled < POOL_MAX && c->size <= POOL_CHUNK_MAX) {
+      c->next = t_pool;
+      t_pool = c;
+      t_pooled++;
+    } else {
+      free_chunk(c);
+    }
+    c = next;
+  }
+}
+
+void arena_free(Arena *a) {
+  if (a->head || a->spare) {
+    arena_thread();   // the pool is drained with the thread's scratch arena
+    release_list(a->head);
+    release_list(a->spare);
+  }
+  if (a->reserved) {
+    pthread_mutex_lock(&g_stats.mu);
+    g_stats.arenas++;
+    if (a->peak > g_stats.max_peak) g_stats.max_peak = a->peak;
+    pthread_mutex_unlock(&g_stats.mu);
+  }
+  arena_init(a, a->chunk);
+}
+
+static _Thread_local Arena t_scratch;
+static _Thread_local int t_ready;
+static pthread_key_t g_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+
+static void scratch_release(void *p) {
+  arena_free((Arena*)p);
+  while (t_pool) {
+    ArenaChunk *c = t_pool;
+    t_pool = c->next;
+    free_chunk(c);
+  }
+  t_pooled = 0;
+}
+static void make_key(void) { pthread_key_create(&g_key, scratch_release); }
+
+Arena *arena_thread(void) {
+  if (!t_ready) {
+    pthread_once(&g_key_once, make_key);
+    arena_init(&t_scratch, 0);
+    pthread_setspecific(g_key, &t_scratch);
+    t_ready = 1;
+  }
+  return &t_scratch;
+}
+
+void arena_stats(FILE *out) {
+  pthread_mutex_lock(&g_stats.mu);
+  size_t arenas = g_stats.arenas, max_peak = g_stats.max_peak;
+  size_t live_peak = g_stats.live_peak, mallocs = g_stats.mallocs;
+  pthread_mutex_unlock(&g_stats.mu);
+  if (t_ready && t_scratch.reserved) {
+    arenas++;
+    if (t_scratch.peak > max_peak) max_peak = t_scratch.peak;
+  }
+  fprintf(out, "# arena: %zu arenas, peak %zu bytes in use (largest arena), "
+               "%zu bytes reserved at peak, %zu chunk mallocs\n",
+          arenas, max_peak, live_peak, mallocs);
+}
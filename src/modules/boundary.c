@@ -0,0 +1,322 @@
+#include <pthread.h>
+#include <string.h>
+#include "opdump/boundary.h"
+#include "opdump/opcodes.h"
+#include "opdump/decode.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(BOUNDARY_NO_SIMD)
+#define BOUNDARY_AVX2 1
+#include <immintrin.h>
+#endif
+
+enum {
+  LOOKAHEAD = 16,       // table lengths need this many readable bytes
+  MAX_PFX = 4,          // longer prefix runs go to decode_one
+  BLOCK = 32            // candidate starts per AVX2 pass
+};
+
+typedef enum {
+  K_SLOW = 0,           // decode_one decides
+  K_FIXED,              // opcode + imm bytes
+  K_MODRM,              // opcode + ModRM/SIB/disp + imm bytes
+  K_MOVIMM,             // B8+r: imm32, or imm64 with REX.W
+  K_IMMZ,               // opcode + imm32, imm16 with 66
+  K_REX,
+  K_0F,
+  K_PFX                 // legacy prefix (first-byte table only)
+} LenKind;
+
+typedef struct {
+  uint8_t kind;
+  uint8_t imm;
+  uint8_t valid;        // K_MODRM: ModRM.reg values that read r/m and imm
+} LenRule;
+
+static LenRule g_first[256];      // byte at the instruction start
+static LenRule g_after_rex[256];  // opcode byte after REX
+static LenRule g_0f[256];         // byte after 0F
+static int g_simd;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+// ---- tables ----
+
+// Length decode_one gives a probe encoding (undecodable: 0).
+static size_t probe(const uint8_t *code, size_t n) {
+  uint8_t buf[LOOKAHEAD];
+  memset(buf, 0, sizeof(buf));
+  memcpy(buf, code, n);
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+  Insn in;
+  return decode_one(&ctx, buf, sizeof(buf), 0, &in);
+}
+
+// Which ModRM.reg values read the operand: with mod=2 (disp32) the full
+// form is 4 bytes longer than opcode + ModRM alone. 0 when neither fits.
+static int probe_valid(uint8_t b1, uint8_t b2, const LenRule *r, uint8_t *valid) {
+  size_t olen = b1 == 0x0F ? 2 : 1;
+  *valid = 0;
+  for (unsigned reg = 0; reg < 8; reg++) {
+    uint8_t code[3] = { b1, b2, 0 };
+    code[olen] = (uint8_t)(0x80 | (reg << 3));
+    size_t got = probe(code, olen + 1);
+    if (got == olen + 1 + 4 + r->imm) *valid |= (uint8_t)(1u << reg);
+    else if (got != olen + 1) return 0;
+  }
+  return 1;
+}
+
+static LenRule rule_of(const OpEntry *e) {
+  LenRule r = { K_FIXED, 0, 0 };
+  if (e->flags & OF_REL8) r.imm = 1;
+  else if (e->flags & OF_REL32) r.imm = 4;
+  else if (e->flags & OF_MOV_IMM_REG) r.kind = K_MOVIMM;
+  else if (e->flags & OF_ACC_IMM) r.kind = K_IMMZ;
+  else if (e->flags & OF_MODRM) {
+    r.kind = K_MODRM;
+    // C7 and imul r, r/m, imm fail the probe and stay with decode_one
+    r.imm = (e->flags & OF_GRP83) || ((e->flags & OF_GRP_C6) && (e->flags & OF_BYTE)) ? 1
+          : (e->flags & OF_GRP81) ? 4 : 0;
+  }
+  return r;
+}
+
+static void build_tables(void) {
+  // one-byte opcodes missing from g_ops decode as a 1-byte OP_INVALID
+  for (unsigned b = 0; b < 256; b++) {
+    g_after_rex[b].kind = K_FIXED;
+    g_0f[b].kind = K_SLOW;        // SSE rows (g_vops) are not tabulated
+  }
+  uint8_t set1[256] = {0}, set2[256] = {0};
+  for (unsigned k = 0; k < g_ops_count; k++) {
+    const OpEntry *e = &g_ops[k];
+    LenRule r = rule_of(e);
+    // same ranges as match_op_1 / match_op_2; the first matching row wins
+    unsigned lo = e->kind == OT_1 ? e->b1 : e->b2;
+    unsigned span = !(e->flags & OF_REG_RANGE) ? 1 : (e->kind == OT_2 || lo == 0x70) ? 16 : 8;
+    for (unsigned b = lo; b < lo + span && b < 256; b++) {
+      uint8_t *set = e->kind == OT_1 ? set1 : set2;
+      LenRule *t = e->kind == OT_1 ? g_after_rex : g_0f;
+      if (set[b] || (e->kind == OT_2 && e->b1 != 0x0F)) continue;
+      set[b] = 1;
+      t[b] = r;
+      if (r.kind == K_MODRM && !probe_valid(e->kind == OT_1 ? (uint8_t)b : 0x0F, (uint8_t)b, &r,
+                                            &t[b].valid)) {
+        t[b].kind = K_SLOW;
+      }
+    }
+  }
+  g_after_rex[0x0F].kind = K_0F;
+
+  memcpy(g_first, g_after_rex, sizeof(g_first));
+  static const uint8_t k_prefixes[] = {
+    0xF0, 0xF2, 0xF3, 0x2E, 0x36, 0x3E, 0x26, 0x64, 0x65, 0x66, 0x67
+  };
+  for (size_t i = 0; i < sizeof(k_prefixes); i++) g_first[k_prefixes[i]].kind = K_PFX;
+  g_first[0xC4].kind = g_first[0xC5].kind = g_first[0x62].kind = K_SLOW;  // VEX / EVEX
+  for (unsigned b = 0x40; b < 0x50; b++) g_first[b].kind = K_REX;
+}
+
+static size_t modrm_len(uint8_t m, uint8_t sib) {
+  unsigned mod = m >> 6, rm = m & 7;
+  if (mod == 3) return 1;
+  size_t len = 1 + (mod == 1 ? 1 : mod == 2 ? 4 : 0);
+  if (rm == 4) return len + 1 + (mod == 0 && (sib & 7) == 5 ? 4 : 0);
+  if (mod == 0 && rm == 5) return len + 4;
+  return len;
+}
+
+// Needs LOOKAHEAD readable bytes; 0 when decode_one has to decide.
+// Prefixes only matter through 66 (imm16); F2/F3 pick SSE rows, which are
+// not tabulated anyway.
+static size_t table_len(const uint8_t *p) {
+  if (p[0] == 0xF3 && p[1] == 0x0F && p[2] == 0x1E && p[3] == 0xFA) return 4;  // endbr64
+  size_t i = 0;
+  int opsize16 = 0, rex_w = 0;
+  LenRule r = g_first[p[0]];
+  while (r.kind == K_PFX) {
+    if (i == MAX_PFX) return 0;
+    opsize16 |= p[i] == 0x66;
+    r = g_first[p[++i]];
+  }
+  if (r.kind == K_REX) {
+    rex_w = (p[i] >> 3) & 1;
+    r = g_after_rex[p[++i]];
+  }
+  uint8_t b1 = p[i++];
+  if (r.kind == K_0F) r = g_0f[p[i++]];
+  int imm16 = opsize16 && !rex_w;
+  switch (r.kind) {
+    case K_FIXED:  return i + r.imm;
+    case K_MOVIMM: return i + (rex_w ? 8 : imm16 ? 2 : 4);
+    case K_IMMZ:   return i + (imm16 ? 2 : 4);
+    case K_MODRM:
+      if (!((r.valid >> ((p[i] >> 3) & 7)) & 1)) return i + 1;
+      return i + modrm_len(p[i], p[i + 1]) + (b1 == 0x81 && imm16 ? 2 : r.imm);
+    default:       return 0;
+  }
+}
+
+static size_t slow_len(const uint8_t *p, size_t n) {
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+  Insn in;
+  size_t used = decode_one(&ctx, p, n, 0, &in);
+  return used ? used : 1;
+}
+
+// ---- AVX2 kernel ----
+
+#ifdef BOUNDARY_AVX2
+
+#define V8(x) _mm256_set1_epi8((char)(x))
+
+__attribute__((target("avx2")))
+static __m256i eq(__m256i a, uint8_t b) {
+  return _mm256_cmpeq_epi8(a, V8(b));
+}
+
+// Length of an instruction starting at each of p[0..31], or 0 outside the
+// common set. Reads p[0..35].
+__attribute__((target("avx2")))
+static void block_lengths(const uint8_t *p, uint8_t valid83, uint8_t *len) {
+  __m256i b0 = _mm256_loadu_si256((const __m256i*)(const void*)p);
+  __m256i b1 = _mm256_loadu_si256((const __m256i*)(const void*)(p + 1));
+  __m256i b2 = _mm256_loadu_si256((const __m256i*)(const void*)(p + 2));
+  __m256i b3 = _mm256_loadu_si256((const __m256i*)(const void*)(p + 3));
+  __m256i b4 = _mm256_loadu_si256((const __m256i*)(const void*)(p + 4));
+
+  __m256i rex = eq(_mm256_and_si256(b0, V8(0xF0)), 0x40);
+  __m256i opc = _mm256_blendv_epi8(b0, b1, rex);
+  __m256i x1 = _mm256_blendv_epi8(b1, b2, rex);
+  __m256i x2 = _mm256_blendv_epi8(b2, b3, rex);
+  __m256i x3 = _mm256_blendv_epi8(b3, b4, rex);
+
+  __m256i is0f = eq(opc, 0x0F);
+  __m256i nop = _mm256_and_si256(is0f, eq(x1, 0x1F));
+  __m256i jcc32 = _mm256_and_si256(is0f, eq(_mm256_and_si256(x1, V8(0xF0)), 0x80));
+  __m256i m = _mm256_blendv_epi8(x1, x2, nop);
+  __m256i sib = _mm256_blendv_epi8(x2, x3, nop);
+
+  // ModRM + SIB + displacement (modrm_len)
+  __m256i mod = _mm256_and_si256(_mm256_srli_epi16(m, 6), V8(3));
+  __m256i reg = _mm256_and_si256(_mm256_srli_epi16(m, 3), V8(7));
+  __m256i rm = _mm256_and_si256(m, V8(7));
+  __m256i mod0 = eq(mod, 0), mod3 = eq(mod, 3);
+  __m256i rm4 = eq(rm, 4);
+  __m256i disp = _mm256_or_si256(_mm256_and_si256(eq(mod, 1), V8(1)), _mm256_and_si256(eq(mod, 2), V8(4)));
+  __m256i d32 = _mm256_and_si256(mod0, _mm256_or_si256(eq(rm, 5),
+                  _mm256_and_si256(rm4, eq(_mm256_and_si256(sib, V8(7)), 5))));
+  disp = _mm256_or_si256(disp, _mm256_and_si256(d32, V8(4)));
+  __m256i has_sib = _mm256_andnot_si256(mod3, _mm256_and_si256(rm4, V8(1)));
+  __m256i mlen = _mm256_add_epi8(V8(1), _mm256_add_epi8(has_sib, disp));
+
+  __m256i alu = _mm256_or_si256(_mm256_or_si256(eq(opc, 0x89), eq(opc, 0x8B)),
+                                _mm256_or_si256(eq(opc, 0x8D), eq(opc, 0x85)));
+  alu = _mm256_or_si256(alu, _mm256_or_si256(_mm256_or_si256(eq(opc, 0x31), eq(opc, 0x39)),
+                                             _mm256_or_si256(eq(opc, 0x01), eq(opc, 0x29))));
+  // ModRM.reg -> 0xFF when 83 /reg reads its operand
+  __m256i vtab = _mm256_setr_epi8(
+    (char)(valid83 & 1 ? 0xFF : 0), (char)(valid83 & 2 ? 0xFF : 0), (char)(valid83 & 4 ? 0xFF : 0),
+    (char)(valid83 & 8 ? 0xFF : 0), (char)(valid83 & 16 ? 0xFF : 0), (char)(valid83 & 32 ? 0xFF : 0),
+    (char)(valid83 & 64 ? 0xFF : 0), (char)(valid83 & 128 ? 0xFF : 0), 0, 0, 0, 0, 0, 0, 0, 0,
+    (char)(valid83 & 1 ? 0xFF : 0), (char)(valid83 & 2 ? 0xFF : 0), (char)(valid83 & 4 ? 0xFF : 0),
+    (char)(valid83 & 8 ? 0xFF : 0), (char)(valid83 & 16 ? 0xFF : 0), (char)(valid83 & 32 ? 0xFF : 0),
+    (char)(valid83 & 64 ? 0xFF : 0), (char)(valid83 & 128 ? 0xFF : 0), 0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i g83 = eq(opc, 0x83);
+  __m256i ok83 = _mm256_shuffle_epi8(vtab, reg);
+  __m256i rel32 = _mm256_or_si256(eq(opc, 0xE8), eq(opc, 0xE9));
+  __m256i rel8 = eq(_mm256_and_si256(opc, V8(0xF0)), 0x70);
+  __m256i one = _mm256_or_si256(eq(opc, 0xC3), eq(_mm256_and_si256(opc, V8(0xF0)), 0x50));
+
+  __m256i l = _mm256_and_si256(alu, _mm256_add_epi8(mlen, V8(1)));
+  l = _mm256_or_si256(l, _mm256_and_si256(g83,
+        _mm256_blendv_epi8(V8(2), _mm256_add_epi8(mlen, V8(2)), ok83)));
+  l = _mm256_or_si256(l, _mm256_and_si256(nop, _mm256_add_epi8(mlen, V8(2))));
+  l = _mm256_or_si256(l, _mm256_and_si256(jcc32, V8(6)));
+  l = _mm256_or_si256(l, _mm256_and_si256(rel32, V8(5)));
+  l = _mm256_or_si256(l, _mm256_and_si256(rel8, V8(2)));
+  l = _mm256_or_si256(l, _mm256_and_si256(one, V8(1)));
+  // the REX byte counts wherever a length was found
+  __m256i found = _mm256_andnot_si256(eq(l, 0), rex);
+  l = _mm256_add_epi8(l, _mm256_and_si256(found, V8(1)));
+  _mm256_storeu_si256((__m256i*)(void*)len, l);
+}
+
+#undef V8
+
+// The kernel hard-codes its opcode set; use it only when the tables agree.
+static int kernel_agrees(void) {
+  static const uint8_t k_alu[] = { 0x89, 0x8B, 0x8D, 0x85, 0x31, 0x39, 0x01, 0x29 };
+  for (size_t i = 0; i < sizeof(k_alu); i++) {
+    LenRule r = g_after_rex[k_alu[i]];
+    if (r.kind != K_MODRM || r.imm != 0 || r.valid != 0xFF) return 0;
+  }
+  if (g_after_rex[0x83].kind != K_MODRM || g_after_rex[0x83].imm != 1) return 0;
+  if (g_0f[0x1F].kind != K_MODRM || g_0f[0x1F].imm != 0 || g_0f[0x1F].valid != 0xFF) return 0;
+  for (unsigned b = 0; b < 16; b++) {
+    if (g_after_rex[0x70 + b].kind != K_FIXED || g_after_rex[0x70 + b].imm != 1) return 0;
+    if (g_after_rex[0x50 + b].kind != K_FIXED || g_after_rex[0x50 + b].imm != 0) return 0;
+    if (g_0f[0x80 + b].kind != K_FIXED || g_0f[0x80 + b].imm != 4) return 0;
+  }
+  return g_after_rex[0xE8].kind == K_FIXED && g_after_rex[0xE8].imm == 4 &&
+         g_after_rex[0xE9].kind == K_FIXED && g_after_rex[0xE9].imm == 4 &&
+         g_after_rex[0xC3].kind == K_FIXED && g_after_rex[0xC3].imm == 0;
+}
+
+#endif
+
+static void init_once(void) {
+  build_tables();
+#ifdef BOUNDARY_AVX2
+  __builtin_cpu_init();
+  g_simd = __builtin_cpu_supports("avx2") && kernel_agrees();
+#endif
+}
+
+// ---- sweep ----
+
+// Visits instruction starts from p[0] until the one covering target (or the
+// end); marks them in bits when non-NULL. Returns that start, or n.
+static size_t sweep(const uint8_t *p, size_t n, size_t target, uint64_t *bits, size_t *count) {
+  pthread_once(&g_once, init_once);
+#ifdef BOUNDARY_AVX2
+  uint8_t lens[BLOCK];
+  size_t blk = SIZE_MAX;
+  const uint8_t valid83 = g_after_rex[0x83].valid;
+#endif
+  size_t pos = 0, cnt = 0;
+  while (pos < n) {
+    size_t len = 0;
+#ifdef BOUNDARY_AVX2
+    if (g_simd && (pos | (BLOCK - 1)) + 1 + LOOKAHEAD <= n) {
+      size_t b = pos & ~(size_t)(BLOCK - 1);
+      if (b != blk) {
+        block_lengths(p + b, valid83, lens);
+        blk = b;
+      }
+      len = lens[pos - b];
+    }
+#endif
+    if (!len && pos + LOOKAHEAD <= n) len = table_len(p + pos);
+    if (!len) len = slow_len(p + pos, n - pos);
+    if (bits) bits[pos >> 6] |= 1ull << (pos & 63);
+    cnt++;
+    if (target < pos + len) break;
+    pos += len;
+  }
+  if (count) *count = cnt;
+  return pos < n ? pos : n;
+}
+
+size_t insn_boundaries(const uint8_t *p, size_t n, uint64_t *bits) {
+  memset(bits, 0, ((n + 63) / 64) * sizeof(uint64_t));
+  size_t count = 0;
+  sweep(p, n, SIZE_MAX, bits, &count);
+  return count;
+}
+
+size_t insn_sync(const uint8_t *p, size_t n, size_t target) {
+  if (target >= n) return n;
+  return sweep(p, n, target, NULL, NULL);
+}
@@ -0,0 +1,394 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/callgraph.h"
+#include "opdump/decode.h"
+#include "opdump/arena.h"
+
+enum { CG_BATCH = 4096 };
+
+static const char k_magic[8] = { 'O', 'P', 'D', 'C', 'G', '0', '1', '\n' };
+
+static const char *const k_formats[] = { "", "text", "dot", "bin" };
+
+int callgraph_format(const char *name) {
+  for (int i = CG_TEXT; i <= CG_BIN; i++) {
+    if (strcmp(name, k_formats[i]) == 0) return i;
+  }
+  return -1;
+}
+
+// ---- nodes ----
+
+static int cmp_region(const void *a, const void *b) {
+  const Region *x = (const Region*)a, *y = (const Region*)b;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static size_t collect_regions(const Image *img, Region **out) {
+  Arena *sa = arena_thread();
+  Region *all = NULL;
+  size_t n = 0;
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+    Region *na = (Region*)realloc(all, (n + nr + 1) * sizeof(Region));
+    if (!na) { arena_reset(sa, mark); break; }
+    all = na;
+    if (nr) memcpy(all + n, regs, nr * sizeof(Region));
+    n += nr;
+    arena_reset(sa, mark);
+  }
+  if (n) qsort(all, n, sizeof(Region), cmp_region);
+  *out = all;
+  return n;
+}
+
+// Node holding addr, or UINT32_MAX.
+static uint32_t node_at(const CgNode *v, size_t n, uint64_t addr) {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (v[mid].addr <= addr) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == 0 || addr - v[lo - 1].addr >= v[lo - 1].size) return UINT32_MAX;
+  return (uint32_t)(lo - 1);
+}
+
+// ---- edges (one worker per node range) ----
+
+typedef struct {
+  const Image *img;
+  const Region *regs;
+  CgNode *nodes;
+  size_t nnodes;
+  size_t n0, n1;        // node range of this worker
+  uint32_t *count;      // edges per node of the range
+  CgEdge *edge;         // edges of the range, in node order
+  size_t nedges, cap;
+  uint64_t *site;       // callee << 1 | tail, one function at a time
+  size_t nsite, site_cap;
+  int failed;
+} CgPart;
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+static void add_site(CgPart *p, uint32_t callee, int tail) {
+  if (p->nsite == p->site_cap) {
+    size_t nc = p->site_cap ? p->site_cap * 2 : 64;
+    uint64_t *ns = (uint64_t*)realloc(p->site, nc * sizeof(uint64_t));
+    if (!ns) { p->failed = 1; return; }
+    p->site = ns;
+    p->site_cap = nc;
+  }
+  p->site[p->nsite++] = ((uint64_t)callee << 1) | (uint64_t)tail;
+}
+
+// Sorts the function's sites and appends one edge per callee.
+static uint32_t flush_sites(CgPart *p) {
+  if (p->nsite) qsort(p->site, p->nsite, sizeof(uint64_t), cmp_u64);
+  uint32_t added = 0;
+  for (size_t i = 0; i < p->nsite; i++) {
+    uint32_t callee = (uint32_t)(p->site[i] >> 1);
+    if (added == 0 || p->edge[p->nedges - 1].callee != callee) {
+      if (p->nedges == p->cap) {
+        size_t nc = p->cap ? p->cap * 2 : 1024;
+        CgEdge *ne = (CgEdge*)realloc(p->edge, nc * sizeof(CgEdge));
+        if (!ne) { p->failed = 1; break; }
+        p->edge = ne;
+        p->cap = nc;
+      }
+      CgEdge *e = &p->edge[p->nedges++];
+      e->callee = callee;
+      e->calls = e->tails = 0;
+      added++;
+    }
+    if (p->site[i] & 1) p->edge[p->nedges - 1].tails++;
+    else p->edge[p->nedges - 1].calls++;
+  }
+  p->nsite = 0;
+  return added;
+}
+
+// ET_REL: the displacement of in (rel8 or rel32) still holds an unresolved
+// relocation (an external symbol).
+static int unresolved(const Image *img, const Insn *in) {
+  if (!img->reloc_count || !in->rel_width) return 0;
+  uint64_t field = in->addr + in->size - in->rel_width;
+  size_t r = elf_rel_lower_bound(img->relocs, img->reloc_count, field);
+  return r < img->reloc_count && img->relocs[r].addr == field && !img->relocs[r].applied;
+}
+
+static void* build_part(void *arg) {
+  CgPart *p = (CgPart*)arg;
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, CG_BATCH * sizeof(Insn));
+  if (!batch) { p->failed = 1; return NULL; }
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  for (size_t i = p->n0; i < p->n1 && !p->failed; i++) {
+    CgNode *fn = &p->nodes[i];
+    const uint8_t *code = p->img->buf + p->regs[i].offset;
+    uint64_t off = 0;
+    while (off < fn->size) {
+      size_t used = 0;
+      size_t got = decode_batch(&ctx, code + off, (size_t)(fn->size - off), fn->addr + off,
+                                batch, CG_BATCH, &used);
+      off += used;
+      for (size_t k = 0; k < got; k++) {
+        const Insn *in = &batch[k];
+        switch (in->op) {
+          case OP_CALL_RM: fn->indirect++; break;
+          case OP_JMP_RM:  fn->ind_jumps++; break;
+          case OP_CALL_REL: {
+            uint32_t t = node_at(p->nodes, p->nnodes, (uint64_t)in->ops[0].imm);
+            if (t == UINT32_MAX || unresolved(p->img, in)) fn->ext_calls++;
+            else add_site(p, t, 0);
+            break;
+          }
+          case OP_JMP_REL: case OP_JCC_REL: {
+            uint64_t tgt = (uint64_t)in->ops[0].imm;
+            if (unresolved(p->img, in)) { fn->ext_calls++; break; }
+            if (tgt - fn->addr < fn->size) break;
+            uint32_t t = node_at(p->nodes, p->nnodes, tgt);
+            if (t != UINT32_MAX && t != i) add_site(p, t, 1);
+            break;
+          }
+          default: break;
+        }
+      }
+    }
+    p->count[i - p->n0] = flush_sites(p);
+  }
+  arena_reset(sa, batch_mark);
+  return NULL;
+}
+
+int callgraph_build(const Image *img, size_t threads, CallGraph *cg) {
+  memset(cg, 0, sizeof(*cg));
+  Region *regs = NULL;
+  size_t n = collect_regions(img, &regs);
+  if (!regs || n >= UINT32_MAX) { free(regs); return 0; }
+
+  cg->nnodes = n;
+  cg->nodes = (CgNode*)calloc(n ? n : 1, sizeof(CgNode));
+  cg->row = (uint32_t*)calloc(n + 1, sizeof(uint32_t));
+  if (threads == 0) threads = 1;
+  if (threads > n) threads = n ? n : 1;
+  CgPart *parts = (CgPart*)calloc(threads, sizeof(CgPart));
+  uint32_t *count = (uint32_t*)calloc(n ? n : 1, sizeof(uint32_t));
+  if (!cg->nodes || !cg->row || !parts || !count) {
+    free(parts); free(count); free(regs);
+    callgraph_free(cg);
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    cg->nodes[i].addr = regs[i].addr;
+    cg->nodes[i].size = regs[i].size;
+    cg->nodes[i].name = regs[i].name;
+  }
+
+  // split by bytes so that one huge function does not leave threads idle
+  uint64_t total = 0;
+  for (size_t i = 0; i < n; i++) total += regs[i].size;
+  size_t at = 0;
+  uint64_t done = 0;
+  for (size_t t = 0; t < threads; t++) {
+    CgPart *p = &parts[t];
+    p->img = img;
+    p->regs = regs;
+    p->nodes = cg->nodes;
+    p->nnodes = n;
+    p->count = count + at;
+    p->n0 = at;
+    uint64_t goal = total / threads * (t + 1);
+    while (at < n && (t + 1 == threads || done < goal)) done += regs[at++].size;
+    p->n1 = at;
+  }
+
+  pthread_t *th = (pthread_t*)calloc(threads, sizeof(pthread_t));
+  int *started = (int*)calloc(threads, sizeof(int));
+  for (size_t t = 1; th && started && t < threads; t++) {
+    started[t] = pthread_create(&th[t], NULL, build_part, &parts[t]) == 0;
+  }
+  build_part(&parts[0]);
+  for (size_t t = 1; t < threads; t++) {
+    if (started && started[t]) pthread_join(th[t], NULL);
+    else build_part(&parts[t]);
+  }
+  free(th);
+  free(started);
+
+  int ok = 1;
+  size_t ne = 0;
+  for (size_t t = 0; t < threads; t++) {
+    ok &= !parts[t].failed;
+    ne += parts[t].nedges;
+  }
+  if (ok && ne < UINT32_MAX) cg->edge = (CgEdge*)malloc((ne ? ne : 1) * sizeof(CgEdge));
+  if (cg->edge) {
+    for (size_t t = 0; t < threads; t++) {
+      if (parts[t].nedges) {
+        memcpy(cg->edge + cg->nedges, parts[t].edge, parts[t].nedges * sizeof(CgEdge));
+      }
+      cg->nedges += parts[t].nedges;
+    }
+    for (size_t i = 0; i < n; i++) cg->row[i + 1] = cg->row[i] + count[i];
+    for (size_t e = 0; e < cg->nedges; e++) cg->nodes[cg->edge[e].callee].callers++;
+  }
+  for (size_t t = 0; t < threads; t++) {
+    free(parts[t].edge);
+    free(parts[t].site);
+  }
+  free(parts);
+  free(count);
+  free(regs);
+  if (!cg->edge) {
+    callgraph_free(cg);
+    return 0;
+  }
+  return 1;
+}
+
+void callgraph_free(CallGraph *cg) {
+  free(cg->nodes);
+  free(cg->row);
+  free(cg->edge);
+  memset(cg, 0, sizeof(*cg));
+}
+
+// ---- output ----
+
+static void write_text(FILE *out, const CallGraph *cg, const char *label) {
+  fprintf(out, "# address           callees callers   calls    tail   indir    ijmp     ext  function\n");
+  uint64_t calls = 0, tails = 0, indir = 0, ijmp = 0, ext = 0;
+  for (size_t i = 0; i < cg->nnodes; i++) {
+    const CgNode *nd = &cg->nodes[i];
+    uint64_t c = 0, t = 0;
+    for (uint32_t e = cg->row[i]; e < cg->row[i + 1]; e++) {
+      c += cg->edge[e].calls;
+      t += cg->edge[e].tails;
+    }
+    calls += c; tails += t; indir += nd->indirect; ijmp += nd->ind_jumps; ext += nd->ext_calls;
+    if (cg->row[i] == cg->row[i + 1] && !nd->callers && !nd->indirect && !nd->ind_jumps &&
+        !nd->ext_calls) continue;
+    char gap[40];
+    if (label) fprintf(out, "%s: ", label);
+    fprintf(out, "%016llx %8u %7u %7llu %7llu %7u %7u %7u  %s\n", (unsigned long long)nd->addr,
+      cg->row[i + 1] - cg->row[i], nd->callers, (unsigned long long)c, (unsigned long long)t,
+      nd->indirect, nd->ind_jumps, nd->ext_calls, region_name(nd->name, nd->addr, gap, sizeof(gap)));
+  }
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# %zu nodes, %zu edges, %llu calls, %llu tail, %llu indirect calls, "
+               "%llu indirect jumps, %llu external\n",
+    cg->nnodes, cg->nedges, (unsigned long long)calls, (unsigned long long)tails,
+    (unsigned long long)indir, (unsigned long long)ijmp, (unsigned long long)ext);
+}
+
+static void dot_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') fputc('\\', out);
+    fputc(*s, out);
+  }
+  fputc('"', out);
+}
+
+static void write_dot(FILE *out, const CallGraph *cg, const char *label) {
+  fprintf(out, "digraph ");
+  dot_string(out, label ? label : "callgraph");
+  fprintf(out, " {\n  node [shape=box];\n");
+  for (size_t i = 0; i < cg->nnodes; i++) {
+    const CgNode *nd = &cg->nodes[i];
+    if (cg->row[i] == cg->row[i + 1] && !nd->callers) continue;
+    char gap[40];
+    fprintf(out, "  n%zu [label=", i);
+    dot_string(out, region_name(nd->name, nd->addr, gap, sizeof(gap)));
+    fprintf(out, "];\n");
+  }
+  for (size_t i = 0; i < cg->nnodes; i++) {
+    for (uint32_t e = cg->row[i]; e < cg->row[i + 1]; e++) {
+      const CgEdge *ed = &cg->edge[e];
+      if (ed->calls) {
+        fprintf(out, "  n%zu -> n%u", i, ed->callee);
+        if (ed->calls > 1) fprintf(out, " [label=\"%u\"]", ed->calls);
+        fprintf(out, ";\n");
+      }
+      if (ed->tails) {
+        fprintf(out, "  n%zu -> n%u [style=dashed", i, ed->callee);
+        if (ed->tails > 1) fprintf(out, ", label=\"%u\"", ed->tails);
+        fprintf(out, "];\n");
+      }
+    }
+  }
+  fprintf(out, "}\n");
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static int write_bin(FILE *out, const CallGraph *cg) {
+  uint64_t strings = 0;
+  for (size_t i = 0; i < cg->nnodes; i++) {
+    if (cg->nodes[i].name) strings += strlen(cg->nodes[i].name) + 1;
+  }
+  if (strings >= UINT32_MAX) return 0;
+
+  uint8_t hdr[32];
+  memcpy(hdr, k_magic, 8);
+  put64(hdr + 8, cg->nnodes);
+  put64(hdr + 16, cg->nedges);
+  put64(hdr + 24, strings);
+  int ok = fwrite(hdr, 1, sizeof(hdr), out) == sizeof(hdr);
+
+  uint8_t rec[32];
+  uint32_t name_off = 0;
+  for (size_t i = 0; ok && i < cg->nnodes; i++) {
+    const CgNode *nd = &cg->nodes[i];
+    put64(rec, nd->addr);
+    put32(rec + 8, nd->size < UINT32_MAX ? (uint32_t)nd->size : UINT32_MAX);
+    put32(rec + 12, nd->name ? name_off : UINT32_MAX);
+    put32(rec + 16, nd->indirect);
+    put32(rec + 20, nd->ind_jumps);
+    put32(rec + 24, nd->ext_calls);
+    put32(rec + 28, nd->callers);
+    if (nd->name) name_off += (uint32_t)strlen(nd->name) + 1;
+    ok = fwrite(rec, 1, 32, out) == 32;
+  }
+  for (size_t i = 0; ok && i <= cg->nnodes; i++) {
+    put32(rec, cg->row[i]);
+    ok = fwrite(rec, 1, 4, out) == 4;
+  }
+  for (size_t e = 0; ok && e < cg->nedges; e++) {
+    put32(rec, cg->edge[e].callee);
+    put32(rec + 4, cg->edge[e].calls);
+    put32(rec + 8, cg->edge[e].tails);
+    ok = fwrite(rec, 1, 12, out) == 12;
+  }
+  for (size_t i = 0; ok && i < cg->nnodes; i++) {
+    const char *s = cg->nodes[i].name;
+    if (s) ok = fwrite(s, 1, strlen(s) + 1, out) == strlen(s) + 1;
+  }
+  return ok;
+}
+
+int callgraph_write(FILE *out, const CallGraph *cg, CgFormat fmt, const char *label) {
+  switch (fmt) {
+    case CG_TEXT: write_text(out, cg, label); return 1;
+    case CG_DOT:  write_dot(out, cg, label); return 1;
+    case CG_BIN:  return write_bin(out, cg);
+    default:      return 0;
+  }
+}
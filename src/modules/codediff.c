@@ -0,0 +1,370 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/codediff.h"
+#include "opdump/image.h"
+#include "opdump/decode.h"
+#include "opdump/format.h"
+#include "opdump/flow.h"
+#include "opdump/arena.h"
+
+enum { DIFF_BATCH = 4096, DIFF_MAX_CELLS = 4 << 20 };
+
+typedef struct {
+  const char *name;
+  uint64_t addr, size, offset;
+  uint64_t hash;
+  uint64_t insns;
+  int matched;
+} DiffFunc;
+
+typedef struct {
+  const char *path;
+  Image img;
+  int err;
+  ElfSym *objs;       // data symbols, for RIP-relative targets
+  size_t nobj;
+  DiffFunc *f;
+  size_t nf;
+} DiffSide;
+
+typedef struct {
+  Insn ins;           // addr is the function offset; targets normalized
+  const char *ref;    // symbol for an out-of-function target, or NULL
+  uint64_t ref_off;
+  uint64_t hash;
+} NormInsn;
+
+// ---- normalization ----
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+  h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  return h * 0xff51afd7ed558ccdull;
+}
+
+static uint64_t hash_str(const char *s) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (; s && *s; s++) h = (h ^ (uint8_t)*s) * 0x100000001b3ull;
+  return h;
+}
+
+// Rewrites an absolute code/data address into function-relative or
+// symbol-relative form (function, then data symbols). Returns the value to
+// keep in the instruction.
+static uint64_t norm_target(const DiffSide *sd, const DiffFunc *fn, uint64_t tgt, NormInsn *o) {
+  if (tgt >= fn->addr && tgt < fn->addr + fn->size) return tgt - fn->addr;
+  const ElfSym *s = elf_sym_lookup(sd->img.syms, sd->img.sym_count, tgt);
+  if (!s) s = elf_sym_lookup(sd->objs, sd->nobj, tgt);
+  if (s) {
+    o->ref = s->name;
+    o->ref_off = tgt - s->addr;
+  } else {
+    o->ref = "";      // printed as <data>
+  }
+  return 0;
+}
+
+static void norm_insn(const DiffSide *sd, const DiffFunc *fn, const Insn *in, NormInsn *o) {
+  o->ins = *in;
+  o->ins.addr = in->addr - fn->addr;
+  o->ins.rel = 0;
+  o->ref = NULL;
+  o->ref_off = 0;
+
+  Insn *n = &o->ins;
+  if ((n->op == OP_JCC_REL || n->op == OP_JMP_REL || n->op == OP_CALL_REL) &&
+      n->op_count == 1 && n->ops[0].kind == O_IMM) {
+    n->ops[0].imm = (int64_t)norm_target(sd, fn, (uint64_t)in->ops[0].imm, o);
+  }
+  for (uint8_t i = 0; i < n->op_count; i++) {
+    Operand *op = &n->ops[i];
+    if (op->kind != O_MEM || op->mem.base != MEM_RIP) continue;
+    uint64_t tgt = in->addr + in->size + (uint64_t)(int64_t)op->mem.disp;
+    op->mem.disp = (int32_t)norm_target(sd, fn, tgt, o);
+  }
+
+  uint64_t h = mix(0, (uint64_t)n->op);
+  h = mix(h, n->has_cc ? (uint64_t)n->cc + 1 : 0);
+  h = mix(h, n->op_count);
+  for (uint8_t i = 0; i < n->op_count; i++) {
+    const Operand *op = &n->ops[i];
+    h = mix(h, ((uint64_t)op->kind << 16) | op->width);
+    switch (op->kind) {
+      case O_REG: case O_KREG: h = mix(h, op->reg); break;
+      case O_IMM: h = mix(h, (uint64_t)op->imm); break;
+      case O_MEM:
+        h = mix(h, ((uint64_t)op->mem.base << 16) | ((uint64_t)op->mem.index << 8) | op->mem.scale);
+        h = mix(h, (uint64_t)(int64_t)op->mem.disp);
+        break;
+      default: break;
+    }
+  }
+  h = mix(h, ((uint64_t)n->enc << 40) | ((uint64_t)n->vl << 24) | ((uint64_t)n->vesize << 16) |
+             ((uint64_t)n->kmask << 8) | ((uint64_t)n->zeroing << 4) | n->bcast);
+  // raw bytes of undecoded data are all we have to compare
+  if (n->op == OP_INVALID) h = mix(h, n->bytes[0]);
+  if (o->ref) h = mix(mix(h, hash_str(o->ref)), o->ref_off);
+  o->hash = h;
+}
+
+// ---- per-file pass (runs on its own thread) ----
+
+static void* side_load(void *arg) {
+  DiffSide *sd = (DiffSide*)arg;
+  sd->err = image_load(sd->path, &sd->img);
+  if (sd->err != IMG_OK) return NULL;
+  image_load_symbols(&sd->img);
+  sd->nobj = elf64_collect_object_symbols(sd->img.buf, sd->img.n, &sd->img.arena, &sd->objs);
+
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, DIFF_BATCH * sizeof(Insn));
+  if (!batch) { sd->err = IMG_ERR_READ; return NULL; }
+  size_t cap = 0;
+
+  for (size_t s = 0; s < sd->img.seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&sd->img.segs[s], sd->img.syms, sd->img.sym_count, sa, &regs);
+    for (size_t r = 0; r < nr; r++) {
+      if (!regs[r].name) continue;
+      if (sd->nf == cap) {
+        size_t nc = cap ? cap * 2 : 256;
+        DiffFunc *nfn = (DiffFunc*)realloc(sd->f, nc * sizeof(DiffFunc));
+        if (!nfn) break;
+        sd->f = nfn;
+        cap = nc;
+      }
+      DiffFunc *fn = &sd->f[sd->nf++];
+      memset(fn, 0, sizeof(*fn));
+      fn->name = regs[r].name;
+      fn->addr = regs[r].addr;
+      fn->size = regs[r].size;
+      fn->offset = regs[r].offset;
+
+      DecodeCtx ctx = {0};
+      ctx.is64 = 1;
+      uint64_t h = 0, off = 0;
+      while (off < fn->size) {
+        size_t used = 0;
+        size_t got = decode_batch(&ctx, sd->img.buf + fn->offset + off, (size_t)(fn->size - off),
+                                  fn->addr + off, batch, DIFF_BATCH, &used);
+        off += used;
+        for (size_t k = 0; k < got; k++) {
+          NormInsn ni;
+          norm_insn(sd, fn, &batch[k], &ni);
+          h = mix(h, ni.hash);
+        }
+        fn->insns += got;
+      }
+      fn->hash = mix(h, fn->insns);
+    }
+    arena_reset(sa, mark);
+  }
+  arena_reset(sa, batch_mark);
+  return NULL;
+}
+
+// ---- matching ----
+
+static const DiffFunc *g_sort_base; // qsort has no context argument
+
+static int cmp_by_name(const void *a, const void *b) {
+  const DiffFunc *x = &g_sort_base[*(const size_t*)a], *y = &g_sort_base[*(const size_t*)b];
+  int c = strcmp(x->name, y->name);
+  if (c) return c;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static int cmp_by_hash(const void *a, const void *b) {
+  const DiffFunc *x = &g_sort_base[*(const size_t*)a], *y = &g_sort_base[*(const size_t*)b];
+  if (x->hash != y->hash) return (x->hash > y->hash) - (x->hash < y->hash);
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static size_t* sorted_index(const DiffFunc *f, size_t n, int (*cmp)(const void*, const void*)) {
+  size_t *idx = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+  if (!idx) return NULL;
+  for (size_t i = 0; i < n; i++) idx[i] = i;
+  g_sort_base = f;
+  qsort(idx, n, sizeof(size_t), cmp);
+  return idx;
+}
+
+// ---- instruction diff ----
+
+static int norm_function(const DiffSide *sd, const DiffFunc *fn, Arena *a, NormInsn **out) {
+  InsnVec vec = {0};
+  if (!insn_vec_decode(&vec, sd->img.buf + fn->offset, fn->size, fn->addr)) return -1;
+  NormInsn *v = (NormInsn*)arena_alloc(a, vec.n * sizeof(NormInsn));
+  if (!v) { insn_vec_free(&vec); return -1; }
+  for (size_t i = 0; i < vec.n; i++) norm_insn(sd, fn, &vec.v[i], &v[i]);
+  *out = v;
+  int n = (int)vec.n;
+  insn_vec_free(&vec);
+  return n;
+}
+
+static void print_norm(FILE *out, char tag, const NormInsn *ni) {
+  fprintf(out, "  %c +0x%05llx  ", tag, (unsigned long long)ni->ins.addr);
+  format_intel(out, &ni->ins);
+  if (ni->ref && !ni->ref[0])     fprintf(out, "  <data>");
+  else if (ni->ref && ni->ref_off) fprintf(out, "  <%s+0x%llx>", ni->ref, (unsigned long long)ni->ref_off);
+  else if (ni->ref)                fprintf(out, "  <%s>", ni->ref);
+  fprintf(out, "\n");
+}
+
+// Prefix/suffix trim, then LCS on the middle when it is small enough;
+// otherwise the whole middle is shown as removed + added.
+static void diff_insns(FILE *out, const NormInsn *a, size_t na, const NormInsn *b, size_t nb,
+                       Arena *sa) {
+  size_t pre = 0;
+  while (pre < na && pre < nb && a[pre].hash == b[pre].hash) pre++;
+  size_t suf = 0;
+  while (suf < na - pre && suf < nb - pre && a[na - 1 - suf].hash == b[nb - 1 - suf].hash) suf++;
+
+  const NormInsn *x = a + pre, *y = b + pre;
+  size_t n = na - pre - suf, m = nb - pre - suf;
+
+  uint32_t *t = NULL;
+  if (n && m && (n + 1) * (m + 1) <= DIFF_MAX_CELLS) {
+    t = (uint32_t*)arena_alloc(sa, (n + 1) * (m + 1) * sizeof(uint32_t));
+  }
+  if (!t) {
+    for (size_t i = 0; i < n; i++) print_norm(out, '-', &x[i]);
+    for (size_t j = 0; j < m; j++) print_norm(out, '+', &y[j]);
+    return;
+  }
+
+  // t[i][j] = LCS length of x[i..] and y[j..]
+  const size_t w = m + 1;
+  for (size_t i = n + 1; i-- > 0;) {
+    for (size_t j = m + 1; j-- > 0;) {
+      if (i == n || j == m)               t[i * w + j] = 0;
+      else if (x[i].hash == y[j].hash)    t[i * w + j] = t[(i + 1) * w + j + 1] + 1;
+      else {
+        uint32_t d = t[(i + 1) * w + j], r = t[i * w + j + 1];
+        t[i * w + j] = d > r ? d : r;
+      }
+    }
+  }
+  size_t i = 0, j = 0;
+  while (i < n || j < m) {
+    if (i < n && j < m && x[i].hash == y[j].hash) { i++; j++; }
+    else if (j == m || (i < n && t[(i + 1) * w + j] >= t[i * w + j + 1])) print_norm(out, '-', &x[i++]);
+    else print_norm(out, '+', &y[j++]);
+  }
+}
+
+static void show_change(FILE *out, const DiffSide *o, const DiffFunc *fo,
+                        const DiffSide *nw, const DiffFunc *fn) {
+  fprintf(out, "changed  %s  %llu -> %llu insns\n", fn->name,
+    (unsigned long long)fo->insns, (unsigned long long)fn->insns);
+  Arena *sa = arena_thread();
+  ArenaMark mark = arena_mark(sa);
+  NormInsn *a = NULL, *b = NULL;
+  int na = norm_function(o, fo, sa, &a);
+  int nb = norm_function(nw, fn, sa, &b);
+  if (na >= 0 && nb >= 0) diff_insns(out, a, (size_t)na, b, (size_t)nb, sa);
+  arena_reset(sa, mark);
+}
+
+int code_diff(FILE *out, const char *old_path, const char *new_path) {
+  DiffSide side[2];
+  memset(side, 0, sizeof(side));
+  side[0].path = old_path;
+  side[1].path = new_path;
+
+  pthread_t th;
+  int threaded = pthread_create(&th, NULL, side_load, &side[1]) == 0;
+  side_load(&side[0]);
+  if (threaded) pthread_join(th, NULL);
+  else side_load(&side[1]);
+
+  int rc = 0;
+  for (int k = 0; k < 2; k++) {
+    if (side[k].err != IMG_OK) {
+      fprintf(stderr, "Error: %s: %s\n", side[k].path, image_strerror(side[k].err));
+      rc = side[k].err;
+    }
+  }
+  if (rc) {
+    for (int k = 0; k < 2; k++) { free(side[k].f); image_free(&side[k].img); }
+    return rc;
+  }
+
+  DiffSide *o = &side[0], *nw = &side[1];
+  size_t *matched_new = (size_t*)malloc((o->nf ? o->nf : 1) * sizeof(size_t));
+  size_t *on = sorted_index(o->f, o->nf, cmp_by_name);
+  size_t *nn = sorted_index(nw->f, nw->nf, cmp_by_name);
+  if (!matched_new || !on || !nn) goto done;
+  for (size_t i = 0; i < o->nf; i++) matched_new[i] = (size_t)-1;
+
+  // 1) by name (k-th duplicate pairs with k-th duplicate)
+  for (size_t i = 0, j = 0; i < o->nf && j < nw->nf;) {
+    int c = strcmp(o->f[on[i]].name, nw->f[nn[j]].name);
+    if (c < 0) i++;
+    else if (c > 0) j++;
+    else {
+      matched_new[on[i]] = nn[j];
+      o->f[on[i]].matched = nw->f[nn[j]].matched = 1;
+      i++; j++;
+    }
+  }
+
+  // 2) leftovers by hash: renamed but identical
+  free(on); free(nn);
+  on = sorted_index(o->f, o->nf, cmp_by_hash);
+  nn = sorted_index(nw->f, nw->nf, cmp_by_hash);
+  if (!on || !nn) goto done;
+  size_t renamed = 0;
+  for (size_t i = 0, j = 0; i < o->nf && j < nw->nf;) {
+    const DiffFunc *a = &o->f[on[i]], *b = &nw->f[nn[j]];
+    if (a->matched) { i++; continue; }
+    if (b->matched) { j++; continue; }
+    if (a->hash < b->hash) i++;
+    else if (a->hash > b->hash) j++;
+    else {
+      matched_new[on[i]] = nn[j];
+      o->f[on[i]].matched = nw->f[nn[j]].matched = 2;
+      renamed++;
+      i++; j++;
+    }
+  }
+
+  size_t same = 0, changed = 0, removed = 0, added = 0;
+  fprintf(out, "# diff %s %s\n", old_path, new_path);
+  for (size_t i = 0; i < o->nf; i++) {
+    const DiffFunc *fo = &o->f[i];
+    if (matched_new[i] == (size_t)-1) {
+      fprintf(out, "removed  %s\n", fo->name);
+      removed++;
+      continue;
+    }
+    const DiffFunc *fn = &nw->f[matched_new[i]];
+    if (fo->matched == 2) {
+      fprintf(out, "renamed  %s -> %s\n", fo->name, fn->name);
+    } else if (fo->hash == fn->hash) {
+      same++;
+    } else {
+      show_change(out, o, fo, nw, fn);
+      changed++;
+    }
+  }
+  for (size_t j = 0; j < nw->nf; j++) {
+    if (nw->f[j].matched) continue;
+    fprintf(out, "added    %s\n", nw->f[j].name);
+    added++;
+  }
+  fprintf(out, "# %llu identical, %llu changed, %llu renamed, %llu removed, %llu added\n",
+    (unsigned long long)same, (unsigned long long)changed, (unsigned long long)renamed,
+    (unsigned long long)removed, (unsigned long long)added);
+  rc = (changed || renamed || removed || added) ? 1 : 0;
+
+done:
+  free(matched_new);
+  free(on);
+  free(nn);
+  for (int k = 0; k < 2; k++) { free(side[k].f); image_free(&side[k].img); }
+  return rc;
+}
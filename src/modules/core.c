@@ -0,0 +1,210 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "opdump/core.h"
+#include "opdump/elf64.h"
+#include "opdump/image.h"
+
+static uint32_t rd32le(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static uint64_t rd64le(const uint8_t *p) {
+  return (uint64_t)rd32le(p) | ((uint64_t)rd32le(p+4) << 32);
+}
+
+enum { PT_LOAD = 1, PT_NOTE = 4, PF_X = 1 };
+enum { NT_PRSTATUS = 1, NT_FILE = 0x46494c45 };
+enum { EM_X86_64 = 62 };
+
+// struct elf_prstatus on x86-64: pr_cursig @12, pr_pid @32, pr_reg @112
+// (user_regs_struct: rip is slot 16, rsp slot 19).
+enum { PRS_CURSIG = 12, PRS_PID = 32, PRS_REG = 112, PRS_SIZE = PRS_REG + 27 * 8 };
+enum { REG_RIP = 16, REG_RSP = 19 };
+
+int core_probe(const char *path) {
+  uint8_t h[18];
+  FILE *f = fopen(path, "rb");
+  if (!f) return 0;
+  size_t got = fread(h, 1, sizeof(h), f);
+  fclose(f);
+  // ELF64, little-endian, e_type ET_CORE
+  return got == sizeof(h) && memcmp(h, "\x7f" "ELF", 4) == 0 && h[4] == 2 && h[5] == 1 &&
+         (h[16] | h[17] << 8) == ET_CORE;
+}
+
+// NT_FILE: count, page size, count x (start, end, page offset), count paths.
+static void parse_nt_file(Core *c, const uint8_t *d, uint64_t n) {
+  if (n < 16) return;
+  uint64_t count = rd64le(d), page = rd64le(d + 8);
+  if (count == 0 || count > (n - 16) / 24) return;
+  CoreFile *f = (CoreFile*)arena_alloc(&c->arena, (size_t)count * sizeof(CoreFile));
+  if (!f) return;
+
+  const char *name = (const char*)d + 16 + count * 24;
+  const char *end = (const char*)d + n;
+  size_t k = 0;
+  for (uint64_t i = 0; i < count && name < end; i++) {
+    const uint8_t *e = d + 16 + i * 24;
+    size_t len = strnlen(name, (size_t)(end - name));
+    if (name + len == end) break;   // unterminated
+    f[k].start = rd64le(e);
+    f[k].end = rd64le(e + 8);
+    f[k].offset = rd64le(e + 16) * page;
+    f[k].path = name;
+    k++;
+    name += len + 1;
+  }
+  c->files = f;
+  c->file_count = k;
+}
+
+static void parse_notes(Core *c, const uint8_t *d, uint64_t n, size_t *thread_cap) {
+  uint64_t off = 0;
+  while (off + 12 <= n) {
+    uint32_t namesz = rd32le(d + off), descsz = rd32le(d + off + 4), type = rd32le(d + off + 8);
+    uint64_t desc = off + 12 + (((uint64_t)namesz + 3) & ~(uint64_t)3);
+    uint64_t next = desc + (((uint64_t)descsz + 3) & ~(uint64_t)3);
+    if (desc + descsz > n) break;
+    int core_note = namesz == 5 && memcmp(d + off + 12, "CORE", 5) == 0;
+
+    if (core_note && type == NT_FILE && !c->files) {
+      parse_nt_file(c, d + desc, descsz);
+    } else if (core_note && type == NT_PRSTATUS && descsz >= PRS_SIZE) {
+      if (c->thread_count == *thread_cap) {
+        size_t nc = *thread_cap ? *thread_cap * 2 : 16;
+        CoreThread *nt = (CoreThread*)arena_alloc(&c->arena, nc * sizeof(CoreThread));
+        if (!nt) break;
+        if (c->thread_count) memcpy(nt, c->threads, c->thread_count * sizeof(CoreThread));
+        c->threads = nt;
+        *thread_cap = nc;
+      }
+      const uint8_t *p = d + desc;
+      CoreThread *t = &c->threads[c->thread_count++];
+      t->signo = (uint32_t)(p[PRS_CURSIG] | p[PRS_CURSIG + 1] << 8);
+      t->pid = rd32le(p + PRS_PID);
+      t->pc = rd64le(p + PRS_REG + REG_RIP * 8);
+      t->sp = rd64le(p + PRS_REG + REG_RSP * 8);
+    }
+    off = next;
+  }
+}
+
+static const CoreFile* file_at(const Core *c, uint64_t addr) {
+  for (size_t i = 0; i < c->file_count; i++) {
+    if (addr >= c->files[i].start && addr < c->files[i].end) return &c->files[i];
+  }
+  return NULL;
+}
+
+int core_open(const char *path, Core *c) {
+  memset(c, 0, sizeof(*c));
+  c->path = path;
+  arena_init(&c->arena, 0);
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return IMG_ERR_READ;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return IMG_ERR_READ; }
+  void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return IMG_ERR_READ;
+  c->buf = (const uint8_t*)p;
+  c->n = (size_t)st.st_size;
+
+  ElfInfo inf;
+  if (!elf64_parse_info(c->buf, c->n, &inf) || inf.e_type != ET_CORE) {
+    core_close(c);
+    return IMG_ERR_ELF;
+  }
+
+  // notes first: mappings look up their NT_FILE entry
+  size_t thread_cap = 0, nx = 0;
+  for (uint16_t i = 0; i < inf.phnum; i++) {
+    const uint8_t *ph = c->buf + inf.phoff + (uint64_t)i * inf.phentsz;
+    uint64_t off = rd64le(ph + 8), filesz = rd64le(ph + 32);
+    if (rd32le(ph) == PT_NOTE && off <= c->n && filesz <= c->n - off) {
+      parse_notes(c, c->buf + off, filesz, &thread_cap);
+    }
+    if (rd32le(ph) == PT_LOAD && (rd32le(ph + 4) & PF_X)) nx++;
+  }
+  if (inf.e_machine != EM_X86_64) c->thread_count = 0;   // other pr_reg layouts
+
+  c->maps = nx ? (CoreMap*)arena_alloc(&c->arena, nx * sizeof(CoreMap)) : NULL;
+  for (uint16_t i = 0; c->maps && i < inf.phnum; i++) {
+    const uint8_t *ph = c->buf + inf.phoff + (uint64_t)i * inf.phentsz;
+    if (rd32le(ph) != PT_LOAD || !(rd32le(ph + 4) & PF_X)) continue;
+    uint64_t off = rd64le(ph + 8), vaddr = rd64le(ph + 16);
+    uint64_t filesz = rd64le(ph + 32), memsz = rd64le(ph + 40);
+    if (memsz == 0) continue;
+    if (off > c->n) filesz = 0;
+    else if (filesz > c->n - off) filesz = c->n - off;   // truncated core
+    if (filesz > memsz) filesz = memsz;
+
+    CoreMap *m = &c->maps[c->map_count++];
+    m->start = vaddr;
+    m->end = vaddr + memsz;
+    m->offset = off;
+    m->filesz = filesz;
+    m->file = file_at(c, vaddr);
+  }
+  if (c->map_count == 0) {
+    core_close(c);
+    return IMG_ERR_NOEXEC;
+  }
+  return IMG_OK;
+}
+
+void core_close(Core *c) {
+  arena_free(&c->arena);
+  if (c->buf) munmap((void*)c->buf, c->n);
+  c->buf = NULL;
+  c->maps = NULL;
+  c->files = NULL;
+  c->threads = NULL;
+  c->map_count = c->file_count = c->thread_count = 0;
+}
+
+const CoreMap* core_find(const Core *c, uint64_t addr) {
+  for (size_t i = 0; i < c->map_count; i++) {
+    if (addr >= c->maps[i].start && addr < c->maps[i].end) return &c->maps[i];
+  }
+  return NULL;
+}
+
+// [off, off+len) of a file into buf; returns the bytes read.
+static size_t read_file(const char *path, uint64_t off, size_t len, uint8_t *buf) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return 0;
+  size_t got = 0;
+  while (got < len) {
+    ssize_t r = pread(fd, buf + got, len - got, (off_t)(off + got));
+    if (r <= 0) break;
+    got += (size_t)r;
+  }
+  close(fd);
+  return got;
+}
+
+size_t core_read(const Core *c, const CoreMap *m, uint64_t addr, size_t len, uint8_t *buf) {
+  memset(buf, 0, len);
+  if (addr < m->start || addr >= m->end) return 0;
+  if (len > m->end - addr) len = (size_t)(m->end - addr);
+
+  size_t found = 0;
+  uint64_t rel = addr - m->start;
+  if (rel < m->filesz) {
+    size_t k = (size_t)(m->filesz - rel) < len ? (size_t)(m->filesz - rel) : len;
+    memcpy(buf, c->buf + m->offset + rel, k);
+    found = k;
+  }
+  if (found < len && m->file && m->file->path[0] == '/') {
+    uint64_t a = addr + found;
+    found += read_file(m->file->path, m->file->offset + (a - m->file->start), len - found, buf + found);
+  }
+  return found;
+}
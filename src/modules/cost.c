@@ -0,0 +1,463 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/cost.h"
+#include "opdump/flow.h"
+#include "opdump/arena.h"
+
+// ---- profiles ----
+
+#define P(n) (uint16_t)(1u << (n))
+
+// Skylake: p0 p1 p5 p6 compute ports; loads p2/p3, store data p4.
+enum { SKL_P0 = 0, SKL_P1, SKL_P5, SKL_P6 };
+#define SKL_ALU (uint16_t)(P(SKL_P0) | P(SKL_P1) | P(SKL_P5) | P(SKL_P6))
+#define SKL_VEC (uint16_t)(P(SKL_P0) | P(SKL_P1) | P(SKL_P5))
+#define SKL_FP  (uint16_t)(P(SKL_P0) | P(SKL_P1))
+
+static const UarchProfile k_skl = {
+  "skl", 4, 5, 2, 1, (uint16_t)(P(SKL_P0) | P(SKL_P5)),
+  4, { "p0", "p1", "p5", "p6" },
+  {
+    [COST_ALU]    = { 1, 1,  SKL_ALU, 1 },
+    [COST_MOV]    = { 1, 0,  SKL_ALU, 1 },
+    [COST_LEA]    = { 1, 1,  (uint16_t)(P(SKL_P1) | P(SKL_P5)), 1 },
+    [COST_CMOV]   = { 1, 1,  (uint16_t)(P(SKL_P0) | P(SKL_P6)), 1 },
+    [COST_SETCC]  = { 1, 1,  (uint16_t)(P(SKL_P0) | P(SKL_P6)), 1 },
+    [COST_IMUL]   = { 1, 3,  P(SKL_P1), 1 },
+    [COST_DIV]    = { 10, 26, P(SKL_P0), 6 },
+    [COST_BRANCH] = { 1, 0,  (uint16_t)(P(SKL_P0) | P(SKL_P6)), 1 },
+    [COST_CALL]   = { 2, 0,  P(SKL_P6), 1 },
+    [COST_RET]    = { 2, 0,  P(SKL_P6), 1 },
+    [COST_PUSH]   = { 1, 0,  0, 1 },
+    [COST_POP]    = { 1, 0,  0, 1 },
+    [COST_LEAVE]  = { 3, 1,  SKL_ALU, 1 },
+    [COST_NOP]    = { 1, 0,  0, 1 },
+    [COST_VMOV]   = { 1, 0,  SKL_VEC, 1 },
+    [COST_VLOGIC] = { 1, 1,  SKL_VEC, 1 },
+    [COST_VIADD]  = { 1, 1,  SKL_VEC, 1 },
+    [COST_VIMUL]  = { 2, 10, SKL_FP, 1 },
+    [COST_VSHUF]  = { 1, 1,  P(SKL_P5), 1 },
+    [COST_VPERM]  = { 1, 3,  P(SKL_P5), 1 },
+    [COST_FADD]   = { 1, 4,  SKL_FP, 1 },
+    [COST_FMUL]   = { 1, 4,  SKL_FP, 1 },
+    [COST_FMA]    = { 1, 4,  SKL_FP, 1 },
+    [COST_FDIV]   = { 1, 13, P(SKL_P0), 4 },
+    [COST_FSQRT]  = { 1, 16, P(SKL_P0), 6 },
+    [COST_FCMP]   = { 1, 2,  P(SKL_P0), 1 },
+    [COST_MOVD]   = { 1, 2,  (uint16_t)(P(SKL_P0) | P(SKL_P5)), 1 },
+    [COST_KMASK]  = { 1, 1,  (uint16_t)(P(SKL_P0) | P(SKL_P5)), 1 },
+    [COST_VZERO]  = { 4, 0,  0, 1 },
+  }
+};
+
+// Zen 3: ALU0-3 integer, FP0-3 vector pipes; 3 loads and 2 stores per cycle.
+enum { Z3_ALU0 = 0, Z3_ALU1, Z3_ALU2, Z3_ALU3, Z3_FP0, Z3_FP1, Z3_FP2, Z3_FP3 };
+#define Z3_ALU (uint16_t)(P(Z3_ALU0) | P(Z3_ALU1) | P(Z3_ALU2) | P(Z3_ALU3))
+#define Z3_BR  (uint16_t)(P(Z3_ALU0) | P(Z3_ALU3))
+#define Z3_VEC (uint16_t)(P(Z3_FP0) | P(Z3_FP1) | P(Z3_FP2) | P(Z3_FP3))
+
+static const UarchProfile k_zen3 = {
+  "zen3", 6, 4, 3, 2, 0,
+  8, { "alu0", "alu1", "alu2", "alu3", "fp0", "fp1", "fp2", "fp3" },
+  {
+    [COST_ALU]    = { 1, 1,  Z3_ALU, 1 },
+    [COST_MOV]    = { 1, 0,  Z3_ALU, 1 },
+    [COST_LEA]    = { 1, 1,  Z3_ALU, 1 },
+    [COST_CMOV]   = { 1, 1,  Z3_ALU, 1 },
+    [COST_SETCC]  = { 1, 1,  Z3_ALU, 1 },
+    [COST_IMUL]   = { 1, 3,  P(Z3_ALU1), 1 },
+    [COST_DIV]    = { 2, 14, P(Z3_ALU2), 7 },
+    [COST_BRANCH] = { 1, 0,  Z3_BR, 1 },
+    [COST_CALL]   = { 2, 0,  Z3_BR, 1 },
+    [COST_RET]    = { 2, 0,  Z3_BR, 1 },
+    [COST_PUSH]   = { 1, 0,  0, 1 },
+    [COST_POP]    = { 1, 0,  0, 1 },
+    [COST_LEAVE]  = { 2, 1,  Z3_ALU, 1 },
+    [COST_NOP]    = { 1, 0,  0, 1 },
+    [COST_VMOV]   = { 1, 0,  Z3_VEC, 1 },
+    [COST_VLOGIC] = { 1, 1,  Z3_VEC, 1 },
+    [COST_VIADD]  = { 1, 1,  Z3_VEC, 1 },
+    [COST_VIMUL]  = { 1, 3,  P(Z3_FP0), 1 },
+    [COST_VSHUF]  = { 1, 1,  (uint16_t)(P(Z3_FP1) | P(Z3_FP2)), 1 },
+    [COST_VPERM]  = { 1, 3,  (uint16_t)(P(Z3_FP1) | P(Z3_FP2)), 1 },
+    [COST_FADD]   = { 1, 3,  (uint16_t)(P(Z3_FP2) | P(Z3_FP3)), 1 },
+    [COST_FMUL]   = { 1, 3,  (uint16_t)(P(Z3_FP0) | P(Z3_FP1)), 1 },
+    [COST_FMA]    = { 1, 4,  (uint16_t)(P(Z3_FP0) | P(Z3_FP1)), 1 },
+    [COST_FDIV]   = { 1, 13, P(Z3_FP1), 4 },
+    [COST_FSQRT]  = { 1, 14, P(Z3_FP1), 6 },
+    [COST_FCMP]   = { 1, 3,  (uint16_t)(P(Z3_FP2) | P(Z3_FP3)), 1 },
+    [COST_MOVD]   = { 1, 3,  P(Z3_FP2), 1 },
+    [COST_KMASK]  = { 1, 1,  Z3_ALU, 1 },
+    [COST_VZERO]  = { 1, 0,  0, 1 },
+  }
+};
+
+#undef P
+
+const UarchProfile* cost_profile(const char *name) {
+  if (!name || strcmp(name, "skl") == 0) return &k_skl;
+  if (strcmp(name, "zen3") == 0) return &k_zen3;
+  return NULL;
+}
+
+CostClass cost_class(const Insn *in) {
+  switch (in->op) {
+    case OP_MOV:      return COST_MOV;
+    case OP_LEA:      return COST_LEA;
+    case OP_CMOVCC:   return COST_CMOV;
+    case OP_SETCC:    return COST_SETCC;
+    case OP_IMUL:     return COST_IMUL;
+    case OP_DIV: case OP_IDIV: return COST_DIV;
+    case OP_JCC_REL: case OP_JMP_REL: case OP_JMP_RM: return COST_BRANCH;
+    case OP_CALL_REL: case OP_CALL_RM: return COST_CALL;
+    case OP_RET:      return COST_RET;
+    case OP_PUSH:     return COST_PUSH;
+    case OP_POP:      return COST_POP;
+    case OP_LEAVE:    return COST_LEAVE;
+    case OP_NOP: case OP_ENDBR: return COST_NOP;
+
+    case OP_MOVUPS: case OP_MOVUPD: case OP_MOVSS: case OP_MOVSD:
+    case OP_MOVAPS: case OP_MOVAPD: case OP_MOVDQA: case OP_MOVDQU:
+    case OP_MOVQ:
+      return COST_VMOV;
+    case OP_MOVD: case OP_PMOVMSKB: case OP_PEXTRW:
+      return COST_MOVD;
+    case OP_ANDPS: case OP_ANDPD: case OP_ANDNPS: case OP_ANDNPD:
+    case OP_ORPS: case OP_ORPD: case OP_XORPS: case OP_XORPD:
+    case OP_PAND: case OP_PANDN: case OP_POR: case OP_PXOR:
+    case OP_VPTERNLOGD: case OP_VPTERNLOGQ:
+      return COST_VLOGIC;
+    case OP_PADDB: case OP_PADDW: case OP_PADDD: case OP_PADDQ:
+    case OP_PSUBB: case OP_PSUBW: case OP_PSUBD: case OP_PSUBQ:
+    case OP_PCMPEQB: case OP_PCMPEQW: case OP_PCMPEQD:
+    case OP_PSRLW: case OP_PSRLD: case OP_PSRLQ:
+    case OP_PSRAW: case OP_PSRAD: case OP_PSLLW: case OP_PSLLD: case OP_PSLLQ:
+      return COST_VIADD;
+    case OP_PMULLD: case OP_PMULUDQ:
+      return COST_VIMUL;
+    case OP_UNPCKLPS: case OP_UNPCKLPD: case OP_UNPCKHPS: case OP_UNPCKHPD:
+    case OP_SHUFPS: case OP_SHUFPD: case OP_PSHUFD: case OP_PSHUFB: case OP_PALIGNR:
+    case OP_PSHUFHW: case OP_PSHUFLW: case OP_PSRLDQ: case OP_PSLLDQ: case OP_PINSRW:
+      return COST_VSHUF;
+    case OP_VPERMD: case OP_VPERM2F128: case OP_VPERM2I128:
+    case OP_VINSERTF128: case OP_VEXTRACTF128: case OP_VINSERTI128: case OP_VEXTRACTI128:
+    case OP_VBROADCASTSS: case OP_VBROADCASTSD:
+    case OP_VPBROADCASTB: case OP_VPBROADCASTW: case OP_VPBROADCASTD: case OP_VPBROADCASTQ:
+      return COST_VPERM;
+    case OP_ADDPS: case OP_ADDPD: case OP_ADDSS: case OP_ADDSD:
+    case OP_SUBPS: case OP_SUBPD: case OP_SUBSS: case OP_SUBSD:
+    case OP_MINPS: case OP_MINPD: case OP_MINSS: case OP_MINSD:
+    case OP_MAXPS: case OP_MAXPD: case OP_MAXSS: case OP_MAXSD:
+    case OP_CMPPS: case OP_CMPPD: case OP_CMPSS: case OP_CMPSD:
+      return COST_FADD;
+    case OP_MULPS: case OP_MULPD: case OP_MULSS: case OP_MULSD:
+      return COST_FMUL;
+    case OP_VFMADD132PS: case OP_VFMADD132PD: case OP_VFMADD132SS: case OP_VFMADD132SD:
+    case OP_VFMADD213PS: case OP_VFMADD213PD: case OP_VFMADD213SS: case OP_VFMADD213SD:
+    case OP_VFMADD231PS: case OP_VFMADD231PD: case OP_VFMADD231SS: case OP_VFMADD231SD:
+      return COST_FMA;
+    case OP_DIVPS: case OP_DIVPD: case OP_DIVSS: case OP_DIVSD:
+      return COST_FDIV;
+    case OP_SQRTPS: case OP_SQRTPD: case OP_SQRTSS: case OP_SQRTSD:
+      return COST_FSQRT;
+    case OP_UCOMISS: case OP_UCOMISD: case OP_COMISS: case OP_COMISD:
+      return COST_FCMP;
+    case OP_KMOV: case OP_KORTEST:
+      return COST_KMASK;
+    case OP_VZEROUPPER: case OP_VZEROALL:
+      return COST_VZERO;
+    default:
+      return COST_ALU;
+  }
+}
+
+// ---- register dataflow ----
+
+// ids: 0..15 GPR, 16..47 vector, 48..55 k0-7, 56 flags
+enum { R_VEC = 16, R_K = 48, R_FLAGS = 56, R_COUNT = 57 };
+
+typedef uint64_t RegSet;
+
+static int reg_id(const Operand *o) {
+  if (o->kind == O_KREG) return R_K + (o->reg & 7);
+  if (o->kind != O_REG) return -1;
+  if (o->width >= 128) return R_VEC + (o->reg & 31);
+  return o->reg < 16 ? o->reg : -1;
+}
+
+static void add_addr_regs(const Operand *o, RegSet *rs) {
+  if (o->kind != O_MEM) return;
+  if (o->mem.base < 16)  *rs |= (RegSet)1 << o->mem.base;
+  if (o->mem.index < 16) *rs |= (RegSet)1 << o->mem.index;
+}
+
+static int writes_flags(Op op) {
+  switch (op) {
+    case OP_ADD: case OP_SUB: case OP_AND: case OP_OR: case OP_XOR:
+    case OP_CMP: case OP_TEST: case OP_IMUL:
+    case OP_DIV: case OP_IDIV: case OP_XADD: case OP_CMPXCHG:
+    case OP_UCOMISS: case OP_UCOMISD: case OP_COMISS: case OP_COMISD:
+    case OP_KORTEST:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int reads_flags(Op op) {
+  return op == OP_JCC_REL || op == OP_CMOVCC || op == OP_SETCC;
+}
+
+// ops[0] is only a source (or there is no register result)
+static int no_dst(Op op) {
+  switch (op) {
+    case OP_CMP: case OP_TEST: case OP_DIV: case OP_IDIV:
+    case OP_UCOMISS: case OP_UCOMISD: case OP_COMISS: case OP_COMISD: case OP_KORTEST:
+    case OP_JCC_REL: case OP_JMP_REL: case OP_JMP_RM:
+    case OP_CALL_REL: case OP_CALL_RM: case OP_RET:
+    case OP_PUSH: case OP_NOP: case OP_ENDBR: case OP_CLI:
+    case OP_VZEROUPPER: case OP_VZEROALL:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int is_zero_idiom(const Insn *in) {
+  if (in->op_count < 2) return 0;
+  const Operand *a = &in->ops[in->op_count - 2], *b = &in->ops[in->op_count - 1];
+  if (a->kind != O_REG || b->kind != O_REG || a->reg != b->reg) return 0;
+  switch (in->op) {
+    case OP_XOR: case OP_SUB: case OP_PXOR: case OP_XORPS: case OP_XORPD:
+    case OP_PSUBB: case OP_PSUBW: case OP_PSUBD: case OP_PSUBQ:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+typedef struct {
+  RegSet reads;      // register sources
+  RegSet addr;       // address registers of memory operands
+  int dst;          // written register id, -1 none
+  int dst_flags;
+  int load, store;  // memory source / destination
+} InsnDeps;
+
+static void insn_deps(const Insn *in, CostClass cls, InsnDeps *d) {
+  memset(d, 0, sizeof(*d));
+  d->dst = -1;
+  d->dst_flags = writes_flags(in->op);
+  if (reads_flags(in->op)) d->reads |= (RegSet)1 << R_FLAGS;
+
+  for (uint8_t i = 0; i < in->op_count; i++) add_addr_regs(&in->ops[i], &d->addr);
+  for (uint8_t i = 0; i < in->op_count; i++) {
+    if (in->ops[i].kind != O_MEM) continue;
+    if (i == 0 && !no_dst(in->op) && in->op != OP_LEA) d->store = 1;
+    if (in->op == OP_LEA || in->op == OP_NOP) continue;
+    // plain stores do not read memory
+    if (i == 0 && (cls == COST_MOV || cls == COST_VMOV || cls == COST_MOVD || in->op == OP_SETCC)) continue;
+    d->load = 1;
+  }
+  if (cls == COST_POP || cls == COST_RET || cls == COST_LEAVE) d->load = 1;
+  if (cls == COST_PUSH || cls == COST_CALL) d->store = 1;
+
+  if (is_zero_idiom(in)) {
+    d->reads = d->addr = 0;
+    d->dst = reg_id(&in->ops[0]);
+    return;
+  }
+
+  uint8_t first_src = 0;
+  if (in->op_count && !no_dst(in->op)) {
+    d->dst = reg_id(&in->ops[0]);
+    // two-operand forms also read their destination
+    int rmw = in->op == OP_ADD || in->op == OP_SUB || in->op == OP_AND ||
+              in->op == OP_OR || in->op == OP_XOR || in->op == OP_CMOVCC ||
+              in->op == OP_XADD || in->op == OP_CMPXCHG ||
+              cls == COST_FMA ||
+              (in->enc == ENC_LEGACY && in->vkind != VK_NONE && in->op_count == 2 &&
+               cls != COST_VMOV && cls != COST_MOVD && cls != COST_VPERM);
+    first_src = rmw ? 0 : 1;
+  }
+  for (uint8_t i = first_src; i < in->op_count; i++) {
+    int r = reg_id(&in->ops[i]);
+    if (r >= 0) d->reads |= (RegSet)1 << r;
+  }
+  if (in->kmask) d->reads |= (RegSet)1 << (R_K + in->kmask);
+}
+
+// ---- block model ----
+
+typedef struct {
+  double uops;                    // fused uops (frontend)
+  double port[COST_MAX_PORTS];    // busy cycles per port
+  double loads, stores;
+} Pressure;
+
+static const CostEntry* entry_for(const UarchProfile *prof, const Insn *in, CostClass cls,
+                                  uint16_t *ports) {
+  const CostEntry *e = &prof->cls[cls];
+  *ports = e->ports;
+  if (in->vl >= 512 && prof->zmm_ports && (e->ports & prof->zmm_ports)) {
+    *ports = (uint16_t)(e->ports & prof->zmm_ports);
+  }
+  return e;
+}
+
+static void add_pressure(const UarchProfile *prof, const Insn *in, const Insn *next,
+                         Pressure *pr) {
+  CostClass cls = cost_class(in);
+  InsnDeps d;
+  insn_deps(in, cls, &d);
+  uint16_t ports;
+  const CostEntry *e = entry_for(prof, in, cls, &ports);
+
+  // pure loads / stores (mov, pop, push) have no ALU uop
+  int alu = !((cls == COST_MOV || cls == COST_VMOV) && (d.load || d.store)) &&
+            cls != COST_PUSH && cls != COST_POP;
+
+  double fused = e->uops;
+  if (d.store && alu && cls != COST_CALL) fused += 1; // RMW: load+op, store
+  // cmp/test + jcc macro-fuse: the pair issues and executes as the branch
+  if ((in->op == OP_CMP || in->op == OP_TEST) && !d.load && next && next->op == OP_JCC_REL) return;
+  pr->uops += fused;
+
+  pr->loads += d.load;
+  pr->stores += d.store;
+
+  if (!alu || ports == 0) return;
+  unsigned k = 0;
+  for (unsigned p = 0; p < prof->nports; p++) if (ports & (1u << p)) k++;
+  double share = (double)e->uops * (double)e->occ / (double)k;
+  for (unsigned p = 0; p < prof->nports; p++) if (ports & (1u << p)) pr->port[p] += share;
+}
+
+// Advances register ready times through one pass of v[a..b]; returns the
+// completion time of the last result.
+static double run_latency(const UarchProfile *prof, const Insn *v, size_t a, size_t b,
+                          double *ready) {
+  double end = 0;
+  for (size_t i = a; i <= b; i++) {
+    const Insn *in = &v[i];
+    CostClass cls = cost_class(in);
+    InsnDeps d;
+    insn_deps(in, cls, &d);
+    uint16_t ports;
+    const CostEntry *e = entry_for(prof, in, cls, &ports);
+
+    // a memory source is ready load_lat after its address
+    double t = 0, ta = 0;
+    for (int r = 0; r < R_COUNT; r++) {
+      if (((d.reads >> r) & 1u) && ready[r] > t) t = ready[r];
+      if (((d.addr >> r) & 1u) && ready[r] > ta) ta = ready[r];
+    }
+    if (d.load && ta + prof->load_lat > t) t = ta + prof->load_lat;
+    double done = t + e->lat;
+    if (d.dst >= 0) ready[d.dst] = done;
+    if (d.dst_flags) ready[R_FLAGS] = done;
+    if (done > end) end = done;
+  }
+  return end;
+}
+
+typedef struct {
+  double cycles;
+  double recur;
+  const char *bottleneck;
+  double uops, loads, stores;
+} LoopCost;
+
+static void estimate(const UarchProfile *prof, const Insn *v, size_t a, size_t b, int loop,
+                     LoopCost *lc) {
+  Pressure pr;
+  memset(&pr, 0, sizeof(pr));
+  for (size_t i = a; i <= b; i++) add_pressure(prof, &v[i], i < b ? &v[i + 1] : NULL, &pr);
+
+  double ready[R_COUNT] = {0};
+  double chain;
+  if (loop) {
+    // steady state: growth of ready times from the 2nd to the 3rd iteration
+    double r2[R_COUNT];
+    run_latency(prof, v, a, b, ready);
+    run_latency(prof, v, a, b, ready);
+    memcpy(r2, ready, sizeof(r2));
+    run_latency(prof, v, a, b, ready);
+    chain = 0;
+    for (int r = 0; r < R_COUNT; r++) if (ready[r] - r2[r] > chain) chain = ready[r] - r2[r];
+  } else {
+    chain = run_latency(prof, v, a, b, ready);
+  }
+
+  lc->uops = pr.uops;
+  lc->loads = pr.loads;
+  lc->stores = pr.stores;
+  lc->recur = chain;
+  lc->cycles = pr.uops / prof->width;
+  lc->bottleneck = "frontend";
+
+  for (unsigned p = 0; p < prof->nports; p++) {
+    if (pr.port[p] > lc->cycles) { lc->cycles = pr.port[p]; lc->bottleneck = prof->port_names[p]; }
+  }
+  if (pr.loads / prof->nloads > lc->cycles)   { lc->cycles = pr.loads / prof->nloads; lc->bottleneck = "loads"; }
+  if (pr.stores / prof->nstores > lc->cycles) { lc->cycles = pr.stores / prof->nstores; lc->bottleneck = "stores"; }
+  if (chain > lc->cycles) { lc->cycles = chain; lc->bottleneck = loop ? "dep-chain" : "latency"; }
+}
+
+// ---- report ----
+
+void cost_report(FILE *out, const Image *img, const UarchProfile *prof, const char *label) {
+  Arena *sa = arena_thread();
+  InsnVec vec = {0};
+  Loop *loops = NULL;
+  size_t loops_cap = 0;
+
+  fprintf(out, "# profile %s\n", prof->name);
+  fprintf(out, "# kind  cycles    uops loads stores  recur  bottleneck  head              insns  function\n");
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+
+    for (size_t r = 0; r < nr; r++) {
+      if (!insn_vec_decode(&vec, img->buf + regs[r].offset, regs[r].size, regs[r].addr)) break;
+      if (vec.n == 0) continue;
+
+      char gap[40];
+      const char *name = region_name(regs[r].name, regs[r].addr, gap, sizeof(gap));
+
+      size_t nl = flow_find_loops(&vec, &loops, &loops_cap);
+      for (size_t l = 0; l < nl; l++) {
+        LoopCost lc;
+        estimate(prof, vec.v, loops[l].head, loops[l].tail, 1, &lc);
+        if (label) fprintf(out, "%s: ", label);
+        fprintf(out, "loop %8.2f %7.0f %5.0f %6.0f %6.1f  %-10s  %016llx %6llu  %s\n",
+          lc.cycles, lc.uops, lc.loads, lc.stores, lc.recur, lc.bottleneck,
+          (unsigned long long)vec.v[loops[l].head].addr,
+          (unsigned long long)(loops[l].tail - loops[l].head + 1), name);
+      }
+
+      // straight-line blocks: sum of per-block estimates, one pass each
+      double total = 0, uops = 0, loads = 0, stores = 0;
+      size_t blocks = 0, start = 0;
+      for (size_t i = 0; i < vec.n; i++) {
+        int last = (i + 1 == vec.n) || flow_ends_block(&vec.v[i]);
+        if (!last) continue;
+        LoopCost lc;
+        estimate(prof, vec.v, start, i, 0, &lc);
+        total += lc.cycles; uops += lc.uops; loads += lc.loads; stores += lc.stores;
+        blocks++;
+        start = i + 1;
+      }
+      if (label) fprintf(out, "%s: ", label);
+      fprintf(out, "func %8.2f %7.0f %5.0f %6.0f %6s  %-10s  %016llx %6llu  %s  (%llu blocks, %llu loops)\n",
+        total, uops, loads, stores, "-", "-", (unsigned long long)regs[r].addr,
+        (unsigned long long)vec.n, name, (unsigned long long)blocks, (unsigned long long)nl);
+    }
+    arena_reset(sa, mark);
+  }
+
+  free(loops);
+  insn_vec_free(&vec);
+}
@@ -0,0 +1,395 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "opdump/datascan.h"
+#include "opdump/decode.h"
+
+enum { LEA_WINDOW = 8 };
+enum { TABLE_MIN = 4, TABLE_MAX = 4096 };
+enum { STRING_MIN = 12, FILL_MIN = 16 };
+// invalid ranges: at most ZONE_GAP bytes between unknown opcodes, ZONE_MIN_BYTES
+// long, entropy at least ZONE_ENTROPY of the maximum; ranges up to
+// ZONE_JOIN bytes apart are joined
+enum { ZONE_GAP = 16, ZONE_MIN_BYTES = 128, ZONE_JOIN = 64 };
+static const double ZONE_ENTROPY = 0.9;
+enum { R_X86_64_64 = 1, R_X86_64_32 = 10, R_X86_64_32S = 11 };
+
+static uint32_t rd32le(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static uint64_t rd64le(const uint8_t *p) {
+  return (uint64_t)rd32le(p) | ((uint64_t)rd32le(p+4) << 32);
+}
+
+typedef struct {
+  DataRange *v;
+  size_t n, cap;
+  int failed;         // a push ran out of memory
+} RangeVec;
+
+static void push_range(RangeVec *rv, uint64_t addr, uint64_t end, DataKind kind) {
+  if (addr >= end) return;
+  if (rv->n == rv->cap) {
+    size_t nc = rv->cap ? rv->cap * 2 : 64;
+    DataRange *nv = (DataRange*)realloc(rv->v, nc * sizeof(DataRange));
+    if (!nv) { rv->failed = 1; return; }
+    rv->v = nv;
+    rv->cap = nc;
+  }
+  rv->v[rv->n].addr = addr;
+  rv->v[rv->n].end = end;
+  rv->v[rv->n].kind = kind;
+  rv->n++;
+}
+
+// A jump-table candidate: entries at t, targets expected in [lo, hi).
+typedef struct {
+  uint64_t t, lo, hi;
+  int rel;            // int32 entries relative to t, else absolute 8-byte
+} TableCand;
+
+typedef struct {
+  TableCand *v;
+  size_t n, cap;
+  int failed;
+} CandVec;
+
+static void push_cand(CandVec *cv, uint64_t t, uint64_t lo, uint64_t hi, int rel) {
+  if (cv->n == cv->cap) {
+    size_t nc = cv->cap ? cv->cap * 2 : 32;
+    TableCand *nv = (TableCand*)realloc(cv->v, nc * sizeof(TableCand));
+    if (!nv) { cv->failed = 1; return; }
+    cv->v = nv;
+    cv->cap = nc;
+  }
+  TableCand c = { t, lo, hi, rel };
+  cv->v[cv->n++] = c;
+}
+
+// Smallest symbol start above a, or UINT64_MAX.
+static uint64_t sym_after(const ElfSym *syms, size_t n, uint64_t a) {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (syms[mid].addr <= a) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < n ? syms[lo].addr : UINT64_MAX;
+}
+
+static int is_sym_start(const ElfSym *syms, size_t n, uint64_t a) {
+  const ElfSym *s = elf_sym_lookup(syms, n, a);
+  return s && s->addr == a;
+}
+
+// Shannon entropy of p[0, n) in bits per byte.
+static double entropy(const uint8_t *p, size_t n) {
+  uint32_t count[256] = {0};
+  for (size_t i = 0; i < n; i++) count[p[i]]++;
+  double h = 0;
+  for (int b = 0; b < 256; b++) {
+    if (!count[b]) continue;
+    double q = (double)count[b] / (double)n;
+    h -= q * log2(q);
+  }
+  return h;
+}
+
+// End of the table at c->t, or c->t when fewer than TABLE_MIN entries check out.
+static uint64_t table_end(const Image *img, const ElfExecSeg *seg, const TableCand *c) {
+  uint64_t seg_end = seg->vaddr + seg->filesz;
+  if (c->t < seg->vaddr || c->t >= seg_end) return c->t;
+  if (is_sym_start(img->syms, img->sym_count, c->t)) return c->t;
+
+  uint64_t stop = sym_after(img->syms, img->sym_count, c->t);
+  if (stop > seg_end) stop = seg_end;
+  size_t esz = c->rel ? 4 : 8;
+  uint64_t a = c->t;
+  size_t k = 0;
+  // a target inside the table is where the code after it starts
+  while (k < TABLE_MAX && a + esz <= stop) {
+    const uint8_t *p = img->buf + seg->offset + (a - seg->vaddr);
+    uint64_t target = c->rel ? c->t + (uint64_t)(int64_t)(int32_t)rd32le(p) : rd64le(p);
+    if (target < c->lo || target >= c->hi) break;
+    if (target >= c->t && target < a + esz) break;
+    if (target > a && target < stop) stop = target;
+    a += esz;
+    k++;
+  }
+  return k >= TABLE_MIN ? a : c->t;
+}
+
+typedef struct {
+  uint64_t start, bad_end;   // first and past the last unknown opcode
+  size_t nbad;
+} Zone;
+
+// Emits [start, end), joined to a close invalid range before it.
+static void push_invalid(RangeVec *rv, const Image *img, uint64_t start, uint64_t end) {
+  DataRange *last = rv->n ? &rv->v[rv->n - 1] : NULL;
+  if (last && last->kind == DATA_INVALID && start <= last->end + ZONE_JOIN &&
+      sym_after(img->syms, img->sym_count, last->end - 1) >= start) {
+    if (end > last->end) last->end = end;
+    return;
+  }
+  push_range(rv, start, end, DATA_INVALID);
+}
+
+// Compiled code stays below ~0.85 of the maximum entropy over 128 bytes even
+// where this decoder loses sync; packed data and random bytes are above. The
+// zone is measured in ZONE_MIN_BYTES windows ZONE_GAP apart, so data sharing
+// a zone with tables or strings is still found.
+static void close_zone(RangeVec *rv, const Image *img, const ElfExecSeg *seg, const Zone *z) {
+  if (z->bad_end - z->start < ZONE_MIN_BYTES) return;
+  const uint8_t *p = img->buf + seg->offset + (z->start - seg->vaddr);
+  double gate = ZONE_ENTROPY * log2((double)ZONE_MIN_BYTES);
+  uint64_t rs = 0, re = 0;
+  for (uint64_t w = z->start; w + ZONE_MIN_BYTES <= z->bad_end; w += ZONE_GAP) {
+    if (entropy(p + (w - z->start), ZONE_MIN_BYTES) < gate) continue;
+    if (re && w <= re) {
+      re = w + ZONE_MIN_BYTES;
+      continue;
+    }
+    if (re) push_invalid(rv, img, rs, re);
+    rs = w;
+    re = w + ZONE_MIN_BYTES;
+  }
+  if (!re) return;
+  // ran to the end of the zone: restart at the next function when it is close
+  uint64_t next = sym_after(img->syms, img->sym_count, re - 1);
+  if (re + ZONE_GAP > z->bad_end && next != UINT64_MAX && next - re <= ZONE_GAP &&
+      next <= seg->vaddr + seg->filesz) re = next;
+  push_invalid(rv, img, rs, re);
+}
+
+// One decode sweep: invalid ranges now, jump-table candidates for later.
+// Bytes decode_one rejects and the OP_INVALID forms it only measures both
+// count as unknown opcodes.
+static void sweep(RangeVec *rv, CandVec *cv, const Image *img, const ElfExecSeg *seg) {
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+  uint64_t seg_end = seg->vaddr + seg->filesz;
+  Zone z = { 0, 0, 0 };
+  uint64_t lea_t = 0;
+  size_t lea_age = LEA_WINDOW + 1;
+  int lea_pushed = 0;
+
+  Insn in;
+  uint64_t off = 0;
+  while (off < seg->filesz) {
+    uint64_t a = seg->vaddr + off;
+    size_t used = decode_one(&ctx, img->buf + seg->offset + off, (size_t)(seg->filesz - off), a, &in);
+    if (used == 0 || in.op == OP_INVALID) {
+      if (used == 0) used = 1;
+      if (z.nbad && a - z.bad_end <= ZONE_GAP && sym_after(img->syms, img->sym_count, z.start) > a) {
+        z.bad_end = a + used;
+        z.nbad++;
+      } else {
+        close_zone(rv, img, seg, &z);
+        z.start = a;
+        z.bad_end = a + used;
+        z.nbad = 1;
+      }
+      off += used;
+      continue;
+    }
+    off += used;
+
+    if (in.op == OP_LEA && in.ops[1].kind == O_MEM && in.ops[1].mem.base == MEM_RIP) {
+      const ElfSym *f = elf_sym_lookup(img->syms, img->sym_count, a);
+      lea_t = a + in.size + (uint64_t)(int64_t)in.ops[1].mem.disp;
+      lea_age = 0;
+      // lea / movsxd / add / jmp r: movsxd does not decode, so the jmp can be
+      // lost in the resync; a target further into the function stands alone
+      lea_pushed = f && lea_t > a && lea_t < f->addr + f->size;
+      if (lea_pushed) push_cand(cv, lea_t, f->addr, f->addr + f->size, 1);
+      continue;
+    }
+    lea_age++;
+    if (in.op != OP_JMP_RM) continue;
+
+    const ElfSym *f = elf_sym_lookup(img->syms, img->sym_count, a);
+    uint64_t lo = f ? f->addr : seg->vaddr, hi = f ? f->addr + f->size : seg_end;
+    const Operand *o = &in.ops[0];
+    if (o->kind == O_REG && lea_age <= LEA_WINDOW && !lea_pushed) {
+      push_cand(cv, lea_t, lo, hi, 1);
+    } else if (o->kind == O_MEM && o->mem.base == 0xFF && o->mem.index != 0xFF && o->mem.scale == 8) {
+      push_cand(cv, (uint64_t)(int64_t)o->mem.disp, lo, hi, 0);
+    }
+  }
+  close_zone(rv, img, seg, &z);
+}
+
+// Strings and one-byte fills, cut at function starts.
+static void scan_bytes(RangeVec *rv, const Image *img, const ElfExecSeg *seg) {
+  const uint8_t *p = img->buf + seg->offset;
+  size_t n = (size_t)seg->filesz;
+  size_t i = 0;
+  while (i < n) {
+    size_t j = i;
+    while (j < n && p[j] == p[i]) j++;
+    if (j - i >= FILL_MIN && p[i] != 0x90 && p[i] != 0xCC) {
+      uint64_t a = seg->vaddr + i, stop = sym_after(img->syms, img->sym_count, a);
+      uint64_t end = seg->vaddr + j;
+      push_range(rv, a, end < stop ? end : stop, DATA_FILL);
+      i = j;
+      continue;
+    }
+    j = i;
+    while (j < n && ((p[j] >= 0x20 && p[j] < 0x7F) || p[j] == '\t' || p[j] == '\n')) j++;
+    if (j - i >= STRING_MIN && j < n && p[j] == 0) {
+      uint64_t a = seg->vaddr + i, stop = sym_after(img->syms, img->sym_count, a);
+      uint64_t end = seg->vaddr + j + 1;
+      push_range(rv, a, end < stop ? end : stop, DATA_STRING);
+      i = j + 1;
+      continue;
+    }
+    i = j > i ? j : i + 1;
+  }
+}
+
+// ET_REL: absolute relocations packed closer than instructions can hold them.
+static void scan_relocs(RangeVec *rv, const Image *img) {
+  const ElfReloc *r = img->relocs;
+  size_t n = img->reloc_count;
+  for (size_t i = 0; i < n;) {
+    size_t esz = r[i].type == R_X86_64_64 ? 8
+               : (r[i].type == R_X86_64_32 || r[i].type == R_X86_64_32S) ? 4 : 0;
+    size_t j = i + 1;
+    while (esz && j < n && r[j].type == r[i].type && r[j].addr == r[j - 1].addr + esz) j++;
+    if (esz && j - i >= (esz == 8 ? 2u : 3u)) push_range(rv, r[i].addr, r[j - 1].addr + esz, DATA_TABLE);
+    i = j;
+  }
+}
+
+static int cmp_addr(const void *a, const void *b) {
+  const DataRange *x = (const DataRange*)a, *y = (const DataRange*)b;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static int cmp_kind(const void *a, const void *b) {
+  const DataRange *x = (const DataRange*)a, *y = (const DataRange*)b;
+  if (x->kind != y->kind) return (int)x->kind - (int)y->kind;
+  return cmp_addr(a, b);
+}
+
+// Shortest piece of a heuristic kind still worth its header once clipped.
+static uint64_t min_piece(DataKind k) {
+  switch (k) {
+    case DATA_STRING:  return STRING_MIN;
+    case DATA_FILL:    return FILL_MIN;
+    case DATA_INVALID: return ZONE_MIN_BYTES / 2;
+    default:           return 1;
+  }
+}
+
+// Parts of add[0, na) (one kind, by address) outside have[0, nh) (by
+// address, disjoint), appended to out.
+static void subtract(const DataRange *add, size_t na, const DataRange *have, size_t nh,
+                     RangeVec *out) {
+  size_t h = 0;
+  uint64_t done = 0;   // end of what add already covered
+  for (size_t i = 0; i < na; i++) {
+    uint64_t a = add[i].addr > done ? add[i].addr : done, e = add[i].end;
+    if (e > done) done = e;
+    while (h < nh && have[h].end <= a) h++;
+    for (size_t k = h; a < e;) {
+      if (k < nh && have[k].addr <= a) {
+        a = have[k++].end;
+        continue;
+      }
+      uint64_t stop = k < nh && have[k].addr < e ? have[k].addr : e;
+      if (stop - a >= min_piece(add[i].kind)) push_range(out, a, stop, add[i].kind);
+      a = stop;
+    }
+  }
+}
+
+int data_scan(const Image *img, Arena *a, DataRange **out, size_t *n) {
+  *out = NULL;
+  *n = 0;
+  RangeVec rv = { NULL, 0, 0, 0 };
+  CandVec cv = { NULL, 0, 0, 0 };
+  Arena *sa = arena_thread();
+  ArenaMark mark = arena_mark(sa);
+
+  ElfSym *objs = NULL;
+  size_t nobj = elf64_collect_object_symbols(img->buf, img->n, sa, &objs);
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    const ElfExecSeg *seg = &img->segs[s];
+    uint64_t seg_end = seg->vaddr + seg->filesz;
+    for (size_t i = 0; i < nobj; i++) {
+      if (objs[i].addr >= seg->vaddr && objs[i].addr < seg_end) {
+        uint64_t end = objs[i].addr + objs[i].size;
+        push_range(&rv, objs[i].addr, end < seg_end ? end : seg_end, DATA_OBJECT);
+      }
+    }
+
+    cv.n = 0;
+    sweep(&rv, &cv, img, seg);
+    for (size_t i = 0; i < cv.n; i++) {
+      push_range(&rv, cv.v[i].t, table_end(img, seg, &cv.v[i]), DATA_TABLE);
+    }
+    scan_bytes(&rv, img, seg);
+  }
+  scan_relocs(&rv, img);
+  arena_reset(sa, mark);
+
+  // overlaps go to the more certain kind (enum order)
+  if (rv.n) qsort(rv.v, rv.n, sizeof(DataRange), cmp_kind);
+  RangeVec have = { NULL, 0, 0, 0 }, add = { NULL, 0, 0, 0 };
+  for (size_t g0 = 0, g1; g0 < rv.n && !rv.failed && !cv.failed; g0 = g1) {
+    for (g1 = g0; g1 < rv.n && rv.v[g1].kind == rv.v[g0].kind; g1++) {}
+    add.n = 0;
+    subtract(rv.v + g0, g1 - g0, have.v, have.n, &add);
+    for (size_t i = 0; i < add.n; i++) push_range(&have, add.v[i].addr, add.v[i].end, add.v[i].kind);
+    if (have.n) qsort(have.v, have.n, sizeof(DataRange), cmp_addr);
+  }
+
+  int ok = !rv.failed && !cv.failed && !add.failed && !have.failed;
+  DataRange *v = ok && have.n ? (DataRange*)arena_alloc(a, have.n * sizeof(DataRange)) : NULL;
+  if (v) {
+    memcpy(v, have.v, have.n * sizeof(DataRange));
+    *out = v;
+    *n = have.n;
+  } else if (have.n) {
+    ok = 0;
+  }
+  free(have.v);
+  free(add.v);
+  free(rv.v);
+  free(cv.v);
+  return ok;
+}
+
+const char* data_kind_name(DataKind k) {
+  switch (k) {
+    case DATA_TABLE:   return "table";
+    case DATA_OBJECT:  return "object";
+    case DATA_STRING:  return "string";
+    case DATA_FILL:    return "fill";
+    case DATA_INVALID: return "invalid";
+    default:           return "?";
+  }
+}
+
+void data_stats(FILE *out, const Image *img, const DataRange *r, size_t n, const char *label) {
+  uint64_t code = 0, bytes = 0;
+  uint64_t kn[DATA_KINDS] = {0}, kb[DATA_KINDS] = {0};
+  for (size_t s = 0; s < img->seg_count; s++) code += img->segs[s].filesz;
+  for (size_t i = 0; i < n; i++) {
+    kn[r[i].kind]++;
+    kb[r[i].kind] += r[i].end - r[i].addr;
+    bytes += r[i].end - r[i].addr;
+  }
+  // one write: archive members print from several threads
+  char line[512];
+  int len = snprintf(line, sizeof(line), "%s%s# data-in-code: %zu ranges, %llu of %llu bytes",
+    label ? label : "", label ? ": " : "", n, (unsigned long long)bytes, (unsigned long long)code);
+  for (int k = 0; k < DATA_KINDS && len > 0 && (size_t)len < sizeof(line); k++) {
+    len += snprintf(line + len, sizeof(line) - (size_t)len, "%s %s %llu/%llu", k ? "," : ":",
+      data_kind_name((DataKind)k), (unsigned long long)kn[k], (unsigned long long)kb[k]);
+  }
+  fprintf(out, "%s\n", line);
+}
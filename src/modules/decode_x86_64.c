@@ -66,7 +66,7 @@ static const OpEntry* match_op_2(uint8_t b1, uint8_t b2) {
   return NULL;
 }
 
-static Operand make_reg(uint8_t width, uint8_t r) {
+static Operand make_reg(uint16_t width, uint8_t r) {
   Operand o;
   memset(&o, 0, sizeof(o));
   o.kind = O_REG;
@@ -84,7 +84,7 @@ static Operand make_imm(uint8_t width, int64_t v) {
   return o;
 }
 
-static Operand make_mem(uint8_t width, uint8_t base, uint8_t index, uint8_t scale, int32_t disp) {
+static Operand make_mem(uint16_t width, uint8_t base, uint8_t index, uint8_t scale, int32_t disp) {
   Operand o;
   memset(&o, 0, sizeof(o));
   o.kind = O_MEM;
@@ -111,8 +111,26 @@ static size_t read_disp_by_mod(const uint8_t *p, size_t n, uint8_t mod, int32_t
   return 0;
 }
 
+// imm8 / imm16 / imm32 (sign-extended at 64 bits) for an operand of width w.
+// Returns the bytes read, 0 if truncated.
+static size_t read_imm(const uint8_t *p, size_t n, uint16_t w, int64_t *out_imm) {
+  if (w == 8) {
+    if (n < 1) return 0;
+    *out_imm = read_i8(p);
+    return 1;
+  }
+  if (w == 16) {
+    if (n < 2) return 0;
+    *out_imm = (int16_t)(uint16_t)(p[0] | (p[1] << 8));
+    return 2;
+  }
+  if (n < 4) return 0;
+  *out_imm = read_i32(p);
+  return 4;
+}
+
 static Operand rm_to_operand(const Rex *rex, const uint8_t *p, size_t n, size_t *io_i,
-                             uint8_t width,
+                             uint16_t width,
                              uint8_t mod, uint8_t rm_lo3, uint8_t rm_ext,
                              int is_mem) {
   if (!is_mem) return make_reg(width, rm_ext);
@@ -174,6 +192,275 @@ static Operand rm_to_operand(const Rex *rex, const uint8_t *p, size_t n, size_t
   return make_mem(width, base, 0xFF, 1, disp);
 }
 
+static Operand make_kreg(uint8_t k) {
+  Operand o;
+  memset(&o, 0, sizeof(o));
+  o.kind = O_KREG;
+  o.width = 64;
+  o.reg = (uint8_t)(k & 7);
+  return o;
+}
+
+// ---- SSE / VEX / EVEX ----
+
+typedef struct {
+  uint8_t  enc;        // VecEnc
+  uint8_t  map, pp, w;
+  uint16_t vl;         // 128/256/512 from L / L'L
+  uint8_t  r, x, b;    // REX-equivalent bits (already un-inverted)
+  uint8_t  rr, vv;     // EVEX R' and V': bit 4 of reg / vvvv
+  uint8_t  vvvv;
+  uint8_t  z, bc, aaa; // EVEX zeroing, broadcast/RC, opmask
+} VecPrefix;
+
+static size_t finish(Insn *o, const uint8_t *p, size_t i) {
+  o->size = (uint8_t)i;
+  set_bytes(o, p, i);
+  return i;
+}
+
+static const VecEntry* match_vec(const VecPrefix *v, uint8_t opc) {
+  for (unsigned k = 0; k < g_vops_count; k++) {
+    const VecEntry *e = &g_vops[k];
+    if (e->map != v->map || e->opc != opc || e->pp != v->pp) continue;
+    if (e->w != VW_ANY && e->w != v->w) continue;
+    if (v->enc == ENC_LEGACY && (e->flags & (VX_VEX_ONLY | VX_EVEX_ONLY))) continue;
+    if (v->enc == ENC_VEX && (e->flags & VX_EVEX_ONLY)) continue;
+    if (v->enc == ENC_EVEX && (e->flags & VX_NO_EVEX)) continue;
+    return e;
+  }
+  return NULL;
+}
+
+// Parses C5 / C4 / 62 at p[*io_i]. Returns 0 if truncated or malformed.
+static int read_vex_prefix(const uint8_t *p, size_t n, size_t *io_i, VecPrefix *v) {
+  size_t i = *io_i;
+  memset(v, 0, sizeof(*v));
+  uint8_t esc = p[i++];
+
+  if (esc == 0xC5) {
+    if (i + 1 > n) return 0;
+    uint8_t b = p[i++];
+    v->enc  = ENC_VEX;
+    v->r    = (uint8_t)(((b >> 7) & 1) ^ 1);
+    v->vvvv = (uint8_t)((~b >> 3) & 15);
+    v->vl   = (b & 4) ? 256 : 128;
+    v->pp   = (uint8_t)(b & 3);
+    v->map  = VM_0F;
+  } else if (esc == 0xC4) {
+    if (i + 2 > n) return 0;
+    uint8_t b1 = p[i++], b2 = p[i++];
+    v->enc  = ENC_VEX;
+    v->r    = (uint8_t)(((b1 >> 7) & 1) ^ 1);
+    v->x    = (uint8_t)(((b1 >> 6) & 1) ^ 1);
+    v->b    = (uint8_t)(((b1 >> 5) & 1) ^ 1);
+    v->map  = (uint8_t)(b1 & 31);
+    v->w    = (uint8_t)(b2 >> 7);
+    v->vvvv = (uint8_t)((~b2 >> 3) & 15);
+    v->vl   = (b2 & 4) ? 256 : 128;
+    v->pp   = (uint8_t)(b2 & 3);
+    if (v->map < VM_0F || v->map > VM_0F3A) return 0;
+  } else {
+    if (i + 3 > n) return 0;
+    uint8_t p0 = p[i++], p1 = p[i++], p2 = p[i++];
+    if ((p0 & 0x0C) != 0 || (p1 & 0x04) == 0) return 0;
+    v->enc  = ENC_EVEX;
+    v->r    = (uint8_t)(((p0 >> 7) & 1) ^ 1);
+    v->x    = (uint8_t)(((p0 >> 6) & 1) ^ 1);
+    v->b    = (uint8_t)(((p0 >> 5) & 1) ^ 1);
+    v->rr   = (uint8_t)(((p0 >> 4) & 1) ^ 1);
+    v->map  = (uint8_t)(p0 & 3);
+    v->w    = (uint8_t)(p1 >> 7);
+    v->vvvv = (uint8_t)((~p1 >> 3) & 15);
+    v->pp   = (uint8_t)(p1 & 3);
+    v->z    = (uint8_t)(p2 >> 7);
+    v->vl   = (uint16_t)(128u << ((p2 >> 5) & 3));
+    v->bc   = (uint8_t)((p2 >> 4) & 1);
+    v->vv   = (uint8_t)(((p2 >> 3) & 1) ^ 1);
+    v->aaa  = (uint8_t)(p2 & 7);
+    if (v->map == 0 || v->vl > 512) return 0;
+  }
+
+  *io_i = i;
+  return 1;
+}
+
+// Skips ModRM, SIB and displacement at p[*io_i]. Returns 0 if truncated.
+static int skip_modrm(const uint8_t *p, size_t n, size_t *io_i) {
+  size_t i = *io_i;
+  if (i >= n) return 0;
+  uint8_t modrm = p[i++];
+  uint8_t mod = get_mod(modrm), rm3 = get_rm3(modrm);
+  size_t disp = mod == 1 ? 1 : mod == 2 ? 4 : 0;
+  if (mod != 3 && rm3 == 4) {
+    if (i >= n) return 0;
+    if (mod == 0 && (p[i] & 7) == 5) disp = 4;
+    i++;
+  } else if (mod == 0 && rm3 == 5) {
+    disp = 4;
+  }
+  if (i + disp > n) return 0;
+  *io_i = i + disp;
+  return 1;
+}
+
+// Shift by imm8 (66 0F 71-73): ModRM.reg selects the op. EVEX W1 72 is
+// the qword group (vpsraq, vprolq, vprorq), not decoded here.
+static Op vec_shift_op(const VecPrefix *v, uint8_t opc, uint8_t ext) {
+  switch (opc) {
+    case 0x71: return ext == 2 ? OP_PSRLW : ext == 4 ? OP_PSRAW : ext == 6 ? OP_PSLLW : OP_INVALID;
+    case 0x72:
+      if (v->enc == ENC_EVEX && v->w) return OP_INVALID;
+      return ext == 2 ? OP_PSRLD : ext == 4 ? OP_PSRAD : ext == 6 ? OP_PSLLD : OP_INVALID;
+    case 0x73:
+      return ext == 2 ? OP_PSRLQ : ext == 3 ? OP_PSRLDQ : ext == 6 ? OP_PSLLQ :
+             ext == 7 ? OP_PSLLDQ : OP_INVALID;
+    default:   return OP_INVALID;
+  }
+}
+
+// Unknown opcodes with an imm8 after the ModRM: all of 0F 3A, and the 0F
+// rows whose every form takes one (shuffles, shifts, compares, pinsrw /
+// pextrw, shufps).
+static int vec_has_imm8(const VecPrefix *v, uint8_t opc) {
+  if (v->map == VM_0F3A) return 1;
+  return v->map == VM_0F && ((opc >= 0x70 && opc <= 0x73) || opc == 0xC2 ||
+                             (opc >= 0xC4 && opc <= 0xC6));
+}
+
+// i points at the opcode byte (after the escape / map bytes).
+static size_t decode_vec(const VecPrefix *v, const uint8_t *p, size_t n, size_t i, Insn *out) {
+  if (i >= n) return 0;
+  uint8_t opc = p[i++];
+
+  const VecEntry *e = match_vec(v, opc);
+  Op op = e ? e->op : OP_INVALID;
+  if (e && (e->flags & VX_GRP_SHIFT)) {
+    if (i >= n) return 0;
+    op = vec_shift_op(v, opc, get_reg3(p[i]));
+    if (op == OP_INVALID) e = NULL;
+  }
+  if (!e) {
+    // every VEX / EVEX / 0F 38 / 0F 3A opcode takes a ModRM (some an imm8
+    // too): measure it so the sweep stays in sync; legacy 0F has forms without
+    out->op = OP_INVALID;
+    if (v->enc != ENC_LEGACY || v->map != VM_0F) {
+      if (!skip_modrm(p, n, &i)) return 0;
+      if (vec_has_imm8(v, opc) && i++ >= n) return 0;
+    }
+    return finish(out, p, i);
+  }
+
+  const int scalar = (e->flags & VX_SCALAR) != 0;
+  const int kop    = (e->flags & (VX_REG_K | VX_RM_K)) != 0;
+
+  out->op     = op;
+  out->enc    = v->enc;
+  out->vw     = v->w;
+  out->vesize = (e->flags & VX_ESIZE_W) ? (v->w ? 8 : 4) : e->esize;
+
+  if (e->form == VF_NONE) {
+    if (out->op == OP_VZEROUPPER && v->vl == 256) out->op = OP_VZEROALL;
+    return finish(out, p, i);
+  }
+
+  if (i >= n) return 0;
+  uint8_t modrm = p[i++];
+  uint8_t mod   = get_mod(modrm);
+  uint8_t rm3   = get_rm3(modrm);
+  int is_mem    = (mod != 3);
+
+  uint16_t vl = v->vl;
+  if (v->enc == ENC_EVEX && v->bc && !is_mem) vl = 512; // embedded rounding: LIG
+  if (scalar) vl = 128;
+
+  out->vkind = kop ? VK_NONE : (scalar ? VK_SCALAR : VK_PACKED);
+  out->vl    = (out->vkind == VK_PACKED) ? vl : 0;
+
+  uint8_t reg = (uint8_t)(get_reg3(modrm) | (v->r << 3) | (v->rr << 4));
+  uint8_t rm  = (uint8_t)(rm3 | (v->b << 3) | (v->enc == ENC_EVEX ? (v->x << 4) : 0));
+  uint8_t gpr_w = v->w ? 64 : 32;
+
+  Operand o_reg;
+  if (e->flags & VX_REG_GPR)     o_reg = make_reg(gpr_w, (uint8_t)(reg & 15));
+  else if (e->flags & VX_REG_K)  o_reg = make_kreg(reg);
+  else                           o_reg = make_reg(vl, reg);
+
+  Operand o_rm;
+  if (is_mem) {
+    const uint8_t esz = out->vesize ? out->vesize : 1;
+    int bcast = (v->enc == ENC_EVEX && v->bc && !scalar && !kop);
+
+    uint16_t mw = vl;
+    uint16_t n8 = (uint16_t)(vl / 8); // EVEX disp8 scale (full vector)
+    if (scalar || bcast || (e->flags & VX_BCAST_SRC)) { mw = (uint16_t)(esz * 8); n8 = esz; }
+    else if (e->flags & VX_RM_X128)                    { mw = 128; n8 = 16; }
+    else if (kop)                                      { mw = (uint16_t)(esz * 8); n8 = 1; }
+
+    Rex rex = { 1, v->w, v->r, v->x, v->b };
+    o_rm = rm_to_operand(&rex, p, n, &i, mw, mod, rm3, (uint8_t)(rm3 | (v->b << 3)), 1);
+    if (v->enc == ENC_EVEX && mod == 1) o_rm.mem.disp *= n8;
+    if (bcast) out->bcast = (uint8_t)(vl / (esz * 8));
+  } else if (e->flags & VX_RM_GPR) {
+    o_rm = make_reg(gpr_w, (uint8_t)(rm & 15));
+  } else if (e->flags & VX_RM_K) {
+    o_rm = make_kreg(rm3);
+  } else if (e->flags & (VX_RM_X128 | VX_BCAST_SRC)) {
+    o_rm = make_reg(128, rm);
+  } else {
+    o_rm = make_reg(vl, rm);
+  }
+
+  Operand o_v = make_reg(vl, (uint8_t)(v->vvvv | (v->vv << 4)));
+  const int has_v = (v->enc != ENC_LEGACY);
+
+  switch ((VecForm)e->form) {
+    case VF_RM:
+      out->ops[out->op_count++] = o_reg;
+      if (has_v && (e->flags & VX_MERGE_REG) && !is_mem) out->ops[out->op_count++] = o_v;
+      out->ops[out->op_count++] = o_rm;
+      break;
+    case VF_MR:
+      out->ops[out->op_count++] = o_rm;
+      if (has_v && (e->flags & VX_MERGE_REG) && !is_mem) out->ops[out->op_count++] = o_v;
+      out->ops[out->op_count++] = o_reg;
+      break;
+    case VF_RVM:
+    case VF_RVMI:
+      out->ops[out->op_count++] = o_reg;
+      if (has_v) out->ops[out->op_count++] = o_v;
+      out->ops[out->op_count++] = o_rm;
+      break;
+    case VF_RMI:
+      out->ops[out->op_count++] = o_reg;
+      out->ops[out->op_count++] = o_rm;
+      break;
+    case VF_MRI:
+      out->ops[out->op_count++] = o_rm;
+      out->ops[out->op_count++] = o_reg;
+      break;
+    case VF_VMI:
+      if (has_v) out->ops[out->op_count++] = o_v;
+      out->ops[out->op_count++] = o_rm;
+      break;
+    default:
+      break;
+  }
+
+  if (e->form == VF_RMI || e->form == VF_MRI || e->form == VF_RVMI || e->form == VF_VMI) {
+    if (i + 1 > n) return 0;
+    out->ops[out->op_count++] = make_imm(8, p[i]);
+    i += 1;
+  }
+
+  if (v->enc == ENC_EVEX) {
+    out->kmask = v->aaa;
+    out->zeroing = v->z;
+  }
+
+  return finish(out, p, i);
+}
+
 static Op grp_alu_op(uint8_t subop) {
   if (subop == 0) return OP_ADD;
   if (subop == 4) return OP_AND;
@@ -199,6 +486,8 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
   }
 
   // prefixes
+  uint8_t mand = VP_NP; // mandatory prefix for SSE rows: F2/F3 win over 66
+  uint8_t pfx = 0;
   while (i < n) {
     uint8_t b = p[i];
     int is_prefix =
@@ -207,8 +496,31 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
       (b == 0x64) || (b == 0x65) ||
       (b == 0x66) || (b == 0x67);
     if (!is_prefix) break;
+    if (b == 0xF3) mand = VP_F3;
+    else if (b == 0xF2) mand = VP_F2;
+    else if (b == 0x66 && mand == VP_NP) mand = VP_66;
+    switch (b) {
+      case 0xF0: pfx |= PFX_LOCK; break;
+      case 0xF3: pfx |= PFX_REP; break;
+      case 0xF2: pfx |= PFX_REPNE; break;
+      case 0x66: pfx |= PFX_OPSIZE; break;
+      case 0x67: pfx |= PFX_ADDR; break;
+      case 0x64: pfx |= PFX_FS; break;
+      case 0x65: pfx |= PFX_GS; break;
+      default:   pfx |= PFX_SEG; break;
+    }
     i++;
   }
+  out->prefixes = pfx;
+  // 16-bit operand size unless REX.W overrides it
+  const int opsize16 = (pfx & PFX_OPSIZE) != 0;
+
+  // VEX (C5/C4) and EVEX (62); LES/LDS/BOUND do not exist in 64-bit mode
+  if (ctx->is64 && i < n && (p[i] == 0xC5 || p[i] == 0xC4 || p[i] == 0x62)) {
+    VecPrefix v;
+    if (!read_vex_prefix(p, n, &i, &v)) return 0;
+    return decode_vec(&v, p, n, i, out);
+  }
 
   // REX
   Rex rex = {0};
@@ -220,6 +532,7 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
       rex.rex_r = (b >> 2) & 1;
       rex.rex_x = (b >> 1) & 1;
       rex.rex_b = (b >> 0) & 1;
+      out->rex = b;
       i++;
       if (i >= n) return 0;
     }
@@ -247,6 +560,17 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
     out->has_cc = 1;
     out->cc = (Cond)(b2 & 0x0F);
     // must have ModRM next; we'll decode it below by faking OF_MODRM path
+  } else if (!op && is_0f) {
+    // SSE: 0F xx, 0F 38 xx, 0F 3A xx selected by the mandatory prefix
+    VecPrefix v;
+    memset(&v, 0, sizeof(v));
+    v.enc = ENC_LEGACY;
+    v.pp  = mand;
+    v.w   = rex.rex_w;
+    v.vl  = 128;
+    v.r = rex.rex_r; v.x = rex.rex_x; v.b = rex.rex_b;
+    v.map = (b2 == 0x38) ? VM_0F38 : (b2 == 0x3A) ? VM_0F3A : VM_0F;
+    return decode_vec(&v, p, n, v.map == VM_0F ? i - 1 : i, out);
   } else if (!op) {
     out->op = OP_INVALID;
     out->size = (uint8_t)i;
@@ -316,10 +640,14 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
     if ((op->flags & OF_MOV_IMM_REG) && (op->flags & OF_REG_RANGE)) {
       uint8_t low = (uint8_t)(b1 & 7);
       uint8_t reg = (uint8_t)(low | (rex.rex_b ? 8 : 0));
-      uint8_t width = rex.rex_w ? 64 : 32;
+      uint8_t width = rex.rex_w ? 64 : opsize16 ? 16 : 32;
 
       int64_t imm = 0;
-      if (width == 64) {
+      if (width == 16) {
+        if (i + 2 > n) return 0;
+        imm = (int16_t)(uint16_t)(p[i] | (p[i+1] << 8));
+        i += 2;
+      } else if (width == 64) {
         if (i + 8 > n) return 0;
         uint64_t v =
           (uint64_t)p[i+0] |
@@ -347,6 +675,22 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
       set_bytes(out, p, i);
       return i;
     }
+
+    if (op->flags & OF_ACC_IMM) {
+      uint8_t width = rex.rex_w ? 64 : opsize16 ? 16 : 32;
+      int64_t imm = 0;
+      size_t used = read_imm(p + i, n - i, width, &imm);
+      if (used == 0) return 0;
+      i += used;
+
+      out->op_count = 2;
+      out->ops[0] = make_reg(width, 0);
+      out->ops[1] = make_imm(width, imm);
+
+      out->size = (uint8_t)i;
+      set_bytes(out, p, i);
+      return i;
+    }
   }
 
   // Decide if we must parse ModRM:
@@ -367,7 +711,8 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
     int is_mem = (mod != 3);
 
     // width default
-    uint8_t width = (op && (op->flags & OF_BYTE)) ? 8 : (rex.rex_w ? 64 : 32);
+    uint8_t width = (op && (op->flags & OF_BYTE)) ? 8 :
+                    rex.rex_w ? 64 : opsize16 ? 16 : 32;
 
     // CMOVcc decode (priority)
     if (is_0f && b2 >= 0x40 && b2 <= 0x4F) {
@@ -413,6 +758,10 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
           if (i + 1 > n) return 0;
           imm = read_i8(p + i);
           i += 1;
+        } else if (width == 16) {
+          if (i + 2 > n) return 0;
+          imm = (int16_t)(uint16_t)(p[i] | (p[i+1] << 8));
+          i += 2;
         } else {
           if (i + 4 > n) return 0;
           imm = read_i32(p + i);
@@ -438,15 +787,16 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
         return i;
       }
 
-      Operand dst = rm_to_operand(&rex, p, n, &i, 8, mod, rm_lo3, rm_ext, is_mem);
-      if (i + 1 > n) return 0;
-      int64_t imm = read_i8(p + i);
-      i += 1;
+      Operand dst = rm_to_operand(&rex, p, n, &i, width, mod, rm_lo3, rm_ext, is_mem);
+      int64_t imm = 0;
+      size_t used = read_imm(p + i, n - i, width, &imm);
+      if (used == 0) return 0;
+      i += used;
 
       out->op = OP_MOV;
       out->op_count = 2;
       out->ops[0] = dst;
-      out->ops[1] = make_imm(8, imm);
+      out->ops[1] = make_imm(width, imm);
 
       out->size = (uint8_t)i;
       set_bytes(out, p, i);
@@ -474,6 +824,49 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
       return i;
     }
 
+    if (op && (op->flags & OF_GRP_F7)) {
+      Operand src = rm_to_operand(&rex, p, n, &i, width, mod, rm_lo3, rm_ext, is_mem);
+
+      if (subop == 0 || subop == 1) {
+        int64_t imm = 0;
+        size_t used = read_imm(p + i, n - i, width, &imm);
+        if (used == 0) return 0;
+        i += used;
+        out->op = OP_TEST;
+        out->op_count = 2;
+        out->ops[0] = src;
+        out->ops[1] = make_imm(width, imm);
+      } else if (subop == 6 || subop == 7) {
+        out->op = subop == 6 ? OP_DIV : OP_IDIV;
+        out->op_count = 1;
+        out->ops[0] = src;
+      } else {
+        out->op = OP_INVALID;
+        out->op_count = 0;
+      }
+
+      out->size = (uint8_t)i;
+      set_bytes(out, p, i);
+      return i;
+    }
+
+    if (op && (op->flags & OF_IMUL_IMM)) {
+      Operand src = rm_to_operand(&rex, p, n, &i, width, mod, rm_lo3, rm_ext, is_mem);
+      int64_t imm = 0;
+      size_t used = read_imm(p + i, n - i, b1 == 0x6B ? 8 : width, &imm);
+      if (used == 0) return 0;
+      i += used;
+
+      out->op_count = 3;
+      out->ops[0] = make_reg(width, reg_ext);
+      out->ops[1] = src;
+      out->ops[2] = make_imm(width, imm);
+
+      out->size = (uint8_t)i;
+      set_bytes(out, p, i);
+      return i;
+    }
+
     if (out->op == OP_SETCC) {
       Operand dst = rm_to_operand(&rex, p, n, &i, 8, mod, rm_lo3, rm_ext, is_mem);
       out->op_count = 1;
@@ -533,6 +926,10 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
       out->op_count = 2;
       out->ops[0] = o_rm;
       out->ops[1] = o_reg;
+    } else if (is_0f && (b2 == 0xB1 || b2 == 0xC1)) {
+      out->op_count = 2;
+      out->ops[0] = o_rm;
+      out->ops[1] = o_reg;
     } else {
       out->op = OP_INVALID;
       out->op_count = 0;
@@ -547,3 +944,31 @@ size_t decode_one(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t add
   set_bytes(out, p, i);
   return i;
 }
+
+size_t decode_batch(const DecodeCtx *ctx, const uint8_t *p, size_t n, uint64_t addr,
+                    Insn *out, size_t cap, size_t *used) {
+  size_t off = 0;
+  size_t count = 0;
+
+  while (off < n && count < cap) {
+    Insn *ins = &out[count++];
+    size_t k = decode_one(ctx, p + off, n - off, addr + off, ins);
+    if (k == 0) {
+      // same fallback as the listing: one raw byte, keep going
+      insn_init(ins, addr + off);
+      ins->op = OP_INVALID;
+      ins->size = 1;
+      set_bytes(ins, p + off, 1);
+      k = 1;
+    }
+    off += k;
+  }
+
+  if (used) *used = off;
+  return count;
+}
+
+int insn_is_fill(const Insn *in) {
+  if (in->op == OP_NOP) return 1;
+  return in->op == OP_INVALID && (in->bytes[0] == 0xCC || in->bytes[0] == 0x00);
+}
@@ -0,0 +1,471 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/dupreport.h"
+#include "opdump/image.h"
+#include "opdump/archive.h"
+#include "opdump/decode.h"
+#include "opdump/arena.h"
+
+enum {
+  DUP_BATCH = 4096,
+  DUP_CHUNK = 64,       // functions handed to a worker at a time
+  DUP_SHINGLE = 4,      // instructions per rolling-hash window
+  DUP_MH = 32,          // MinHash slots
+  DUP_ROWS = 4,         // slots per LSH band (DUP_MH / DUP_ROWS bands)
+  DUP_NEAR_MATCH = 26   // agreeing slots for "near" (~80% Jaccard)
+};
+
+static const uint64_t k_roll_base = 0x100000001b3ull;
+
+typedef struct {
+  char *label;
+  Image img;
+} DupUnit;
+
+typedef struct {
+  uint32_t unit;
+  const char *name;
+  uint64_t addr, size, offset;
+  uint64_t insns;
+  uint64_t hash;
+  uint32_t mh[DUP_MH];
+} DupFunc;
+
+typedef struct {
+  size_t first, count;  // range of the ordered exact-group list
+  size_t copies;
+  uint64_t bytes, largest, wasted;
+  unsigned sim;         // lowest similarity to the largest member, percent
+  size_t head;          // function named in the group row
+} DupGroup;
+
+// ---- normalization ----
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+  h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  return h * 0xff51afd7ed558ccdull;
+}
+
+static uint64_t insn_hash(const DupFunc *fn, const Insn *in) {
+  uint64_t h = mix(0, (uint64_t)in->op);
+  h = mix(h, in->has_cc ? (uint64_t)in->cc + 1 : 0);
+  h = mix(h, in->op_count);
+  int rel = in->op == OP_JCC_REL || in->op == OP_JMP_REL || in->op == OP_CALL_REL;
+  for (uint8_t i = 0; i < in->op_count; i++) {
+    const Operand *op = &in->ops[i];
+    h = mix(h, ((uint64_t)op->kind << 16) | op->width);
+    switch (op->kind) {
+      case O_REG: case O_KREG: h = mix(h, op->reg); break;
+      case O_IMM: {
+        uint64_t v = (uint64_t)op->imm;
+        if (rel && i == 0) {
+          // calls (even recursive ones) and jumps out of the function are masked
+          int inside = in->op != OP_CALL_REL && v >= fn->addr && v < fn->addr + fn->size;
+          v = inside ? v - fn->addr : UINT64_MAX;
+        }
+        h = mix(h, v);
+        break;
+      }
+      case O_MEM:
+        h = mix(h, ((uint64_t)op->mem.base << 16) | ((uint64_t)op->mem.index << 8) | op->mem.scale);
+        if (op->mem.base != MEM_RIP) h = mix(h, (uint64_t)(int64_t)op->mem.disp);
+        break;
+      default: break;
+    }
+  }
+  h = mix(h, ((uint64_t)in->enc << 40) | ((uint64_t)in->vl << 24) | ((uint64_t)in->vesize << 16) |
+             ((uint64_t)in->kmask << 8) | ((uint64_t)in->zeroing << 4) | in->bcast);
+  if (in->op == OP_INVALID) h = mix(h, in->bytes[0]);
+  return h;
+}
+
+static void add_shingle(DupFunc *fn, uint64_t s) {
+  for (unsigned j = 0; j < DUP_MH; j++) {
+    uint32_t v = (uint32_t)(mix(s, j) >> 32);
+    if (v < fn->mh[j]) fn->mh[j] = v;
+  }
+}
+
+static void hash_function(const Image *img, DupFunc *fn, Insn *batch) {
+  uint64_t base_k = 1;
+  for (unsigned i = 0; i < DUP_SHINGLE; i++) base_k *= k_roll_base;
+
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+  memset(fn->mh, 0xff, sizeof(fn->mh));
+  uint64_t win[DUP_SHINGLE] = {0};
+  uint64_t h = 0, roll = 0, off = 0;
+  while (off < fn->size) {
+    size_t used = 0;
+    size_t got = decode_batch(&ctx, img->buf + fn->offset + off, (size_t)(fn->size - off),
+                              fn->addr + off, batch, DUP_BATCH, &used);
+    off += used;
+    for (size_t k = 0; k < got; k++) {
+      uint64_t ih = insn_hash(fn, &batch[k]);
+      h = mix(h, ih);
+      // polynomial rolling hash over the last DUP_SHINGLE instructions
+      unsigned slot = (unsigned)(fn->insns % DUP_SHINGLE);
+      roll = roll * k_roll_base + ih - win[slot] * base_k;
+      win[slot] = ih;
+      if (++fn->insns >= DUP_SHINGLE) add_shingle(fn, roll);
+    }
+  }
+  if (fn->insns < DUP_SHINGLE) add_shingle(fn, h);
+  fn->hash = mix(h, fn->insns);
+}
+
+// ---- parallel hashing ----
+
+typedef struct {
+  const DupUnit *units;
+  DupFunc *f;
+  size_t n, next;
+  pthread_mutex_t mu;
+} DupWork;
+
+static void* hash_worker(void *arg) {
+  DupWork *w = (DupWork*)arg;
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, DUP_BATCH * sizeof(Insn));
+  if (!batch) return NULL;
+  for (;;) {
+    pthread_mutex_lock(&w->mu);
+    size_t i0 = w->next;
+    w->next = i0 + DUP_CHUNK < w->n ? i0 + DUP_CHUNK : w->n;
+    size_t i1 = w->next;
+    pthread_mutex_unlock(&w->mu);
+    if (i0 >= i1) break;
+    for (size_t i = i0; i < i1; i++) hash_function(&w->units[w->f[i].unit].img, &w->f[i], batch);
+  }
+  arena_reset(sa, batch_mark);
+  return NULL;
+}
+
+static void hash_all(const DupUnit *units, DupFunc *f, size_t n, size_t threads) {
+  DupWork w = { units, f, n, 0, PTHREAD_MUTEX_INITIALIZER };
+  if (threads == 0) threads = 1;
+  if (threads > n / DUP_CHUNK + 1) threads = n / DUP_CHUNK + 1;
+  pthread_t *th = (pthread_t*)calloc(threads, sizeof(pthread_t));
+  size_t started = 0;
+  for (size_t t = 1; th && t < threads; t++) {
+    if (pthread_create(&th[started], NULL, hash_worker, &w) != 0) break;
+    started++;
+  }
+  hash_worker(&w);
+  for (size_t t = 0; t < started; t++) pthread_join(th[t], NULL);
+  free(th);
+}
+
+// ---- inputs ----
+
+typedef struct {
+  DupUnit *u;
+  size_t n, cap;
+  Archive *ar;
+  size_t nar;
+} DupInputs;
+
+static int add_unit(DupInputs *in, const char *label, uint8_t *buf, size_t n) {
+  if (in->n == in->cap) {
+    size_t nc = in->cap ? in->cap * 2 : 16;
+    DupUnit *nu = (DupUnit*)realloc(in->u, nc * sizeof(DupUnit));
+    if (!nu) return IMG_ERR_READ;
+    in->u = nu;
+    in->cap = nc;
+  }
+  DupUnit *u = &in->u[in->n];
+  u->label = strdup(label);
+  if (!u->label) return IMG_ERR_READ;
+  int err = buf ? image_from_memory(u->label, buf, n, &u->img) : image_load(u->label, &u->img);
+  if (err != IMG_OK) {
+    free(u->label);
+    return err;
+  }
+  image_load_symbols(&u->img);
+  in->n++;
+  return IMG_OK;
+}
+
+static int load_inputs(const char *const *paths, size_t npaths, DupInputs *in) {
+  int rc = 0;
+  in->ar = (Archive*)calloc(npaths ? npaths : 1, sizeof(Archive));
+  if (!in->ar) return IMG_ERR_READ;
+  for (size_t p = 0; p < npaths; p++) {
+    int err;
+    if (archive_probe(paths[p])) {
+      Archive *ar = &in->ar[in->nar];
+      err = archive_open(paths[p], ar);
+      if (err == IMG_OK) {
+        in->nar++;
+        for (size_t m = 0; m < ar->count; m++) {
+          char label[512];
+          snprintf(label, sizeof(label), "%s(%s)", paths[p], ar->members[m].name);
+          int merr = add_unit(in, label, ar->members[m].data, ar->members[m].size);
+          // members without code are not worth a message
+          if (merr != IMG_OK && merr != IMG_ERR_NOEXEC) {
+            fprintf(stderr, "Error: %s: %s\n", label, image_strerror(merr));
+            rc = merr;
+          }
+        }
+        continue;
+      }
+    } else {
+      err = add_unit(in, paths[p], NULL, 0);
+    }
+    if (err != IMG_OK) {
+      fprintf(stderr, "Error: %s: %s\n", paths[p], image_strerror(err));
+      rc = err;
+    }
+  }
+  return rc;
+}
+
+static void free_inputs(DupInputs *in) {
+  for (size_t i = 0; i < in->n; i++) {
+    image_free(&in->u[i].img);
+    free(in->u[i].label);
+  }
+  for (size_t i = 0; i < in->nar; i++) archive_close(&in->ar[i]);
+  free(in->u);
+  free(in->ar);
+}
+
+static DupFunc* collect_functions(const DupInputs *in, uint64_t min_bytes, size_t *count) {
+  Arena *sa = arena_thread();
+  DupFunc *f = NULL;
+  size_t n = 0, cap = 0;
+  for (size_t u = 0; u < in->n; u++) {
+    const Image *img = &in->u[u].img;
+    for (size_t s = 0; s < img->seg_count; s++) {
+      ArenaMark mark = arena_mark(sa);
+      Region *regs = NULL;
+      size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+      for (size_t r = 0; r < nr; r++) {
+        if (!regs[r].name || regs[r].size < min_bytes || regs[r].size == 0) continue;
+        if (n == cap) {
+          size_t nc = cap ? cap * 2 : 1024;
+          DupFunc *nf = (DupFunc*)realloc(f, nc * sizeof(DupFunc));
+          if (!nf) break;
+          f = nf;
+          cap = nc;
+        }
+        DupFunc *fn = &f[n++];
+        memset(fn, 0, sizeof(*fn));
+        fn->unit = (uint32_t)u;
+        fn->name = regs[r].name;
+        fn->addr = regs[r].addr;
+        fn->size = regs[r].size;
+        fn->offset = regs[r].offset;
+      }
+      arena_reset(sa, mark);
+    }
+  }
+  *count = n;
+  return f;
+}
+
+// ---- grouping ----
+
+static _Thread_local const DupFunc *g_sort_base; // qsort has no context argument
+
+static int cmp_exact(const void *a, const void *b) {
+  const DupFunc *x = &g_sort_base[*(const size_t*)a], *y = &g_sort_base[*(const size_t*)b];
+  if (x->hash != y->hash) return (x->hash > y->hash) - (x->hash < y->hash);
+  if (x->size != y->size) return (x->size > y->size) - (x->size < y->size);
+  if (x->unit != y->unit) return (x->unit > y->unit) - (x->unit < y->unit);
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+typedef struct {
+  uint64_t key;
+  size_t g;
+} BandKey;
+
+static int cmp_band(const void *a, const void *b) {
+  const BandKey *x = (const BandKey*)a, *y = (const BandKey*)b;
+  if (x->key != y->key) return (x->key > y->key) - (x->key < y->key);
+  return (x->g > y->g) - (x->g < y->g);
+}
+
+static size_t uf_find(size_t *parent, size_t i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+static unsigned mh_match(const DupFunc *a, const DupFunc *b) {
+  unsigned m = 0;
+  for (unsigned j = 0; j < DUP_MH; j++) m += a->mh[j] == b->mh[j];
+  return m;
+}
+
+// Exact groups: first function of each (hash, size) run of the sorted index.
+typedef struct {
+  size_t first, count;    // range of the sorted function index
+  size_t root;
+} ExactGroup;
+
+static _Thread_local const ExactGroup *g_eg; // qsort has no context argument
+
+static int cmp_by_root(const void *a, const void *b) {
+  size_t x = *(const size_t*)a, y = *(const size_t*)b;
+  if (g_eg[x].root != g_eg[y].root) return (g_eg[x].root > g_eg[y].root) - (g_eg[x].root < g_eg[y].root);
+  return (x > y) - (x < y);
+}
+
+static int cmp_group(const void *a, const void *b) {
+  const DupGroup *x = (const DupGroup*)a, *y = (const DupGroup*)b;
+  if (x->wasted != y->wasted) return (x->wasted < y->wasted) - (x->wasted > y->wasted);
+  if (x->bytes != y->bytes) return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+  return (x->head > y->head) - (x->head < y->head);
+}
+
+// Unions exact groups whose signatures share an LSH band and agree in
+// at least DUP_NEAR_MATCH slots.
+static void near_groups(const DupFunc *f, const size_t *idx, ExactGroup *eg, size_t neg) {
+  size_t *parent = (size_t*)malloc((neg ? neg : 1) * sizeof(size_t));
+  BandKey *keys = (BandKey*)malloc((neg ? neg : 1) * sizeof(BandKey));
+  for (size_t g = 0; g < neg; g++) eg[g].root = g;
+  if (!parent || !keys) { free(parent); free(keys); return; }
+  for (size_t g = 0; g < neg; g++) parent[g] = g;
+
+  for (unsigned b = 0; b < DUP_MH / DUP_ROWS; b++) {
+    for (size_t g = 0; g < neg; g++) {
+      const DupFunc *fn = &f[idx[eg[g].first]];
+      uint64_t k = mix(0, b);
+      for (unsigned r = 0; r < DUP_ROWS; r++) k = mix(k, fn->mh[b * DUP_ROWS + r]);
+      keys[g].key = k;
+      keys[g].g = g;
+    }
+    qsort(keys, neg, sizeof(BandKey), cmp_band);
+    for (size_t i = 0; i < neg;) {
+      size_t j = i + 1;
+      while (j < neg && keys[j].key == keys[i].key) j++;
+      // compare against the head of the bucket and the previous entry
+      for (size_t k = i + 1; k < j; k++) {
+        const DupFunc *x = &f[idx[eg[keys[k].g].first]];
+        size_t cand[2] = { keys[i].g, keys[k - 1].g };
+        for (int c = 0; c < 2; c++) {
+          if (mh_match(x, &f[idx[eg[cand[c]].first]]) < DUP_NEAR_MATCH) continue;
+          size_t ra = uf_find(parent, keys[k].g), rb = uf_find(parent, cand[c]);
+          if (ra != rb) parent[ra < rb ? rb : ra] = ra < rb ? ra : rb;
+        }
+      }
+      i = j;
+    }
+  }
+  for (size_t g = 0; g < neg; g++) eg[g].root = uf_find(parent, g);
+  free(parent);
+  free(keys);
+}
+
+// ---- output ----
+
+static void print_member(FILE *out, const DupInputs *in, const DupFunc *fn) {
+  fprintf(out, "        ");
+  if (in->n > 1) fprintf(out, "%s: ", in->u[fn->unit].label);
+  fprintf(out, "%016llx %8llu %6llu  %s\n", (unsigned long long)fn->addr,
+    (unsigned long long)fn->size, (unsigned long long)fn->insns, fn->name);
+}
+
+int dup_report(FILE *out, const char *const *paths, size_t npaths, const DupOptions *opt) {
+  DupInputs in;
+  memset(&in, 0, sizeof(in));
+  int rc = load_inputs(paths, npaths, &in);
+
+  size_t n = 0;
+  DupFunc *f = collect_functions(&in, opt->min_bytes, &n);
+  hash_all(in.u, f, n, opt->threads);
+
+  size_t *idx = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+  ExactGroup *eg = (ExactGroup*)malloc((n ? n : 1) * sizeof(ExactGroup));
+  size_t *order = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+  DupGroup *grp = (DupGroup*)malloc((n ? n : 1) * sizeof(DupGroup));
+  if (!idx || !eg || !order || !grp) {
+    free(idx); free(eg); free(order); free(grp); free(f);
+    free_inputs(&in);
+    return IMG_ERR_READ;
+  }
+  for (size_t i = 0; i < n; i++) idx[i] = i;
+  g_sort_base = f;
+  qsort(idx, n, sizeof(size_t), cmp_exact);
+
+  size_t neg = 0;
+  for (size_t i = 0; i < n;) {
+    size_t j = i + 1;
+    while (j < n && f[idx[j]].hash == f[idx[i]].hash && f[idx[j]].size == f[idx[i]].size) j++;
+    eg[neg].first = i;
+    eg[neg].count = j - i;
+    neg++;
+    i = j;
+  }
+  near_groups(f, idx, eg, neg);
+
+  for (size_t g = 0; g < neg; g++) order[g] = g;
+  g_eg = eg;
+  qsort(order, neg, sizeof(size_t), cmp_by_root);
+
+  size_t ngrp = 0, nexact = 0, nnear = 0;
+  uint64_t total_bytes = 0, total_wasted = 0;
+  for (size_t i = 0; i < n; i++) total_bytes += f[i].size;
+  for (size_t i = 0; i < neg;) {
+    size_t j = i + 1;
+    while (j < neg && eg[order[j]].root == eg[order[i]].root) j++;
+    DupGroup gr;
+    memset(&gr, 0, sizeof(gr));
+    gr.first = i;
+    gr.count = j - i;
+    gr.sim = 100;
+    for (size_t k = i; k < j; k++) {
+      const ExactGroup *e = &eg[order[k]];
+      const DupFunc *fn = &f[idx[e->first]];
+      gr.copies += e->count;
+      gr.bytes += fn->size * e->count;
+      if (fn->size > gr.largest || (fn->size == gr.largest && idx[e->first] < gr.head)) {
+        gr.largest = fn->size;
+        gr.head = idx[e->first];
+      }
+    }
+    if (gr.copies > 1) {
+      for (size_t k = i; k < j; k++) {
+        unsigned s = mh_match(&f[idx[eg[order[k]].first]], &f[gr.head]) * 100 / DUP_MH;
+        if (s < gr.sim) gr.sim = s;
+      }
+      gr.wasted = gr.bytes - gr.largest;
+      total_wasted += gr.wasted;
+      if (gr.count > 1) nnear++;
+      else nexact++;
+      grp[ngrp++] = gr;
+    }
+    i = j;
+  }
+  qsort(grp, ngrp, sizeof(DupGroup), cmp_group);
+
+  fprintf(out, "# rank  kind   copies      bytes     wasted   sim  function\n");
+  for (size_t r = 0; r < ngrp; r++) {
+    const DupGroup *gr = &grp[r];
+    fprintf(out, "%6zu  %-5s %7zu %10llu %10llu  %3u%%  %s\n", r + 1,
+      gr->count > 1 ? "near" : "exact", gr->copies, (unsigned long long)gr->bytes,
+      (unsigned long long)gr->wasted, gr->sim, f[gr->head].name);
+    for (size_t k = gr->first; k < gr->first + gr->count; k++) {
+      const ExactGroup *e = &eg[order[k]];
+      for (size_t m = e->first; m < e->first + e->count; m++) print_member(out, &in, &f[idx[m]]);
+    }
+  }
+  fprintf(out, "# %zu exact + %zu near groups, %llu of %llu bytes wasted in %zu functions >= %llu bytes\n",
+    nexact, nnear, (unsigned long long)total_wasted, (unsigned long long)total_bytes, n,
+    (unsigned long long)opt->min_bytes);
+
+  free(idx);
+  free(eg);
+  free(order);
+  free(grp);
+  free(f);
+  free_inputs(&in);
+  return rc;
+}
@@ -0,0 +1,536 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/dwarf_line.h"
+
+static uint16_t rd16le(const uint8_t *p){ return (uint16_t)(p[0] | (p[1]<<8)); }
+static uint32_t rd32le(const uint8_t *p){ return (uint32_t)(p[0] | (p[1]<<8) | (p[2]<<16) | ((uint32_t)p[3]<<24)); }
+static uint64_t rd64le(const uint8_t *p){
+  return (uint64_t)rd32le(p) | ((uint64_t)rd32le(p+4) << 32);
+}
+
+enum { SHF_COMPRESSED = 0x800 };
+
+typedef struct {
+  const uint8_t *p;
+  uint64_t size;
+} Sect;
+
+// ---- bounded reader ----
+
+typedef struct {
+  const uint8_t *p, *end;
+  int bad;
+} Rd;
+
+static uint64_t rd_n(Rd *r, unsigned n) {
+  if (r->bad || (uint64_t)(r->end - r->p) < n) { r->bad = 1; r->p = r->end; return 0; }
+  uint64_t v = 0;
+  switch (n) {
+    case 1: v = r->p[0]; break;
+    case 2: v = rd16le(r->p); break;
+    case 4: v = rd32le(r->p); break;
+    case 8: v = rd64le(r->p); break;
+    default: break;
+  }
+  r->p += n;
+  return v;
+}
+
+static void rd_skip(Rd *r, uint64_t n) {
+  if (r->bad || (uint64_t)(r->end - r->p) < n) { r->bad = 1; r->p = r->end; return; }
+  r->p += n;
+}
+
+static uint64_t rd_uleb(Rd *r) {
+  uint64_t v = 0;
+  unsigned shift = 0;
+  while (r->p < r->end) {
+    uint8_t b = *r->p++;
+    if (shift < 64) v |= (uint64_t)(b & 0x7F) << shift;
+    shift += 7;
+    if (!(b & 0x80)) return v;
+  }
+  r->bad = 1;
+  return v;
+}
+
+static int64_t rd_sleb(Rd *r) {
+  int64_t v = 0;
+  unsigned shift = 0;
+  uint8_t b = 0;
+  while (r->p < r->end) {
+    b = *r->p++;
+    if (shift < 64) v |= (int64_t)((uint64_t)(b & 0x7F) << shift);
+    shift += 7;
+    if (!(b & 0x80)) {
+      if (shift < 64 && (b & 0x40)) v |= -((int64_t)1 << shift);
+      return v;
+    }
+  }
+  r->bad = 1;
+  return v;
+}
+
+static const char* rd_cstr(Rd *r) {
+  const uint8_t *s = r->p;
+  while (r->p < r->end && *r->p) r->p++;
+  if (r->p == r->end) { r->bad = 1; return NULL; }
+  r->p++;
+  return (const char*)s;
+}
+
+// Initial length: sets *off_size to 4 or 8; returns the unit's end.
+static const uint8_t* rd_unit(Rd *r, unsigned *off_size) {
+  uint64_t len = rd_n(r, 4);
+  *off_size = 4;
+  if (len == 0xFFFFFFFFu) { len = rd_n(r, 8); *off_size = 8; }
+  if (r->bad || len > (uint64_t)(r->end - r->p)) { r->bad = 1; return r->end; }
+  return r->p + len;
+}
+
+// ---- sections ----
+
+static void find_sections(const uint8_t *d, size_t n, const char *const *names, Sect *out,
+                          size_t count) {
+  memset(out, 0, count * sizeof(Sect));
+  if (n < 64) return;
+  uint64_t e_shoff     = rd64le(d + 40);
+  uint16_t e_shentsize = rd16le(d + 58);
+  uint16_t e_shnum     = rd16le(d + 60);
+  uint16_t e_shstrndx  = rd16le(d + 62);
+  if (e_shoff == 0 || e_shentsize < 64 || e_shnum == 0 || e_shstrndx >= e_shnum) return;
+  if (e_shoff + (uint64_t)e_shentsize * (uint64_t)e_shnum > n) return;
+
+  const uint8_t *sh_base = d + e_shoff;
+  const uint8_t *sh_str  = sh_base + (uint64_t)e_shentsize * e_shstrndx;
+  uint64_t shstr_off = rd64le(sh_str + 24), shstr_size = rd64le(sh_str + 32);
+  if (shstr_off + shstr_size > n) return;
+
+  for (uint16_t i = 0; i < e_shnum; i++) {
+    const uint8_t *sh = sh_base + (uint64_t)e_shentsize * i;
+    uint32_t sh_name = rd32le(sh);
+    if (sh_name >= shstr_size) continue;
+    const char *name = (const char*)d + shstr_off + sh_name;
+    uint64_t flags = rd64le(sh + 8), off = rd64le(sh + 24), size = rd64le(sh + 32);
+    if ((flags & SHF_COMPRESSED) || off > n || size > n - off) continue;
+    for (size_t k = 0; k < count; k++) {
+      if (strcmp(name, names[k]) == 0) {
+        out[k].p = d + off;
+        out[k].size = size;
+      }
+    }
+  }
+}
+
+enum { S_LINE, S_LINE_STR, S_STR, S_INFO, S_ABBREV, S_ARANGES, S__COUNT };
+
+static const char *const k_sect_names[S__COUNT] = {
+  ".debug_line", ".debug_line_str", ".debug_str", ".debug_info", ".debug_abbrev", ".debug_aranges"
+};
+
+// ---- DW_FORM handling ----
+
+enum {
+  DW_FORM_addr = 0x01, DW_FORM_block2 = 0x03, DW_FORM_block4 = 0x04, DW_FORM_data2 = 0x05,
+  DW_FORM_data4 = 0x06, DW_FORM_data8 = 0x07, DW_FORM_string = 0x08, DW_FORM_block = 0x09,
+  DW_FORM_block1 = 0x0a, DW_FORM_data1 = 0x0b, DW_FORM_flag = 0x0c, DW_FORM_sdata = 0x0d,
+  DW_FORM_strp = 0x0e, DW_FORM_udata = 0x0f, DW_FORM_ref_addr = 0x10, DW_FORM_ref1 = 0x11,
+  DW_FORM_ref2 = 0x12, DW_FORM_ref4 = 0x13, DW_FORM_ref8 = 0x14, DW_FORM_ref_udata = 0x15,
+  DW_FORM_indirect = 0x16, DW_FORM_sec_offset = 0x17, DW_FORM_exprloc = 0x18,
+  DW_FORM_flag_present = 0x19, DW_FORM_strx = 0x1a, DW_FORM_addrx = 0x1b,
+  DW_FORM_ref_sup4 = 0x1c, DW_FORM_strp_sup = 0x1d, DW_FORM_data16 = 0x1e,
+  DW_FORM_line_strp = 0x1f, DW_FORM_ref_sig8 = 0x20, DW_FORM_implicit_const = 0x21,
+  DW_FORM_loclistx = 0x22, DW_FORM_rnglistx = 0x23, DW_FORM_ref_sup8 = 0x24,
+  DW_FORM_strx1 = 0x25, DW_FORM_strx2 = 0x26, DW_FORM_strx3 = 0x27, DW_FORM_strx4 = 0x28,
+  DW_FORM_addrx1 = 0x29, DW_FORM_addrx2 = 0x2a, DW_FORM_addrx3 = 0x2b, DW_FORM_addrx4 = 0x2c
+};
+
+enum { DW_AT_stmt_list = 0x10 };
+
+// Reads a constant / offset form; strings and blocks are skipped (returns 0).
+static uint64_t rd_form(Rd *r, uint64_t form, unsigned off_size, unsigned addr_size) {
+  switch (form) {
+    case DW_FORM_addr:          return rd_n(r, addr_size);
+    case DW_FORM_data1: case DW_FORM_ref1: case DW_FORM_flag:
+    case DW_FORM_strx1: case DW_FORM_addrx1:  return rd_n(r, 1);
+    case DW_FORM_data2: case DW_FORM_ref2:
+    case DW_FORM_strx2: case DW_FORM_addrx2:  return rd_n(r, 2);
+    case DW_FORM_strx3: case DW_FORM_addrx3:  rd_skip(r, 3); return 0;
+    case DW_FORM_data4: case DW_FORM_ref4: case DW_FORM_ref_sup4:
+    case DW_FORM_strx4: case DW_FORM_addrx4:  return rd_n(r, 4);
+    case DW_FORM_data8: case DW_FORM_ref8: case DW_FORM_ref_sig8:
+    case DW_FORM_ref_sup8:                    return rd_n(r, 8);
+    case DW_FORM_data16:        rd_skip(r, 16); return 0;
+    case DW_FORM_string:        rd_cstr(r); return 0;
+    case DW_FORM_block1:        rd_skip(r, rd_n(r, 1)); return 0;
+    case DW_FORM_block2:        rd_skip(r, rd_n(r, 2)); return 0;
+    case DW_FORM_block4:        rd_skip(r, rd_n(r, 4)); return 0;
+    case DW_FORM_block: case DW_FORM_exprloc: rd_skip(r, rd_uleb(r)); return 0;
+    case DW_FORM_sdata:         return (uint64_t)rd_sleb(r);
+    case DW_FORM_udata: case DW_FORM_ref_udata: case DW_FORM_strx: case DW_FORM_addrx:
+    case DW_FORM_loclistx: case DW_FORM_rnglistx: return rd_uleb(r);
+    case DW_FORM_strp: case DW_FORM_line_strp: case DW_FORM_sec_offset:
+    case DW_FORM_ref_addr: case DW_FORM_strp_sup: return rd_n(r, off_size);
+    case DW_FORM_flag_present: case DW_FORM_implicit_const: return 0;
+    case DW_FORM_indirect:      return rd_form(r, rd_uleb(r), off_size, addr_size);
+    default:                    r->bad = 1; return 0;
+  }
+}
+
+// DW_AT_stmt_list of the compile unit at info_off, or UINT64_MAX.
+static uint64_t cu_stmt_list(const Sect *s, uint64_t info_off) {
+  if (info_off >= s[S_INFO].size) return UINT64_MAX;
+  Rd r = { s[S_INFO].p + info_off, s[S_INFO].p + s[S_INFO].size, 0 };
+  unsigned off_size;
+  const uint8_t *end = rd_unit(&r, &off_size);
+  r.end = end;
+  uint16_t ver = (uint16_t)rd_n(&r, 2);
+  uint64_t abbrev_off;
+  unsigned addr_size;
+  if (ver >= 5) {
+    rd_n(&r, 1); // unit_type
+    addr_size = (unsigned)rd_n(&r, 1);
+    abbrev_off = rd_n(&r, off_size);
+  } else {
+    abbrev_off = rd_n(&r, off_size);
+    addr_size = (unsigned)rd_n(&r, 1);
+  }
+  uint64_t code = rd_uleb(&r);
+  if (r.bad || code == 0 || abbrev_off >= s[S_ABBREV].size) return UINT64_MAX;
+
+  Rd a = { s[S_ABBREV].p + abbrev_off, s[S_ABBREV].p + s[S_ABBREV].size, 0 };
+  for (;;) {
+    uint64_t c = rd_uleb(&a);
+    if (a.bad || c == 0) return UINT64_MAX;
+    rd_uleb(&a);     // tag
+    rd_n(&a, 1);     // children
+    int match = (c == code);
+    for (;;) {
+      uint64_t at = rd_uleb(&a), form = rd_uleb(&a);
+      if (a.bad) return UINT64_MAX;
+      if (at == 0 && form == 0) break;
+      if (form == DW_FORM_implicit_const) rd_sleb(&a);
+      if (!match) continue;
+      uint64_t v = rd_form(&r, form, off_size, addr_size);
+      if (r.bad) return UINT64_MAX;
+      if (at == DW_AT_stmt_list) return v;
+    }
+    if (match) return UINT64_MAX;
+  }
+}
+
+// ---- line programs ----
+
+enum { MAX_DIRS = 1024, MAX_FILES = 4096 };
+
+typedef struct {
+  LineTable *t;
+  size_t rows_cap, files_cap;
+  uint64_t lo, hi;
+  LineRow pend;        // last row before lo in the current sequence
+  int has_pend;
+
+  // one unit's directory / file tables
+  const char *dpaths[MAX_DIRS], *fpaths[MAX_FILES];
+  uint64_t ddirs[MAX_DIRS], fdirs[MAX_FILES];
+} Builder;
+
+static int add_file(Builder *b, const char *dir, const char *name) {
+  if (b->t->nfiles == b->files_cap) {
+    size_t nc = b->files_cap ? b->files_cap * 2 : 256;
+    LineFile *nf = (LineFile*)realloc(b->t->files, nc * sizeof(LineFile));
+    if (!nf) return 0;
+    b->t->files = nf;
+    b->files_cap = nc;
+  }
+  b->t->files[b->t->nfiles].dir = dir;
+  b->t->files[b->t->nfiles].name = name;
+  b->t->nfiles++;
+  return 1;
+}
+
+static void push_row(Builder *b, const LineRow *row) {
+  if (b->t->n == b->rows_cap) {
+    size_t nc = b->rows_cap ? b->rows_cap * 2 : 4096;
+    LineRow *nr = (LineRow*)realloc(b->t->rows, nc * sizeof(LineRow));
+    if (!nr) return;
+    b->t->rows = nr;
+    b->rows_cap = nc;
+  }
+  b->t->rows[b->t->n++] = *row;
+}
+
+// Keeps rows inside [lo, hi) plus the one in effect at lo.
+static void add_row(Builder *b, uint64_t addr, uint32_t file, uint32_t line) {
+  LineRow row = { addr, file, line };
+  if (addr < b->lo) {
+    b->pend = row;
+    b->has_pend = (file != UINT32_MAX);
+    return;
+  }
+  if (b->has_pend) {
+    push_row(b, &b->pend);
+    b->has_pend = 0;
+  }
+  if (addr < b->hi) push_row(b, &row);
+}
+
+enum { DW_LNCT_path = 1, DW_LNCT_directory_index = 2 };
+
+// DWARF 5 directory / file entry list into paths / dirs (directory index).
+static size_t read_v5_entries(Rd *r, const Sect *s, unsigned off_size,
+                              const char **paths, uint64_t *dirs, size_t cap) {
+  uint8_t nfmt = (uint8_t)rd_n(r, 1);
+  uint64_t fmt[16][2];
+  for (uint8_t i = 0; i < nfmt; i++) {
+    uint64_t ct = rd_uleb(r), form = rd_uleb(r);
+    if (i < 16) { fmt[i][0] = ct; fmt[i][1] = form; }
+  }
+  if (nfmt > 16) { r->bad = 1; return 0; }
+  uint64_t count = rd_uleb(r);
+  size_t kept = 0;
+  for (uint64_t e = 0; e < count && !r->bad; e++) {
+    const char *path = NULL;
+    uint64_t dir = 0;
+    for (uint8_t i = 0; i < nfmt; i++) {
+      uint64_t form = fmt[i][1];
+      if (fmt[i][0] == DW_LNCT_path) {
+        if (form == DW_FORM_string) { path = rd_cstr(r); continue; }
+        uint64_t off = rd_form(r, form, off_size, 8);
+        const Sect *str = form == DW_FORM_line_strp ? &s[S_LINE_STR] :
+                          form == DW_FORM_strp ? &s[S_STR] : NULL;
+        if (str && str->p && off < str->size && memchr(str->p + off, 0, str->size - off)) {
+          path = (const char*)str->p + off;
+        }
+      } else if (fmt[i][0] == DW_LNCT_directory_index) {
+        dir = rd_form(r, form, off_size, 8);
+      } else {
+        rd_form(r, form, off_size, 8);
+      }
+    }
+    if (kept < cap) { paths[kept] = path; dirs[kept] = dir; kept++; }
+  }
+  return kept;
+}
+
+static void run_program(Builder *b, const Sect *s, uint64_t off) {
+  if (off >= s[S_LINE].size) return;
+  Rd r = { s[S_LINE].p + off, s[S_LINE].p + s[S_LINE].size, 0 };
+  unsigned off_size;
+  const uint8_t *end = rd_unit(&r, &off_size);
+  r.end = end;
+
+  uint16_t ver = (uint16_t)rd_n(&r, 2);
+  if (ver < 2 || ver > 5) return;
+  if (ver >= 5) rd_n(&r, 2); // address_size, segment_selector_size
+  uint64_t hdr_len = rd_n(&r, off_size);
+  const uint8_t *prog = r.p + hdr_len;
+  if (r.bad || hdr_len > (uint64_t)(end - r.p)) return;
+
+  uint8_t min_inst = (uint8_t)rd_n(&r, 1);
+  if (ver >= 4) rd_n(&r, 1); // maximum_operations_per_instruction (VLIW only)
+  uint8_t default_stmt = (uint8_t)rd_n(&r, 1);
+  int8_t  line_base = (int8_t)rd_n(&r, 1);
+  uint8_t line_range = (uint8_t)rd_n(&r, 1);
+  uint8_t opcode_base = (uint8_t)rd_n(&r, 1);
+  uint8_t std_len[256] = {0};
+  for (unsigned i = 1; i < opcode_base; i++) std_len[i] = (uint8_t)rd_n(&r, 1);
+  if (r.bad || line_range == 0) return;
+  (void)default_stmt;
+
+  // directory and file tables; file numbers index fbase
+  const char **dpaths = b->dpaths, **fpaths = b->fpaths;
+  uint64_t *ddirs = b->ddirs, *fdirs = b->fdirs;
+  size_t nd = 0, nf = 0;
+  if (ver >= 5) {
+    nd = read_v5_entries(&r, s, off_size, dpaths, ddirs, MAX_DIRS);
+    nf = read_v5_entries(&r, s, off_size, fpaths, fdirs, MAX_FILES);
+  } else {
+    dpaths[nd++] = NULL; // directory 0: the compilation directory
+    for (;;) {
+      const char *d = rd_cstr(&r);
+      if (!d || !*d) break;
+      if (nd < MAX_DIRS) dpaths[nd++] = d;
+    }
+    fpaths[nf] = NULL; fdirs[nf] = 0; nf++; // v2-4 files are numbered from 1
+    for (;;) {
+      const char *f = rd_cstr(&r);
+      if (!f || !*f) break;
+      uint64_t dir = rd_uleb(&r);
+      rd_uleb(&r); rd_uleb(&r);
+      if (nf < MAX_FILES) { fpaths[nf] = f; fdirs[nf] = dir; nf++; }
+    }
+  }
+  if (r.bad) return;
+  b->has_pend = 0;
+
+  const uint32_t fbase = (uint32_t)b->t->nfiles;
+  for (size_t i = 0; i < nf; i++) {
+    const char *dir = fdirs[i] < nd ? dpaths[fdirs[i]] : NULL;
+    if (fpaths[i] && fpaths[i][0] == '/') dir = NULL;
+    if (!add_file(b, dir, fpaths[i] ? fpaths[i] : "?")) return;
+  }
+
+  r.p = prog;
+  uint64_t addr = 0;
+  uint32_t file = 1, line = 1;
+  while (r.p < r.end && !r.bad) {
+    uint8_t op = (uint8_t)rd_n(&r, 1);
+    if (op >= opcode_base) {
+      unsigned adj = (unsigned)(op - opcode_base);
+      addr += (uint64_t)(adj / line_range) * min_inst;
+      line += (uint32_t)(line_base + (int)(adj % line_range));
+      if (file < nf) add_row(b, addr, fbase + file, line);
+      continue;
+    }
+    switch (op) {
+      case 0: {
+        uint64_t len = rd_uleb(&r);
+        const uint8_t *next = r.p + len;
+        if (len == 0 || len > (uint64_t)(r.end - r.p)) { r.bad = 1; break; }
+        uint8_t sub = (uint8_t)rd_n(&r, 1);
+        if (sub == 1) {           // end_sequence
+          add_row(b, addr, UINT32_MAX, 0);
+          addr = 0; file = 1; line = 1;
+        } else if (sub == 2) {    // set_address
+          addr = rd_n(&r, len - 1 == 8 ? 8 : 4);
+        }
+        r.p = next;
+        break;
+      }
+      case 1: if (file < nf) add_row(b, addr, fbase + file, line); break;  // copy
+      case 2: addr += rd_uleb(&r) * min_inst; break;
+      case 3: line += (uint32_t)rd_sleb(&r); break;
+      case 4: file = (uint32_t)rd_uleb(&r); break;
+      case 8: addr += (uint64_t)((255 - opcode_base) / line_range) * min_inst; break;
+      case 9: addr += rd_n(&r, 2); break;
+      default:
+        for (unsigned i = 0; i < std_len[op]; i++) rd_uleb(&r);
+        break;
+    }
+  }
+}
+
+// ---- unit selection ----
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+// .debug_info offsets of the CUs with an address range overlapping [lo, hi).
+static size_t aranges_units(const Sect *s, uint64_t lo, uint64_t hi, uint64_t **out) {
+  *out = NULL;
+  size_t n = 0, cap = 0;
+  Rd r = { s[S_ARANGES].p, s[S_ARANGES].p + s[S_ARANGES].size, 0 };
+  while (r.p < r.end && !r.bad) {
+    const uint8_t *set = r.p;
+    unsigned off_size;
+    const uint8_t *end = rd_unit(&r, &off_size);
+    Rd u = { r.p, end, 0 };
+    r.p = end;
+
+    rd_n(&u, 2);
+    uint64_t cu = rd_n(&u, off_size);
+    unsigned asz = (unsigned)rd_n(&u, 1);
+    rd_n(&u, 1);
+    if (u.bad || (asz != 4 && asz != 8)) continue;
+    size_t hdr = (size_t)(u.p - set);
+    rd_skip(&u, (2 * asz - hdr % (2 * asz)) % (2 * asz));
+
+    while (!u.bad && u.p < u.end) {
+      uint64_t a = rd_n(&u, asz), len = rd_n(&u, asz);
+      if (a == 0 && len == 0) break;
+      if (a < hi && a + len > lo) {
+        if (n == cap) {
+          size_t nc = cap ? cap * 2 : 64;
+          uint64_t *nv = (uint64_t*)realloc(*out, nc * sizeof(uint64_t));
+          if (!nv) return n;
+          *out = nv;
+          cap = nc;
+        }
+        (*out)[n++] = cu;
+        break;
+      }
+    }
+  }
+  return n;
+}
+
+static int cmp_row(const void *a, const void *b) {
+  const LineRow *x = (const LineRow*)a, *y = (const LineRow*)b;
+  if (x->addr != y->addr) return (x->addr > y->addr) - (x->addr < y->addr);
+  // a sequence end sorts before a row starting at the same address
+  int ex = x->file == UINT32_MAX, ey = y->file == UINT32_MAX;
+  return ey - ex;
+}
+
+int line_table_load(const Image *img, uint64_t lo, uint64_t hi, LineTable *out) {
+  memset(out, 0, sizeof(*out));
+  Sect s[S__COUNT];
+  find_sections(img->buf, img->n, k_sect_names, s, S__COUNT);
+  if (!s[S_LINE].p) return 0;
+
+  Builder *b = (Builder*)calloc(1, sizeof(Builder));
+  if (!b) return 1;
+  b->t = out;
+  b->lo = lo;
+  b->hi = hi;
+  uint64_t *units = NULL;
+  size_t nu = (s[S_ARANGES].p && s[S_INFO].p && s[S_ABBREV].p) ? aranges_units(&s[0], lo, hi, &units) : 0;
+
+  if (nu) {
+    uint64_t *progs = (uint64_t*)malloc(nu * sizeof(uint64_t));
+    size_t np = 0;
+    for (size_t i = 0; progs && i < nu; i++) {
+      uint64_t off = cu_stmt_list(s, units[i]);
+      if (off != UINT64_MAX) progs[np++] = off;
+    }
+    if (progs) {
+      qsort(progs, np, sizeof(uint64_t), cmp_u64);
+      for (size_t i = 0; i < np; i++) {
+        if (i == 0 || progs[i] != progs[i - 1]) run_program(b, s, progs[i]);
+      }
+    }
+    free(progs);
+  } else {
+    // no index: run every unit's program
+    Rd r = { s[S_LINE].p, s[S_LINE].p + s[S_LINE].size, 0 };
+    while (r.p < r.end && !r.bad) {
+      uint64_t off = (uint64_t)(r.p - s[S_LINE].p);
+      unsigned off_size;
+      r.p = rd_unit(&r, &off_size);
+      run_program(b, s, off);
+    }
+  }
+  free(units);
+  free(b);
+
+  qsort(out->rows, out->n, sizeof(LineRow), cmp_row);
+  return 1;
+}
+
+void line_table_free(LineTable *t) {
+  free(t->rows);
+  free(t->files);
+  memset(t, 0, sizeof(*t));
+}
+
+size_t line_table_seek(const LineTable *t, uint64_t addr) {
+  // last row with row.addr <= addr
+  size_t lo = 0, hi = t->n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (t->rows[mid].addr <= addr) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo ? lo - 1 : 0;
+}
+
+const LineRow* line_table_at(const LineTable *t, size_t *cur, uint64_t addr) {
+  if (t->n == 0) return NULL;
+  while (*cur + 1 < t->n && t->rows[*cur + 1].addr <= addr) (*cur)++;
+  const LineRow *r = &t->rows[*cur];
+  if (r->addr > addr || r->file == UINT32_MAX) return NULL;
+  return r;
+}
@@ -16,6 +16,7 @@ enum { ELFCLASS64=2, ELFDATA2LSB=1 };
 
 enum { PT_LOAD = 1 };
 enum { PF_X = 1, PF_W = 2, PF_R = 4 };
+enum { SHT_PROGBITS = 1, SHF_EXECINSTR = 4 };
 
 int elf64_parse_info(const uint8_t *b, size_t n, ElfInfo *out) {
   if (!out) return 0;
@@ -36,6 +37,18 @@ int elf64_parse_info(const uint8_t *b, size_t n, ElfInfo *out) {
   out->phoff     = rd64le(b + 32);
   out->phentsz   = rd16le(b + 54);
   out->phnum     = rd16le(b + 56);
+  out->shoff     = rd64le(b + 40);
+  out->shentsz   = rd16le(b + 58);
+  out->shnum     = rd16le(b + 60);
+  out->shstrndx  = rd16le(b + 62);
+
+  // relocatable objects have sections only
+  if (out->e_type == ET_REL) {
+    if (out->shoff == 0 || out->shentsz < 64 || out->shnum == 0) return 0;
+    if (out->shoff + (uint64_t)out->shentsz * (uint64_t)out->shnum > (uint64_t)n) return 0;
+    out->ok = 1;
+    return 1;
+  }
 
   // sanity
   if (out->phoff == 0 || out->phentsz == 0 || out->phnum == 0) return 0;
@@ -90,3 +103,58 @@ size_t elf64_collect_exec_segments(const uint8_t *b, size_t n,
   // if cap smaller, return how many were actually written? (we return total found)
   return (count <= cap || !out_segs) ? count : cap;
 }
+
+size_t elf64_collect_exec_sections(const uint8_t *b, size_t n,
+                                   ElfExecSeg *out_segs, size_t cap) {
+  ElfInfo inf;
+  if (!elf64_parse_info(b, n, &inf) || inf.e_type != ET_REL) return 0;
+
+  size_t count = 0;
+  uint64_t at = 0;
+
+  // ELF64_Shdr: sh_type u32 @4, sh_flags u64 @8, sh_offset u64 @24,
+  // sh_size u64 @32, sh_addralign u64 @48
+  for (uint16_t i = 1; i < inf.shnum && count < cap; i++) {
+    const uint8_t *sh = b + (size_t)inf.shoff + (size_t)i * (size_t)inf.shentsz;
+
+    uint32_t sh_type  = rd32le(sh + 4);
+    uint64_t sh_flags = rd64le(sh + 8);
+    uint64_t sh_off   = rd64le(sh + 24);
+    uint64_t sh_size  = rd64le(sh + 32);
+    uint64_t sh_align = rd64le(sh + 48);
+
+    if (sh_type != SHT_PROGBITS || (sh_flags & SHF_EXECINSTR) == 0) continue;
+    if (sh_size == 0 || sh_off + sh_size > (uint64_t)n) continue;
+
+    if (sh_align > 1 && (sh_align & (sh_align - 1)) == 0) at = (at + sh_align - 1) & ~(sh_align - 1);
+    if (out_segs) {
+      out_segs[count].vaddr  = at;
+      out_segs[count].offset = sh_off;
+      out_segs[count].filesz = sh_size;
+      out_segs[count].memsz  = sh_size;
+      out_segs[count].flags  = PF_R | PF_X;
+      out_segs[count].shndx  = i;
+    }
+    count++;
+    at += sh_size;
+  }
+  return count;
+}
+
+const char* elf64_section_name(const uint8_t *b, size_t n, uint32_t idx) {
+  ElfInfo inf;
+  if (!elf64_parse_info(b, n, &inf) || inf.shoff == 0 || inf.shentsz < 64) return NULL;
+  if (idx >= inf.shnum || inf.shstrndx >= inf.shnum) return NULL;
+  if (inf.shoff + (uint64_t)inf.shentsz * (uint64_t)inf.shnum > (uint64_t)n) return NULL;
+
+  const uint8_t *str = b + (size_t)inf.shoff + (size_t)inf.shstrndx * (size_t)inf.shentsz;
+  uint64_t str_off  = rd64le(str + 24);
+  uint64_t str_size = rd64le(str + 32);
+  if (str_off + str_size > (uint64_t)n) return NULL;
+
+  const uint8_t *sh = b + (size_t)inf.shoff + (size_t)idx * (size_t)inf.shentsz;
+  uint32_t name = rd32le(sh + 0);
+  if (name >= str_size) return NULL;
+  const char *s = (const char*)b + str_off + name;
+  return memchr(s, 0, (size_t)(str_size - name)) ? s : NULL;
+}
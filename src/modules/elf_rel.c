@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/elf_rel.h"
+
+static uint16_t rd16le(const uint8_t *p){ return (uint16_t)(p[0] | (p[1]<<8)); }
+static uint32_t rd32le(const uint8_t *p){ return (uint32_t)(p[0] | (p[1]<<8) | (p[2]<<16) | ((uint32_t)p[3]<<24)); }
+static uint64_t rd64le(const uint8_t *p){
+  return (uint64_t)rd32le(p) | ((uint64_t)rd32le(p+4) << 32);
+}
+
+static void wr32le(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+enum { SHT_RELA = 4 };
+enum { STT_SECTION = 3 };
+enum { R_X86_64_PC32 = 2, R_X86_64_PLT32 = 4 };
+
+const char* elf_rel_type_name(uint32_t type) {
+  static const char *const names[] = {
+    [0] = "NONE", [1] = "64", [2] = "PC32", [3] = "GOT32", [4] = "PLT32",
+    [9] = "GOTPCREL", [10] = "32", [11] = "32S", [19] = "TLSGD", [20] = "TLSLD",
+    [21] = "DTPOFF32", [22] = "GOTTPOFF", [23] = "TPOFF32", [24] = "PC64",
+    [41] = "GOTPCRELX", [42] = "REX_GOTPCRELX",
+  };
+  static char buf[32];
+  if (type < sizeof(names)/sizeof(names[0]) && names[type]) {
+    snprintf(buf, sizeof(buf), "R_X86_64_%s", names[type]);
+  } else {
+    snprintf(buf, sizeof(buf), "R_X86_64_%u", (unsigned)type);
+  }
+  return buf;
+}
+
+static int cmp_rel(const void *a, const void *b) {
+  const ElfReloc *x = (const ElfReloc*)a, *y = (const ElfReloc*)b;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+size_t elf_rel_collect(uint8_t *d, size_t n, const ElfExecSeg *segs, size_t nseg,
+                       ElfReloc **out) {
+  *out = NULL;
+  ElfInfo inf;
+  if (!elf64_parse_info(d, n, &inf) || inf.e_type != ET_REL) return 0;
+
+  // laid-out section per section index
+  const ElfExecSeg **by_idx = (const ElfExecSeg**)calloc(inf.shnum, sizeof(*by_idx));
+  if (!by_idx) return 0;
+  for (size_t i = 0; i < nseg; i++) {
+    if (segs[i].shndx < inf.shnum) by_idx[segs[i].shndx] = &segs[i];
+  }
+
+  const uint8_t *sh_base = d + inf.shoff;
+  ElfReloc *v = NULL;
+  size_t count = 0, cap = 0;
+
+  // ELF64_Shdr: sh_type @4, sh_offset @24, sh_size @32, sh_link @40,
+  // sh_info @44, sh_entsize @56
+  for (uint16_t i = 1; i < inf.shnum; i++) {
+    const uint8_t *sh = sh_base + (size_t)i * inf.shentsz;
+    if (rd32le(sh + 4) != SHT_RELA) continue;
+    uint64_t off  = rd64le(sh + 24);
+    uint64_t size = rd64le(sh + 32);
+    uint32_t link = rd32le(sh + 40);
+    uint32_t info = rd32le(sh + 44);
+    uint64_t ent  = rd64le(sh + 56);
+    const ElfExecSeg *tgt = info < inf.shnum ? by_idx[info] : NULL;
+    if (!tgt || ent < 24 || off + size > n || link == 0 || link >= inf.shnum) continue;
+
+    // symbol table and its strings
+    const uint8_t *symsh = sh_base + (size_t)link * inf.shentsz;
+    uint64_t sym_off  = rd64le(symsh + 24);
+    uint64_t sym_size = rd64le(symsh + 32);
+    uint32_t str_idx  = rd32le(symsh + 40);
+    uint64_t sym_ent  = rd64le(symsh + 56);
+    if (sym_ent < 24 || sym_off + sym_size > n || str_idx >= inf.shnum) continue;
+    const uint8_t *strsh = sh_base + (size_t)str_idx * inf.shentsz;
+    uint64_t str_off  = rd64le(strsh + 24);
+    uint64_t str_size = rd64le(strsh + 32);
+    if (str_off + str_size > n) continue;
+
+    for (uint64_t k = 0; k + ent <= size; k += ent) {
+      const uint8_t *r = d + off + k;
+      uint64_t r_offset = rd64le(r + 0);
+      uint64_t r_info   = rd64le(r + 8);
+      int64_t  r_addend = (int64_t)rd64le(r + 16);
+      uint32_t symi = (uint32_t)(r_info >> 32);
+      uint32_t type = (uint32_t)r_info;
+      if (r_offset >= tgt->filesz) continue;
+
+      if (count == cap) {
+        size_t nc = cap ? cap * 2 : 256;
+        ElfReloc *nv = (ElfReloc*)realloc(v, nc * sizeof(ElfReloc));
+        if (!nv) { free(v); free(by_idx); return 0; }
+        v = nv;
+        cap = nc;
+      }
+      ElfReloc *e = &v[count++];
+      e->addr = tgt->vaddr + r_offset;
+      e->type = type;
+      e->addend = r_addend;
+      e->sym = "";
+      e->applied = 0;
+      if (symi == 0 || (uint64_t)(symi + 1) * sym_ent > sym_size) continue;
+
+      const uint8_t *s = d + sym_off + (uint64_t)symi * sym_ent;
+      uint32_t st_name  = rd32le(s + 0);
+      uint8_t  st_info  = s[4];
+      uint16_t st_shndx = rd16le(s + 6);
+      uint64_t st_value = rd64le(s + 8);
+
+      if ((st_info & 15) == STT_SECTION) {
+        const char *nm = elf64_section_name(d, n, st_shndx);
+        if (nm) e->sym = nm;
+      } else if (st_name < str_size &&
+                 memchr(d + str_off + st_name, 0, (size_t)(str_size - st_name))) {
+        e->sym = (const char*)d + str_off + st_name;
+      }
+
+      // S + A - P into the 32-bit field when S is laid out code
+      const ElfExecSeg *def = st_shndx && st_shndx < inf.shnum ? by_idx[st_shndx] : NULL;
+      if (def && (type == R_X86_64_PC32 || type == R_X86_64_PLT32) &&
+          r_offset + 4 <= tgt->filesz) {
+        int64_t val = (int64_t)(def->vaddr + st_value) + r_addend - (int64_t)e->addr;
+        if (val >= INT32_MIN && val <= INT32_MAX) {
+          wr32le(d + tgt->offset + r_offset, (uint32_t)(int32_t)val);
+          e->applied = 1;
+        }
+      }
+    }
+  }
+
+  free(by_idx);
+  if (count) qsort(v, count, sizeof(ElfReloc), cmp_rel);
+  *out = v;
+  return count;
+}
+
+size_t elf_rel_lower_bound(const ElfReloc *rel, size_t n, uint64_t a) {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (rel[mid].addr < a) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/elf_sym.h"
+
+static uint16_t rd16le(const uint8_t *p){ return (uint16_t)(p[0] | (p[1]<<8)); }
+static uint32_t rd32le(const uint8_t *p){ return (uint32_t)(p[0] | (p[1]<<8) | (p[2]<<16) | ((uint32_t)p[3]<<24)); }
+static uint64_t rd64le(const uint8_t *p){
+  return (uint64_t)rd32le(p) | ((uint64_t)rd32le(p+4) << 32);
+}
+
+enum { SHT_SYMTAB = 2, SHT_DYNSYM = 11 };
+enum { STT_OBJECT = 1, STT_FUNC = 2, STT_GNU_IFUNC = 10 };
+
+static int cmp_sym(const void *a, const void *b) {
+  const ElfSym *x = (const ElfSym*)a, *y = (const ElfSym*)b;
+  if (x->addr != y->addr) return x->addr < y->addr ? -1 : 1;
+  // prefer the sized symbol, then the shorter name (usually the non-alias)
+  if ((x->size == 0) != (y->size == 0)) return x->size == 0 ? 1 : -1;
+  size_t lx = strlen(x->name), ly = strlen(y->name);
+  return (lx > ly) - (lx < ly);
+}
+
+// Reads the symbols of one SHT_SYMTAB/SHT_DYNSYM section into out (may be NULL to count).
+// rel_base (ET_REL): laid-out address per section index, UINT64_MAX if not code.
+// objects: sized STT_OBJECT symbols instead of functions.
+static size_t read_symtab(const uint8_t *d, size_t n, const uint8_t *sh_base,
+                          uint16_t shentsize, uint16_t shnum, const uint8_t *sh,
+                          const uint64_t *rel_base, int objects, ElfSym *out) {
+  uint64_t off  = rd64le(sh + 24);
+  uint64_t size = rd64le(sh + 32);
+  uint32_t link = rd32le(sh + 40);
+  uint64_t ent  = rd64le(sh + 56);
+  if (ent < 24 || off + size > n || link >= shnum) return 0;
+
+  const uint8_t *str_sh = sh_base + (uint64_t)shentsize * link;
+  uint64_t str_off  = rd64le(str_sh + 24);
+  uint64_t str_size = rd64le(str_sh + 32);
+  if (str_off + str_size > n || str_size == 0) return 0;
+  const char *strtab = (const char*)(d + str_off);
+
+  size_t count = 0;
+  for (uint64_t k = 0; k + ent <= size; k += ent) {
+    const uint8_t *s = d + off + k;
+    uint32_t st_name  = rd32le(s + 0);
+    uint8_t  st_info  = s[4];
+    uint16_t st_shndx = rd16le(s + 6);
+    uint64_t st_value = rd64le(s + 8);
+    uint64_t st_size  = rd64le(s + 16);
+
+    uint8_t type = (uint8_t)(st_info & 15);
+    if (objects ? (type != STT_OBJECT || st_size == 0)
+                : (type != STT_FUNC && type != STT_GNU_IFUNC)) continue;
+    if (rel_base) {
+      if (st_shndx >= shnum || rel_base[st_shndx] == UINT64_MAX) continue;
+      st_value += rel_base[st_shndx];
+    } else if (st_shndx == 0 || st_value == 0) {
+      continue;
+    }
+    if (st_name >= str_size) continue;
+    // names must be terminated inside the string table
+    if (!memchr(strtab + st_name, 0, (size_t)(str_size - st_name))) continue;
+
+    if (out) {
+      out[count].addr = st_value;
+      out[count].size = st_size;
+      out[count].name = strtab + st_name;
+    }
+    count++;
+  }
+  return count;
+}
+
+static size_t collect_symbols(const uint8_t *d, size_t n, int objects, Arena *a, ElfSym **out) {
+  *out = NULL;
+  if (!d || n < 64) return 0;
+
+  uint64_t e_shoff     = rd64le(d + 40);
+  uint16_t e_shentsize = rd16le(d + 58);
+  uint16_t e_shnum     = rd16le(d + 60);
+  if (e_shoff == 0 || e_shentsize < 64 || e_shnum == 0) return 0;
+  if (e_shoff + (uint64_t)e_shentsize * (uint64_t)e_shnum > n) return 0;
+
+  const uint8_t *sh_base = d + e_shoff;
+  const uint8_t *pick = NULL;
+  for (uint16_t i = 0; i < e_shnum; i++) {
+    const uint8_t *sh = sh_base + (uint64_t)e_shentsize * i;
+    uint32_t type = rd32le(sh + 4);
+    if (type == SHT_SYMTAB) { pick = sh; break; }
+    if (type == SHT_DYNSYM && !pick) pick = sh;
+  }
+  if (!pick) return 0;
+
+  // relocatable objects: values are section offsets
+  Arena *sa = arena_thread();
+  ArenaMark m = arena_mark(sa);
+  uint64_t *rel_base = NULL;
+  if (rd16le(d + 16) == ET_REL) {
+    ElfExecSeg *secs = (ElfExecSeg*)arena_alloc(sa, e_shnum * sizeof(ElfExecSeg));
+    rel_base = (uint64_t*)arena_alloc(sa, e_shnum * sizeof(uint64_t));
+    if (!secs || !rel_base) { arena_reset(sa, m); return 0; }
+    for (uint16_t i = 0; i < e_shnum; i++) rel_base[i] = UINT64_MAX;
+    size_t ns = elf64_collect_exec_sections(d, n, secs, e_shnum);
+    for (size_t i = 0; i < ns; i++) rel_base[secs[i].shndx] = secs[i].vaddr;
+  }
+
+  size_t total = read_symtab(d, n, sh_base, e_shentsize, e_shnum, pick, rel_base, objects, NULL);
+  ElfSym *syms = total ? (ElfSym*)arena_alloc(a, total * sizeof(ElfSym)) : NULL;
+  if (!syms) { arena_reset(sa, m); return 0; }
+  read_symtab(d, n, sh_base, e_shentsize, e_shnum, pick, rel_base, objects, syms);
+  arena_reset(sa, m);
+  qsort(syms, total, sizeof(ElfSym), cmp_sym);
+
+  // one symbol per address; sizes clipped to (or extended up to) the next start
+  size_t count = 0;
+  for (size_t i = 0; i < total; i++) {
+    if (count && syms[count - 1].addr == syms[i].addr) continue;
+    syms[count++] = syms[i];
+  }
+  for (size_t i = 0; !objects && i < count; i++) {
+    if (i + 1 < count) {
+      uint64_t gap = syms[i + 1].addr - syms[i].addr;
+      if (syms[i].size == 0 || syms[i].size > gap) syms[i].size = gap;
+    } else if (syms[i].size == 0) {
+      syms[i].size = 1;
+    }
+  }
+
+  *out = syms;
+  return count;
+}
+
+size_t elf64_collect_func_symbols(const uint8_t *d, size_t n, Arena *a, ElfSym **out) {
+  return collect_symbols(d, n, 0, a, out);
+}
+
+size_t elf64_collect_object_symbols(const uint8_t *d, size_t n, Arena *a, ElfSym **out) {
+  return collect_symbols(d, n, 1, a, out);
+}
+
+const ElfSym* elf_sym_lookup(const ElfSym *syms, size_t count, uint64_t addr) {
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (syms[mid].addr <= addr) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == 0) return NULL;
+  const ElfSym *s = &syms[lo - 1];
+  return (addr - s->addr < s->size) ? s : NULL;
+}
+
+size_t elf_split_regions(const ElfExecSeg *seg, const ElfSym *syms, size_t count,
+                         Arena *a, Region **out) {
+  const uint64_t a0 = seg->vaddr, a1 = seg->vaddr + seg->filesz;
+
+  // at most one gap before each symbol plus a trailing one
+  size_t cap = 2 * count + 1;
+  Region *r = (Region*)arena_alloc(a, cap * sizeof(Region));
+  *out = r;
+  if (!r) return 0;
+
+  size_t nr = 0;
+  uint64_t at = a0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t s0 = syms[i].addr, s1 = syms[i].addr + syms[i].size;
+    if (s1 <= at || s0 >= a1) continue;
+    if (s0 < at) s0 = at;
+    if (s1 > a1) s1 = a1;
+
+    if (s0 > at) {
+      r[nr].name = NULL; r[nr].addr = at; r[nr].size = s0 - at;
+      r[nr].offset = seg->offset + (at - a0);
+      nr++;
+    }
+    r[nr].name = syms[i].name; r[nr].addr = s0; r[nr].size = s1 - s0;
+    r[nr].offset = seg->offset + (s0 - a0);
+    nr++;
+    at = s1;
+  }
+  if (at < a1) {
+    r[nr].name = NULL; r[nr].addr = at; r[nr].size = a1 - at;
+    r[nr].offset = seg->offset + (at - a0);
+    nr++;
+  }
+  return nr;
+}
+
+const char* region_name(const char *name, uint64_t addr, char *buf, size_t cap) {
+  if (name) return name;
+  snprintf(buf, cap, "<region_%llx>", (unsigned long long)addr);
+  return buf;
+}
@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include "opdump/flow.h"
+#include "opdump/decode.h"
+
+int insn_vec_decode(InsnVec *vec, const uint8_t *p, uint64_t size, uint64_t addr) {
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  vec->n = 0;
+  uint64_t off = 0;
+  while (off < size) {
+    if (vec->cap - vec->n < 256) {
+      size_t nc = vec->cap ? vec->cap * 2 : 1024;
+      Insn *nv = (Insn*)realloc(vec->v, nc * sizeof(Insn));
+      if (!nv) return 0;
+      vec->v = nv;
+      vec->cap = nc;
+    }
+    size_t used = 0;
+    vec->n += decode_batch(&ctx, p + off, (size_t)(size - off), addr + off,
+                           vec->v + vec->n, vec->cap - vec->n, &used);
+    off += used;
+  }
+  return 1;
+}
+
+void insn_vec_free(InsnVec *vec) {
+  free(vec->v);
+  vec->v = NULL;
+  vec->n = vec->cap = 0;
+}
+
+size_t insn_vec_find(const InsnVec *vec, uint64_t addr) {
+  size_t lo = 0, hi = vec->n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (vec->v[mid].addr < addr) lo = mid + 1;
+    else hi = mid;
+  }
+  return (lo < vec->n && vec->v[lo].addr == addr) ? lo : (size_t)-1;
+}
+
+int flow_ends_block(const Insn *in) {
+  switch (in->op) {
+    case OP_JCC_REL: case OP_JMP_REL: case OP_JMP_RM:
+    case OP_RET: case OP_CALL_REL: case OP_CALL_RM:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int cmp_loop(const void *a, const void *b) {
+  const Loop *x = (const Loop*)a, *y = (const Loop*)b;
+  if (x->head != y->head) return (x->head > y->head) - (x->head < y->head);
+  return (x->tail < y->tail) - (x->tail > y->tail); // farthest tail first
+}
+
+size_t flow_find_loops(const InsnVec *vec, Loop **out, size_t *cap) {
+  size_t n = 0;
+  for (size_t i = 0; i < vec->n; i++) {
+    const Insn *in = &vec->v[i];
+    if (in->op != OP_JCC_REL && in->op != OP_JMP_REL) continue;
+    if (in->op_count != 1 || in->ops[0].kind != O_IMM) continue;
+
+    uint64_t tgt = (uint64_t)in->ops[0].imm;
+    if (tgt > in->addr) continue;
+    size_t h = insn_vec_find(vec, tgt);
+    if (h == (size_t)-1) continue;
+
+    if (n == *cap) {
+      size_t nc = *cap ? *cap * 2 : 64;
+      Loop *nl = (Loop*)realloc(*out, nc * sizeof(Loop));
+      if (!nl) break;
+      *out = nl;
+      *cap = nc;
+    }
+    (*out)[n].head = h;
+    (*out)[n].tail = i;
+    n++;
+  }
+
+  if (n) qsort(*out, n, sizeof(Loop), cmp_loop);
+  size_t u = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (u && (*out)[u - 1].head == (*out)[i].head) continue;
+    (*out)[u++] = (*out)[i];
+  }
+  return u;
+}
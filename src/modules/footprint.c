@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/footprint.h"
+#include "opdump/decode.h"
+#include "opdump/arena.h"
+
+enum { FOOT_BATCH = 4096 };
+
+typedef struct {
+  const char *name;   // NULL: unnamed region
+  uint64_t addr;
+  uint64_t bytes;
+  uint64_t insns;
+  uint64_t pad;
+  uint64_t lines;
+  uint64_t pages;
+  uint64_t db;        // bytes left undecoded
+} FootRow;
+
+static const char *const k_keys[] = {
+  "addr", "name", "bytes", "insns", "pad", "lines", "pages", "db"
+};
+
+int footprint_sort_key(const char *name) {
+  for (size_t i = 0; i < sizeof(k_keys)/sizeof(k_keys[0]); i++) {
+    if (strcmp(name, k_keys[i]) == 0) return (int)i;
+  }
+  return -1;
+}
+
+static uint64_t spans(uint64_t addr, uint64_t size, unsigned shift) {
+  if (size == 0) return 0;
+  return ((addr + size - 1) >> shift) - (addr >> shift) + 1;
+}
+
+// Decodes one region; returns 1 when every byte is nop / int3 / zero fill.
+static int scan_region(const uint8_t *p, const Region *r, Insn *batch, FootRow *row) {
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  int fill = 1;
+  uint64_t off = 0;
+  while (off < r->size) {
+    size_t used = 0;
+    size_t got = decode_batch(&ctx, p + off, (size_t)(r->size - off), r->addr + off,
+                              batch, FOOT_BATCH, &used);
+    off += used;
+    for (size_t k = 0; k < got; k++) {
+      const Insn *in = &batch[k];
+      row->insns++;
+      if (in->op == OP_INVALID) row->db += in->size;
+      if (insn_is_fill(in)) row->pad += in->size;
+      else fill = 0;
+    }
+  }
+  return fill;
+}
+
+static _Thread_local FootSort g_sort_key; // qsort has no context argument
+
+static uint64_t row_key(const FootRow *r) {
+  switch (g_sort_key) {
+    case FP_SORT_BYTES: return r->bytes;
+    case FP_SORT_INSNS: return r->insns;
+    case FP_SORT_PAD:   return r->pad;
+    case FP_SORT_LINES: return r->lines;
+    case FP_SORT_PAGES: return r->pages;
+    case FP_SORT_DB:    return r->db;
+    default:            return r->addr;
+  }
+}
+
+static int cmp_row(const void *a, const void *b) {
+  const FootRow *x = (const FootRow*)a, *y = (const FootRow*)b;
+  if (g_sort_key == FP_SORT_NAME) {
+    int c = strcmp(x->name ? x->name : "", y->name ? y->name : "");
+    if (c) return c;
+  } else if (g_sort_key != FP_SORT_ADDR) {
+    uint64_t kx = row_key(x), ky = row_key(y);
+    if (kx != ky) return (kx < ky) - (kx > ky);
+  }
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static void print_row(FILE *out, const FootRow *r, int csv, const char *label) {
+  char gap[40];
+  const char *name = region_name(r->name, r->addr, gap, sizeof(gap));
+  double dbf = r->bytes ? (double)r->db / (double)r->bytes : 0.0;
+
+  if (csv) {
+    if (label) fprintf(out, "%s,", label);
+    fprintf(out, "%s,0x%llx,%llu,%llu,%llu,%llu,%llu,%.4f\n", name,
+      (unsigned long long)r->addr, (unsigned long long)r->bytes,
+      (unsigned long long)r->insns, (unsigned long long)r->pad,
+      (unsigned long long)r->lines, (unsigned long long)r->pages, dbf);
+    return;
+  }
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%016llx %9llu %8llu %6llu %7llu %5llu %6.2f%%  %s\n",
+    (unsigned long long)r->addr, (unsigned long long)r->bytes,
+    (unsigned long long)r->insns, (unsigned long long)r->pad,
+    (unsigned long long)r->lines, (unsigned long long)r->pages, 100.0 * dbf, name);
+}
+
+void footprint_report(FILE *out, const Image *img, FootSort key, int csv, const char *label) {
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, FOOT_BATCH * sizeof(Insn));
+  if (!batch) return;
+
+  FootRow *rows = NULL;
+  size_t nrows = 0, cap = 0;
+  FootRow total = {0};
+  total.name = "<total>";
+  uint64_t last_line = UINT64_MAX, last_page = UINT64_MAX;
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+
+    for (size_t i = 0; i < nr; i++) {
+      const Region *r = &regs[i];
+      FootRow row = {0};
+      row.name = r->name;
+      row.addr = r->addr;
+      row.bytes = r->size;
+      int fill = scan_region(img->buf + r->offset, r, batch, &row);
+
+      // lines / pages over the whole image, shared ones counted once
+      if (r->size) {
+        uint64_t l0 = r->addr >> 6, l1 = (r->addr + r->size - 1) >> 6;
+        uint64_t p0 = r->addr >> 12, p1 = (r->addr + r->size - 1) >> 12;
+        total.lines += l1 - l0 + 1 - (l0 == last_line);
+        total.pages += p1 - p0 + 1 - (p0 == last_page);
+        last_line = l1;
+        last_page = p1;
+      }
+      total.bytes += row.bytes;
+      total.insns += row.insns;
+      total.pad += row.pad;
+      total.db += row.db;
+
+      // alignment fill after a function belongs to it
+      if (!r->name && fill && nrows && rows[nrows - 1].name &&
+          rows[nrows - 1].addr + rows[nrows - 1].bytes == r->addr) {
+        rows[nrows - 1].pad += r->size;
+        continue;
+      }
+
+      row.lines = spans(r->addr, r->size, 6);
+      row.pages = spans(r->addr, r->size, 12);
+      if (nrows == cap) {
+        size_t nc = cap ? cap * 2 : 256;
+        FootRow *nrw = (FootRow*)realloc(rows, nc * sizeof(FootRow));
+        if (!nrw) break;
+        rows = nrw;
+        cap = nc;
+      }
+      rows[nrows++] = row;
+    }
+    arena_reset(sa, mark);
+  }
+  arena_reset(sa, batch_mark);
+
+  g_sort_key = key;
+  if (key != FP_SORT_ADDR) qsort(rows, nrows, sizeof(FootRow), cmp_row);
+
+  if (csv) {
+    fprintf(out, "%sfunction,address,bytes,insns,pad,lines,pages,db\n", label ? "file," : "");
+  } else {
+    fprintf(out, "# address              bytes    insns    pad   lines pages     db  function\n");
+  }
+  for (size_t i = 0; i < nrows; i++) print_row(out, &rows[i], csv, label);
+  print_row(out, &total, csv, label);
+
+  free(rows);
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include "opdump/format.h"
 
 static const char* reg64(uint8_t r) {
@@ -40,14 +41,38 @@ static const char* reg8(uint8_t r) {
 }
 
 static const char* regxmm(uint8_t r) {
-  static const char *names[16] = {
+  static const char *names[32] = {
     "xmm0","xmm1","xmm2","xmm3","xmm4","xmm5","xmm6","xmm7",
-    "xmm8","xmm9","xmm10","xmm11","xmm12","xmm13","xmm14","xmm15"
+    "xmm8","xmm9","xmm10","xmm11","xmm12","xmm13","xmm14","xmm15",
+    "xmm16","xmm17","xmm18","xmm19","xmm20","xmm21","xmm22","xmm23",
+    "xmm24","xmm25","xmm26","xmm27","xmm28","xmm29","xmm30","xmm31"
   };
-  if (r < 16) return names[r];
+  if (r < 32) return names[r];
   return "xmm?";
 }
 
+static const char* regymm(uint8_t r) {
+  static const char *names[32] = {
+    "ymm0","ymm1","ymm2","ymm3","ymm4","ymm5","ymm6","ymm7",
+    "ymm8","ymm9","ymm10","ymm11","ymm12","ymm13","ymm14","ymm15",
+    "ymm16","ymm17","ymm18","ymm19","ymm20","ymm21","ymm22","ymm23",
+    "ymm24","ymm25","ymm26","ymm27","ymm28","ymm29","ymm30","ymm31"
+  };
+  if (r < 32) return names[r];
+  return "ymm?";
+}
+
+static const char* regzmm(uint8_t r) {
+  static const char *names[32] = {
+    "zmm0","zmm1","zmm2","zmm3","zmm4","zmm5","zmm6","zmm7",
+    "zmm8","zmm9","zmm10","zmm11","zmm12","zmm13","zmm14","zmm15",
+    "zmm16","zmm17","zmm18","zmm19","zmm20","zmm21","zmm22","zmm23",
+    "zmm24","zmm25","zmm26","zmm27","zmm28","zmm29","zmm30","zmm31"
+  };
+  if (r < 32) return names[r];
+  return "zmm?";
+}
+
 const char* reg_name64(uint8_t r) { return reg64(r); }
 
 const char* cc_name(Cond cc) {
@@ -58,7 +83,7 @@ const char* cc_name(Cond cc) {
   return "?";
 }
 
-static const char* op_name(Op op) {
+const char* op_name(Op op) {
   switch (op) {
     case OP_RET:      return "ret";
     case OP_CALL_REL: return "call";
@@ -92,6 +117,87 @@ static const char* op_name(Op op) {
 
     case OP_CMOVCC: return "cmovcc";
 
+    case OP_DIV:     return "div";
+    case OP_IDIV:    return "idiv";
+    case OP_IMUL:    return "imul";
+    case OP_XADD:    return "xadd";
+    case OP_CMPXCHG: return "cmpxchg";
+
+    case OP_MOVUPS: return "movups";   case OP_MOVUPD: return "movupd";
+    case OP_MOVSS:  return "movss";    case OP_MOVSD:  return "movsd";
+    case OP_MOVAPS: return "movaps";   case OP_MOVAPD: return "movapd";
+    case OP_MOVD:   return "movd";     case OP_MOVQ:   return "movq";
+    case OP_MOVDQA: return "movdqa";   case OP_MOVDQU: return "movdqu";
+    case OP_UCOMISS: return "ucomiss"; case OP_UCOMISD: return "ucomisd";
+    case OP_COMISS:  return "comiss";  case OP_COMISD:  return "comisd";
+    case OP_SQRTPS: return "sqrtps";   case OP_SQRTPD: return "sqrtpd";
+    case OP_SQRTSS: return "sqrtss";   case OP_SQRTSD: return "sqrtsd";
+    case OP_ANDPS:  return "andps";    case OP_ANDPD:  return "andpd";
+    case OP_ANDNPS: return "andnps";   case OP_ANDNPD: return "andnpd";
+    case OP_ORPS:   return "orps";     case OP_ORPD:   return "orpd";
+    case OP_XORPS:  return "xorps";    case OP_XORPD:  return "xorpd";
+    case OP_ADDPS:  return "addps";    case OP_ADDPD:  return "addpd";
+    case OP_ADDSS:  return "addss";    case OP_ADDSD:  return "addsd";
+    case OP_MULPS:  return "mulps";    case OP_MULPD:  return "mulpd";
+    case OP_MULSS:  return "mulss";    case OP_MULSD:  return "mulsd";
+    case OP_SUBPS:  return "subps";    case OP_SUBPD:  return "subpd";
+    case OP_SUBSS:  return "subss";    case OP_SUBSD:  return "subsd";
+    case OP_MINPS:  return "minps";    case OP_MINPD:  return "minpd";
+    case OP_MINSS:  return "minss";    case OP_MINSD:  return "minsd";
+    case OP_DIVPS:  return "divps";    case OP_DIVPD:  return "divpd";
+    case OP_DIVSS:  return "divss";    case OP_DIVSD:  return "divsd";
+    case OP_MAXPS:  return "maxps";    case OP_MAXPD:  return "maxpd";
+    case OP_MAXSS:  return "maxss";    case OP_MAXSD:  return "maxsd";
+    case OP_CMPPS:  return "cmpps";    case OP_CMPPD:  return "cmppd";
+    case OP_CMPSS:  return "cmpss";    case OP_CMPSD:  return "cmpsd";
+    case OP_UNPCKLPS: return "unpcklps"; case OP_UNPCKLPD: return "unpcklpd";
+    case OP_UNPCKHPS: return "unpckhps"; case OP_UNPCKHPD: return "unpckhpd";
+    case OP_SHUFPS:   return "shufps";   case OP_SHUFPD:   return "shufpd";
+    case OP_PSHUFD:   return "pshufd";   case OP_PSHUFB:   return "pshufb";
+    case OP_PALIGNR:  return "palignr";
+    case OP_PSHUFHW:  return "pshufhw";  case OP_PSHUFLW:  return "pshuflw";
+    case OP_PINSRW:   return "pinsrw";   case OP_PEXTRW:   return "pextrw";
+    case OP_PCMPEQB:  return "pcmpeqb";  case OP_PCMPEQW:  return "pcmpeqw";
+    case OP_PCMPEQD:  return "pcmpeqd";  case OP_PMOVMSKB: return "pmovmskb";
+    case OP_PAND:     return "pand";     case OP_PANDN:    return "pandn";
+    case OP_POR:      return "por";
+    case OP_PADDB: return "paddb"; case OP_PADDW: return "paddw";
+    case OP_PADDD: return "paddd"; case OP_PADDQ: return "paddq";
+    case OP_PSUBB: return "psubb"; case OP_PSUBW: return "psubw";
+    case OP_PSUBD: return "psubd"; case OP_PSUBQ: return "psubq";
+    case OP_PMULLD: return "pmulld"; case OP_PMULUDQ: return "pmuludq";
+    case OP_PSRLW: return "psrlw"; case OP_PSRLD: return "psrld";
+    case OP_PSRLQ: return "psrlq"; case OP_PSRLDQ: return "psrldq";
+    case OP_PSRAW: return "psraw"; case OP_PSRAD: return "psrad";
+    case OP_PSLLW: return "psllw"; case OP_PSLLD: return "pslld";
+    case OP_PSLLQ: return "psllq"; case OP_PSLLDQ: return "pslldq";
+
+    case OP_VZEROUPPER:    return "vzeroupper";
+    case OP_VZEROALL:      return "vzeroall";
+    case OP_VBROADCASTSS:  return "vbroadcastss";
+    case OP_VBROADCASTSD:  return "vbroadcastsd";
+    case OP_VPBROADCASTB:  return "vpbroadcastb";
+    case OP_VPBROADCASTW:  return "vpbroadcastw";
+    case OP_VPBROADCASTD:  return "vpbroadcastd";
+    case OP_VPBROADCASTQ:  return "vpbroadcastq";
+    case OP_VPERMD:        return "vpermd";
+    case OP_VPERM2F128:    return "vperm2f128";
+    case OP_VPERM2I128:    return "vperm2i128";
+    case OP_VINSERTF128:   return "vinsertf128";
+    case OP_VEXTRACTF128:  return "vextractf128";
+    case OP_VINSERTI128:   return "vinserti128";
+    case OP_VEXTRACTI128:  return "vextracti128";
+    case OP_VFMADD132PS: return "vfmadd132ps"; case OP_VFMADD132PD: return "vfmadd132pd";
+    case OP_VFMADD132SS: return "vfmadd132ss"; case OP_VFMADD132SD: return "vfmadd132sd";
+    case OP_VFMADD213PS: return "vfmadd213ps"; case OP_VFMADD213PD: return "vfmadd213pd";
+    case OP_VFMADD213SS: return "vfmadd213ss"; case OP_VFMADD213SD: return "vfmadd213sd";
+    case OP_VFMADD231PS: return "vfmadd231ps"; case OP_VFMADD231PD: return "vfmadd231pd";
+    case OP_VFMADD231SS: return "vfmadd231ss"; case OP_VFMADD231SD: return "vfmadd231sd";
+    case OP_VPTERNLOGD: return "vpternlogd";
+    case OP_VPTERNLOGQ: return "vpternlogq";
+    case OP_KMOV:    return "kmov";
+    case OP_KORTEST: return "kortest";
+
 
     default: return "db";
   }
@@ -131,12 +237,14 @@ static void print_mem(FILE *out, const Operand *o) {
   fprintf(out, "]");
 }
 
-static void print_reg(FILE *out, uint8_t reg, uint8_t width) {
+static void print_reg(FILE *out, uint8_t reg, uint16_t width) {
   switch (width) {
     case 8:   fprintf(out, "%s", reg8(reg));  break;
     case 16:  fprintf(out, "%s", reg16(reg)); break;
     case 32:  fprintf(out, "%s", reg32(reg)); break;
     case 128: fprintf(out, "%s", regxmm(reg)); break;
+    case 256: fprintf(out, "%s", regymm(reg)); break;
+    case 512: fprintf(out, "%s", regzmm(reg)); break;
     default:  fprintf(out, "%s", reg64(reg)); break; // 64
   }
 }
@@ -152,11 +260,57 @@ static void print_operand(FILE *out, const Operand *o) {
     case O_MEM:
       print_mem(out, o);
       break;
+    case O_KREG:
+      fprintf(out, "k%u", (unsigned)o->reg);
+      break;
     default:
       fprintf(out, "?");
   }
 }
 
+static char size_suffix(uint8_t bytes) {
+  switch (bytes) {
+    case 1: return 'b';
+    case 2: return 'w';
+    case 4: return 'd';
+    default: return 'q';
+  }
+}
+
+// SSE mnemonics gain a 'v' under VEX/EVEX; a few EVEX forms carry the
+// element size in the name (vmovdqu64, vpxord, vinserti32x4).
+static void print_vec_mnemonic(FILE *out, const Insn *in) {
+  const char *name = op_name(in->op);
+  const unsigned ebits = (unsigned)in->vesize * 8u;
+
+  if (in->op == OP_KMOV || in->op == OP_KORTEST) {
+    fprintf(out, "%s%c", name, size_suffix(in->vesize));
+    return;
+  }
+
+  const char *v = (in->enc != ENC_LEGACY && name[0] != 'v') ? "v" : "";
+  if (in->enc == ENC_EVEX) {
+    switch (in->op) {
+      case OP_MOVDQA: case OP_MOVDQU:
+        fprintf(out, "v%s%u", name, ebits);
+        return;
+      case OP_PAND: case OP_PANDN: case OP_POR: case OP_PXOR:
+        fprintf(out, "v%s%c", name, size_suffix(in->vesize));
+        return;
+      case OP_VINSERTF128: case OP_VEXTRACTF128:
+      case OP_VINSERTI128: case OP_VEXTRACTI128: {
+        // vinsertf128 -> vinsertf32x4 / vinsertf64x2
+        size_t k = strlen(name) - 3;
+        fprintf(out, "%.*s%ux%u", (int)k, name, ebits, 128u / ebits);
+        return;
+      }
+      default:
+        break;
+    }
+  }
+  fprintf(out, "%s%s", v, name);
+}
+
 // void format_intel(FILE *out, const Insn *in) {
 //   if (in->op == OP_JCC_REL && in->has_cc) {
 //     fprintf(out, "j%s ", cc_name(in->cc));
@@ -173,19 +327,41 @@ static void print_operand(FILE *out, const Operand *o) {
 // }
 
 void format_intel(FILE *out, const Insn *in) {
+  if (in->prefixes & PFX_LOCK) fprintf(out, "lock ");
+
   if (in->op == OP_JCC_REL && in->has_cc) {
     fprintf(out, "j%s ", cc_name(in->cc));
   } else if (in->op == OP_SETCC && in->has_cc) {
     fprintf(out, "set%s ", cc_name(in->cc));
   } else if (in->op == OP_CMOVCC && in->has_cc) {
     fprintf(out, "cmov%s ", cc_name(in->cc));
+  } else if (in->op >= OP_MOVUPS || in->op == OP_PXOR) {
+    print_vec_mnemonic(out, in);
+    fprintf(out, " ");
   } else {
     fprintf(out, "%s ", op_name(in->op));
   }
 
   for (uint8_t i = 0; i < in->op_count; i++) {
     if (i) fprintf(out, ", ");
+    if (in->ops[i].kind == O_MEM && (in->prefixes & (PFX_FS | PFX_GS))) {
+      fprintf(out, "%s:", (in->prefixes & PFX_FS) ? "fs" : "gs");
+    }
     print_operand(out, &in->ops[i]);
+    if (in->ops[i].kind == O_MEM && in->bcast) fprintf(out, "{1to%u}", (unsigned)in->bcast);
+    if (i == 0 && in->kmask) fprintf(out, "{k%u}", (unsigned)in->kmask);
+    if (i == 0 && in->zeroing) fprintf(out, "{z}");
   }
 }
 
+
+void format_line(FILE *out, const Insn *in) {
+  fprintf(out, "%016llx  ", (unsigned long long)in->addr);
+  for (uint8_t i = 0; i < in->bytes_len; i++) {
+    fprintf(out, "%02x ", (unsigned)in->bytes[i]);
+  }
+  for (uint8_t i = in->bytes_len; i < 12; i++) fprintf(out, "   ");
+
+  format_intel(out, in);
+  fprintf(out, "\n");
+}
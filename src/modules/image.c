@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "opdump/image.h"
+
+static int read_all(const char *path, uint8_t **out_buf, size_t *out_sz) {
+  *out_buf = NULL; *out_sz = 0;
+  FILE *f = fopen(path, "rb");
+  if (!f) return 0;
+  if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return 0; }
+  long len = ftell(f);
+  if (len < 0) { fclose(f); return 0; }
+  if (fseek(f, 0, SEEK_SET) != 0) { fclose(f); return 0; }
+
+  uint8_t *buf = (uint8_t*)malloc((size_t)len);
+  if (!buf) { fclose(f); return 0; }
+
+  size_t got = fread(buf, 1, (size_t)len, f);
+  fclose(f);
+  if (got != (size_t)len) { free(buf); return 0; }
+
+  *out_buf = buf;
+  *out_sz = (size_t)len;
+  return 1;
+}
+
+enum { IMG_ARENA_CHUNK = 16 * 1024 };
+
+static void image_init(Image *img, const char *path) {
+  memset(img, 0, sizeof(*img));
+  img->path = path;
+  arena_init(&img->arena, IMG_ARENA_CHUNK);
+}
+
+static int image_parse(Image *img) {
+  if (!elf64_parse_info(img->buf, img->n, &img->info)) {
+    image_free(img);
+    return IMG_ERR_ELF;
+  }
+
+  int rel = img->info.e_type == ET_REL;
+  size_t n = rel ? elf64_collect_exec_sections(img->buf, img->n, NULL, SIZE_MAX)
+                 : elf64_collect_exec_segments(img->buf, img->n, NULL, SIZE_MAX);
+  img->segs = n ? (ElfExecSeg*)arena_alloc(&img->arena, n * sizeof(ElfExecSeg)) : NULL;
+  if (img->segs) {
+    img->seg_count = rel ? elf64_collect_exec_sections(img->buf, img->n, img->segs, n)
+                         : elf64_collect_exec_segments(img->buf, img->n, img->segs, n);
+  }
+  if (rel && img->seg_count) {
+    img->reloc_count = elf_rel_collect(img->buf, img->n, img->segs, img->seg_count, &img->relocs);
+  }
+  if (img->seg_count == 0) {
+    image_free(img);
+    return IMG_ERR_NOEXEC;
+  }
+  return IMG_OK;
+}
+
+int image_load(const char *path, Image *img) {
+  image_init(img, path);
+
+  if (!read_all(path, &img->buf, &img->n)) return IMG_ERR_READ;
+  return image_parse(img);
+}
+
+int image_map(const char *path, Image *img) {
+  image_init(img, path);
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return IMG_ERR_READ;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return IMG_ERR_READ; }
+  // writable private pages: ET_REL relocations are applied in place
+  void *p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return IMG_ERR_READ;
+
+  img->buf = (uint8_t*)p;
+  img->n = (size_t)st.st_size;
+  img->mapped = 1;
+  return image_parse(img);
+}
+
+int image_from_memory(const char *path, uint8_t *buf, size_t n, Image *img) {
+  image_init(img, path);
+  img->buf = buf;
+  img->n = n;
+  img->borrowed = 1;
+  return image_parse(img);
+}
+
+void image_load_symbols(Image *img) {
+  if (img->syms) return;
+  img->sym_count = elf64_collect_func_symbols(img->buf, img->n, &img->arena, &img->syms);
+}
+
+void image_free(Image *img) {
+  arena_free(&img->arena);
+  free(img->relocs);
+  if (img->mapped && img->buf) munmap(img->buf, img->n);
+  else if (!img->borrowed) free(img->buf);
+  img->segs = NULL;
+  img->seg_count = 0;
+  img->syms = NULL;
+  img->relocs = NULL;
+  img->buf = NULL;
+  img->sym_count = 0;
+  img->reloc_count = 0;
+}
+
+const char* image_strerror(int err) {
+  switch (err) {
+    case IMG_ERR_READ:   return "cannot read file";
+    case IMG_ERR_ELF:    return "not supported ELF64 (LE)";
+    case IMG_ERR_NOEXEC: return "no executable segments or sections";
+    default:             return "ok";
+  }
+}
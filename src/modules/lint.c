@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/lint.h"
+#include "opdump/decode.h"
+#include "opdump/format.h"
+#include "opdump/arena.h"
+
+enum { LINT_BATCH = 4096 };
+
+typedef struct {
+  uint32_t partial;   // GPRs whose last write was 8/16 bits wide
+} LintState;
+
+typedef struct {
+  const char *name;
+  const char *what;
+  int hot_only;       // with samples: skip functions without any
+  int (*match)(LintState *st, const Insn *in);
+} LintRule;
+
+static int is_gpr(const Operand *o) {
+  return o->kind == O_REG && o->width <= 64 && o->reg < 16;
+}
+
+// Register number behind a GPR operand; ah..bh (no REX) map to rax..rbx.
+static unsigned gpr_id(const Insn *in, const Operand *o) {
+  if (o->width == 8 && !in->rex && o->reg >= 4 && o->reg < 8) return o->reg - 4u;
+  return o->reg;
+}
+
+// First byte after the legacy prefixes and REX.
+static uint8_t opcode_byte(const Insn *in) {
+  uint8_t i = 0;
+  while (i < in->bytes_len) {
+    uint8_t b = in->bytes[i];
+    if (b == 0xF0 || b == 0xF2 || b == 0xF3 || b == 0x2E || b == 0x36 || b == 0x3E ||
+        b == 0x26 || b == 0x64 || b == 0x65 || b == 0x66 || b == 0x67 ||
+        (b & 0xF0) == 0x40) {
+      i++;
+      continue;
+    }
+    return b;
+  }
+  return 0;
+}
+
+static int rule_lcp(LintState *st, const Insn *in) {
+  (void)st;
+  if (!(in->prefixes & PFX_OPSIZE) || in->op == OP_INVALID) return 0;
+  // imm8 forms (83) keep their length; mov r16, imm16 (B8+r) is exempt on current cores
+  uint8_t b = opcode_byte(in);
+  if (b == 0x83 || (b >= 0xB8 && b <= 0xBF)) return 0;
+  for (uint8_t i = 0; i < in->op_count; i++) {
+    if (in->ops[i].kind == O_IMM && in->ops[i].width == 16) return 1;
+  }
+  return 0;
+}
+
+static int rule_lock(LintState *st, const Insn *in) {
+  (void)st;
+  return (in->prefixes & PFX_LOCK) != 0;
+}
+
+static int rule_div(LintState *st, const Insn *in) {
+  (void)st;
+  return in->op == OP_DIV || in->op == OP_IDIV;
+}
+
+// ops[0] is read as well as written (or only read)
+static int reads_dst(Op op) {
+  switch (op) {
+    case OP_ADD: case OP_SUB: case OP_AND: case OP_OR: case OP_XOR:
+    case OP_CMP: case OP_TEST: case OP_CMOVCC: case OP_XADD: case OP_CMPXCHG:
+    case OP_PUSH: case OP_DIV: case OP_IDIV: case OP_CALL_RM: case OP_JMP_RM:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int writes_dst(Op op) {
+  switch (op) {
+    case OP_CMP: case OP_TEST: case OP_PUSH: case OP_DIV: case OP_IDIV:
+    case OP_CALL_RM: case OP_JMP_RM: case OP_INVALID:
+      return 0;
+    default:
+      return 1;
+  }
+}
+
+static int rule_partial(LintState *st, const Insn *in) {
+  if (in->op == OP_CALL_REL || in->op == OP_CALL_RM || in->op == OP_RET ||
+      in->op == OP_JMP_REL || in->op == OP_JMP_RM) {
+    st->partial = 0;
+    return 0;
+  }
+
+  // a full-width read of a partially written register merges (stall / extra uop)
+  int hit = 0;
+  for (uint8_t i = 0; i < in->op_count; i++) {
+    const Operand *o = &in->ops[i];
+    if (o->kind == O_MEM) {
+      if (o->mem.base < 16 && (st->partial >> o->mem.base & 1)) hit = 1;
+      if (o->mem.index < 16 && (st->partial >> o->mem.index & 1)) hit = 1;
+      continue;
+    }
+    if (!is_gpr(o) || o->width < 32) continue;
+    if (i == 0 && in->op_count > 1 && !reads_dst(in->op)) continue;
+    if (st->partial >> gpr_id(in, o) & 1) hit = 1;
+  }
+  int zero_idiom = in->op == OP_XOR && in->op_count == 2 &&
+                   is_gpr(&in->ops[0]) && is_gpr(&in->ops[1]) &&
+                   in->ops[0].reg == in->ops[1].reg;
+  if (hit && zero_idiom) hit = 0;
+
+  if (in->op_count && is_gpr(&in->ops[0]) && writes_dst(in->op)) {
+    uint32_t bit = 1u << gpr_id(in, &in->ops[0]);
+    if (in->ops[0].width < 32) st->partial |= bit;
+    else                       st->partial &= ~bit;
+  }
+  return hit;
+}
+
+static int rule_leave(LintState *st, const Insn *in) {
+  (void)st;
+  return in->op == OP_LEAVE;
+}
+
+static int rule_lea3(LintState *st, const Insn *in) {
+  (void)st;
+  if (in->op != OP_LEA || in->op_count < 2 || in->ops[1].kind != O_MEM) return 0;
+  const Operand *m = &in->ops[1];
+  return m->mem.base < 16 && m->mem.index < 16 && m->mem.disp != 0;
+}
+
+static int rule_indirect(LintState *st, const Insn *in) {
+  (void)st;
+  return (in->op == OP_CALL_RM || in->op == OP_JMP_RM) && in->ops[0].kind == O_MEM;
+}
+
+static const LintRule k_rules[] = {
+  { "lcp",      "66 prefix with imm16: length-changing prefix predecode stall", 0, rule_lcp },
+  { "lock",     "lock-prefixed RMW: full barrier, ~20 cycles",                 1, rule_lock },
+  { "div",      "integer divide: 20-90 cycles, not pipelined",                 0, rule_div },
+  { "partial",  "8/16-bit write then 32/64-bit read: merge uop or stall",      0, rule_partial },
+  { "leave",    "leave: 3 uops (mov rsp, rbp; pop rbp is 2)",                  0, rule_leave },
+  { "lea3",     "3-component lea: 3-cycle latency, one port",                  0, rule_lea3 },
+  { "indirect", "call/jmp through memory: load + indirect branch",             0, rule_indirect },
+};
+
+enum { LINT_RULES = sizeof(k_rules) / sizeof(k_rules[0]) };
+
+static void print_finding(FILE *out, const LintRule *rule, const Region *r, const Insn *in,
+                          const char *label) {
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%016llx  %-8s  ", (unsigned long long)in->addr, rule->name);
+  char gap[40];
+  fprintf(out, "%s+0x%llx  ", region_name(r->name, r->addr, gap, sizeof(gap)),
+          (unsigned long long)(in->addr - r->addr));
+  format_intel(out, in);
+  fprintf(out, "\n");
+}
+
+void lint_report(FILE *out, const Image *img, const SampleIndex *smp, const char *label) {
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, LINT_BATCH * sizeof(Insn));
+  if (!batch) return;
+
+  uint64_t hits[LINT_RULES] = {0};
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# address          rule      function+offset  instruction\n");
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+
+    for (size_t i = 0; i < nr; i++) {
+      const Region *r = &regs[i];
+      const uint8_t *p = img->buf + r->offset;
+      int cold = smp && samples_range(smp, r->addr, r->addr + r->size) == 0;
+      LintState st = {0};
+
+      uint64_t off = 0;
+      while (off < r->size) {
+        size_t used = 0;
+        size_t got = decode_batch(&ctx, p + off, (size_t)(r->size - off), r->addr + off,
+                                  batch, LINT_BATCH, &used);
+        off += used;
+        for (size_t k = 0; k < got; k++) {
+          for (size_t j = 0; j < LINT_RULES; j++) {
+            const LintRule *rule = &k_rules[j];
+            if (!rule->match(&st, &batch[k])) continue;
+            if (rule->hot_only && cold) continue;
+            hits[j]++;
+            print_finding(out, rule, r, &batch[k], label);
+          }
+        }
+      }
+    }
+    arena_reset(sa, mark);
+  }
+  arena_reset(sa, batch_mark);
+
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# rule      findings  description\n");
+  for (size_t j = 0; j < LINT_RULES; j++) {
+    if (label) fprintf(out, "%s: ", label);
+    fprintf(out, "%-8s  %10llu  %s\n", k_rules[j].name, (unsigned long long)hits[j],
+            k_rules[j].what);
+  }
+}
@@ -0,0 +1,202 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include "opdump/listing_index.h"
+
+static const char k_magic[8] = { 'O', 'P', 'D', 'I', 'D', 'X', '1', '\n' };
+
+void listing_index_init(ListingIndex *ix, unsigned stride, const ElfSym *syms, size_t nsyms) {
+  memset(ix, 0, sizeof(*ix));
+  ix->stride = stride ? stride : 1;
+  ix->syms = syms;
+  ix->nsyms = nsyms;
+}
+
+void listing_index_free(ListingIndex *ix) {
+  free(ix->v);
+  memset(ix, 0, sizeof(*ix));
+}
+
+void listing_index_insn(ListingIndex *ix, FILE *out, uint64_t addr) {
+  while (ix->next < ix->nsyms && ix->syms[ix->next].addr < addr) ix->next++;
+  int func = ix->next < ix->nsyms && ix->syms[ix->next].addr == addr;
+  ix->since++;
+  if (!func && ix->n && ix->since < ix->stride) return;
+  // entries must stay sorted for the lookup's binary search
+  if (ix->n && ix->v[ix->n - 1].addr >= addr) return;
+
+  if (ix->n == ix->cap) {
+    size_t nc = ix->cap ? ix->cap * 2 : 1024;
+    IndexEntry *nv = (IndexEntry*)realloc(ix->v, nc * sizeof(IndexEntry));
+    if (!nv) return;
+    ix->v = nv;
+    ix->cap = nc;
+  }
+  ix->v[ix->n].addr = addr;
+  ix->v[ix->n].off = (uint64_t)ftello(out);
+  ix->n++;
+  ix->since = 0;
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get64(const uint8_t *p) {
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+int listing_index_write(const char *path, const ListingIndex *ix, uint64_t listing_size) {
+  FILE *f = fopen(path, "wb");
+  if (!f) return 0;
+
+  uint8_t hdr[32];
+  memcpy(hdr, k_magic, 8);
+  put64(hdr + 8, ix->stride); // u32 stride, u32 0
+  put64(hdr + 16, listing_size);
+  put64(hdr + 24, ix->n);
+  int ok = fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+
+  uint8_t rec[16 * 256];
+  for (size_t i = 0; ok && i < ix->n; ) {
+    size_t k = 0;
+    for (; k < 256 && i < ix->n; k++, i++) {
+      put64(rec + 16 * k, ix->v[i].addr);
+      put64(rec + 16 * k + 8, ix->v[i].off);
+    }
+    ok = fwrite(rec, 16, k, f) == k;
+  }
+  if (fclose(f) != 0) ok = 0;
+  return ok;
+}
+
+// Address and encoded length of an instruction line ("[ NN.NN%]  %016llx  xx xx ..");
+// 0 for other lines.
+static int line_insn(const char *s, uint64_t *addr, unsigned *len) {
+  if (s[0] == ';' || s[0] == '\n') return 0;
+  const char *p = s;
+  while (*p == ' ') p++;
+  const char *pct = strchr(p, '%');
+  if (pct && pct - p <= 7) p = pct + 1;   // sample column
+  while (*p == ' ') p++;
+
+  uint64_t v = 0;
+  int k = 0;
+  for (; k < 16; k++) {
+    char c = p[k];
+    unsigned d;
+    if (c >= '0' && c <= '9') d = (unsigned)(c - '0');
+    else if (c >= 'a' && c <= 'f') d = (unsigned)(c - 'a' + 10);
+    else break;
+    v = (v << 4) | d;
+  }
+  if (k != 16 || p[16] != ' ') return 0;
+  *addr = v;
+
+  // raw bytes: two hex digits each, single-space separated
+  unsigned nb = 0;
+  for (p += 18; isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]) &&
+                (p[2] == ' ' || p[2] == '\n'); p += 3) {
+    nb++;
+    if (p[2] != ' ' || p[3] == ' ') break;
+  }
+  if (len) *len = nb ? nb : 1;
+  return 1;
+}
+
+int listing_lookup(FILE *out, const char *listing, const char *index_path, uint64_t addr,
+                   uint64_t stop, size_t max_lines) {
+  char ipath[4096];
+  if (!index_path) {
+    snprintf(ipath, sizeof(ipath), "%s.idx", listing);
+    index_path = ipath;
+  }
+
+  FILE *fi = fopen(index_path, "rb");
+  if (!fi) {
+    fprintf(stderr, "Error: %s: cannot read index\n", index_path);
+    return 2;
+  }
+  uint8_t hdr[32];
+  if (fread(hdr, 1, sizeof(hdr), fi) != sizeof(hdr) || memcmp(hdr, k_magic, 8) != 0) {
+    fclose(fi);
+    fprintf(stderr, "Error: %s: not an opdump index\n", index_path);
+    return 2;
+  }
+  uint64_t size = get64(hdr + 16), n = get64(hdr + 24);
+
+  // binary search over the records on disk: last addr <= target
+  uint64_t lo = 0, hi = n, off = 0;
+  int found = 0;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    uint8_t rec[16];
+    if (fseeko(fi, (off_t)(32 + 16 * mid), SEEK_SET) != 0 || fread(rec, 1, 16, fi) != 16) break;
+    if (get64(rec) <= addr) {
+      off = get64(rec + 8);
+      found = 1;
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  fclose(fi);
+  if (!found) {
+    fprintf(stderr, "Error: %llx is before the first indexed address\n", (unsigned long long)addr);
+    return 1;
+  }
+
+  FILE *fl = fopen(listing, "rb");
+  if (!fl) {
+    fprintf(stderr, "Error: %s: cannot read listing\n", listing);
+    return 2;
+  }
+  if (fseeko(fl, 0, SEEK_END) == 0 && (uint64_t)ftello(fl) != size) {
+    fprintf(stderr, "Error: %s: index does not match the listing\n", index_path);
+    fclose(fl);
+    return 2;
+  }
+
+  // walk forward from the entry to the instruction holding addr
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t len;
+  uint64_t at = off, hit = UINT64_MAX, hit_end = 0;
+  if (fseeko(fl, (off_t)off, SEEK_SET) == 0) {
+    while ((len = getline(&line, &cap, fl)) > 0) {
+      uint64_t a;
+      unsigned nb;
+      if (line_insn(line, &a, &nb)) {
+        if (a > addr) break;
+        hit = at;
+        hit_end = a + nb;
+      }
+      at += (uint64_t)len;
+    }
+  }
+  if (hit == UINT64_MAX || addr >= hit_end) {
+    fprintf(stderr, "Error: %llx not found in %s\n", (unsigned long long)addr, listing);
+    free(line);
+    fclose(fl);
+    return 1;
+  }
+
+  fseeko(fl, (off_t)hit, SEEK_SET);
+  size_t printed = 0;
+  while ((len = getline(&line, &cap, fl)) > 0) {
+    uint64_t a;
+    if (stop != UINT64_MAX) {
+      if (line_insn(line, &a, NULL) && a >= stop) break;
+    } else if (printed++ == max_lines) {
+      break;
+    }
+    fwrite(line, 1, (size_t)len, out);
+  }
+  free(line);
+  fclose(fl);
+  return 0;
+}
@@ -0,0 +1,363 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/memreport.h"
+#include "opdump/flow.h"
+#include "opdump/cost.h"
+#include "opdump/arena.h"
+
+typedef enum { MA_RIP, MA_STACK, MA_GATHER, MA_CHASE, MA_STRIDE, MA_OTHER, MA_COUNT } MemClass;
+
+enum { MEM_STRIDES = 4 };
+
+// rax rcx rdx rsi rdi r8-r11
+static const uint16_t k_clobbered = 0x0FC7;
+
+typedef struct {
+  uint64_t loads, stores;
+  uint64_t cls[MA_COUNT];
+  uint16_t bases;                 // GPRs used as a base
+  int64_t strides[MEM_STRIDES];   // distinct, in order of appearance
+  size_t nstrides;
+  int more_strides;
+  int chase;                      // loop: carried pointer chasing; function: such loops
+} MemStats;
+
+// What the walk knows about each GPR.
+typedef struct {
+  uint8_t loaded[16];    // value derives from a load
+  uint16_t origin[16];   // loop-entry registers the value derives from
+  uint16_t deref[16];    // loop-entry registers behind the address of such a load
+} RegState;
+
+// Per-iteration change of each GPR in a loop body.
+typedef struct {
+  uint8_t kind[16];      // 0 untouched, 1 constant step, 2 anything else
+  int64_t step[16];
+} Induction;
+
+static int gpr(const Operand *o) {
+  return (o->kind == O_REG && o->width <= 64 && o->reg < 16) ? o->reg : -1;
+}
+
+// ops[0] is written
+static int writes_dst(Op op) {
+  switch (op) {
+    case OP_CMP: case OP_TEST: case OP_PUSH:
+    case OP_JCC_REL: case OP_JMP_REL: case OP_JMP_RM:
+    case OP_CALL_REL: case OP_CALL_RM: case OP_RET:
+    case OP_NOP: case OP_ENDBR: case OP_CLI: case OP_LEAVE:
+    case OP_DIV: case OP_IDIV:
+    case OP_UCOMISS: case OP_UCOMISD: case OP_COMISS: case OP_COMISD: case OP_KORTEST:
+    case OP_VZEROUPPER: case OP_VZEROALL:
+      return 0;
+    default:
+      return 1;
+  }
+}
+
+static int is_rmw(Op op) {
+  switch (op) {
+    case OP_ADD: case OP_SUB: case OP_AND: case OP_OR: case OP_XOR:
+    case OP_CMOVCC: case OP_XADD: case OP_CMPXCHG:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static void mem_dir(const Insn *in, uint8_t i, int *load, int *store) {
+  *load = *store = 0;
+  if (in->op == OP_LEA || in->op == OP_NOP) return;
+  if (i == 0 && writes_dst(in->op)) {
+    *store = 1;
+    // plain stores do not read memory
+    CostClass c = cost_class(in);
+    if (c == COST_MOV || c == COST_VMOV || c == COST_MOVD || in->op == OP_SETCC || in->op == OP_POP ||
+        in->op == OP_VEXTRACTF128 || in->op == OP_VEXTRACTI128) return;
+  }
+  *load = 1;
+}
+
+// ---- register dataflow ----
+
+static void state_init(RegState *st) {
+  for (int r = 0; r < 16; r++) {
+    st->loaded[r] = 0;
+    st->origin[r] = (uint16_t)(1u << r);
+    st->deref[r] = 0;
+  }
+}
+
+static void clear_regs(RegState *st, uint16_t mask) {
+  for (int r = 0; r < 16; r++) {
+    if (!(mask & (1u << r))) continue;
+    st->loaded[r] = 0;
+    st->origin[r] = 0;
+    st->deref[r] = 0;
+  }
+}
+
+static void addr_flow(const RegState *st, const Operand *o, uint8_t *loaded, uint16_t *origin) {
+  if (o->mem.base < 16)  { *loaded |= st->loaded[o->mem.base];  *origin |= st->origin[o->mem.base]; }
+  if (o->mem.index < 16) { *loaded |= st->loaded[o->mem.index]; *origin |= st->origin[o->mem.index]; }
+}
+
+static uint16_t addr_deref(const RegState *st, const Operand *o) {
+  uint16_t d = 0;
+  if (o->mem.base < 16)  d |= st->deref[o->mem.base];
+  if (o->mem.index < 16) d |= st->deref[o->mem.index];
+  return d;
+}
+
+static void reg_update(RegState *st, const Insn *in) {
+  switch (in->op) {
+    case OP_CALL_REL: case OP_CALL_RM: clear_regs(st, k_clobbered); return;
+    case OP_DIV: case OP_IDIV:         clear_regs(st, (1u << 0) | (1u << 2)); return;
+    case OP_LEAVE:
+      st->loaded[GPR_BP] = 1;
+      st->loaded[GPR_SP] = 0;
+      st->origin[GPR_SP] = st->origin[GPR_BP];
+      st->deref[GPR_SP] = st->deref[GPR_BP];
+      st->deref[GPR_BP] |= st->origin[GPR_BP];
+      return;
+    case OP_POP: {
+      int d = in->op_count ? gpr(&in->ops[0]) : -1;
+      if (d >= 0) {
+        st->loaded[d] = 1;
+        st->origin[d] = st->origin[GPR_SP];
+        st->deref[d] = (uint16_t)(st->origin[GPR_SP] | st->deref[GPR_SP]);
+      }
+      return;
+    }
+    default:
+      break;
+  }
+  if (!in->op_count || !writes_dst(in->op)) return;
+  int d = gpr(&in->ops[0]);
+  if (d < 0) return;
+
+  if ((in->op == OP_XOR || in->op == OP_SUB) && in->op_count == 2 && gpr(&in->ops[1]) == d) {
+    clear_regs(st, (uint16_t)(1u << d));
+    return;
+  }
+  uint8_t loaded = 0;
+  uint16_t origin = 0, deref = 0;
+  // arithmetic into d (a sum of loaded values) does not address through d
+  uint16_t keep = 0xFFFF;
+  if (is_rmw(in->op)) {
+    loaded = st->loaded[d];
+    origin = st->origin[d];
+    deref = st->deref[d];
+    keep = (uint16_t)~(1u << d);
+  }
+  for (uint8_t i = 1; i < in->op_count; i++) {
+    const Operand *o = &in->ops[i];
+    int r = gpr(o);
+    if (r >= 0) {
+      loaded |= st->loaded[r];
+      origin |= st->origin[r];
+      deref |= st->deref[r] & keep;
+    } else if (o->kind == O_MEM) {
+      uint8_t al = 0;
+      uint16_t ao = 0;
+      addr_flow(st, o, &al, &ao);
+      origin |= ao;
+      deref |= addr_deref(st, o);
+      if (in->op != OP_LEA) deref |= ao;
+      loaded |= in->op == OP_LEA ? al : 1;
+    }
+  }
+  st->loaded[d] = loaded;
+  st->origin[d] = origin;
+  st->deref[d] = deref;
+}
+
+static void find_induction(const Insn *v, size_t a, size_t b, Induction *ind) {
+  memset(ind, 0, sizeof(*ind));
+  for (size_t i = a; i <= b; i++) {
+    const Insn *in = &v[i];
+    uint16_t written = 0;
+    int d = -1;
+    int64_t delta = 0;
+    int stepped = 0;
+    if (in->op == OP_CALL_REL || in->op == OP_CALL_RM) written = k_clobbered;
+    else if (in->op == OP_DIV || in->op == OP_IDIV) written = (1u << 0) | (1u << 2);
+    else if (in->op == OP_LEAVE) written = (1u << GPR_SP) | (1u << GPR_BP);
+    else if (in->op_count && (writes_dst(in->op) || in->op == OP_POP)) d = gpr(&in->ops[0]);
+    if (d >= 0) {
+      written = (uint16_t)(1u << d);
+      const Operand *s = in->op_count > 1 ? &in->ops[1] : NULL;
+      if ((in->op == OP_ADD || in->op == OP_SUB) && s && s->kind == O_IMM) {
+        delta = in->op == OP_ADD ? s->imm : -s->imm;
+        stepped = 1;
+      } else if (in->op == OP_LEA && s && s->kind == O_MEM && s->mem.base == d &&
+                 s->mem.index == 0xFF) {
+        delta = s->mem.disp;
+        stepped = 1;
+      }
+    }
+    for (int r = 0; r < 16; r++) {
+      if (!(written & (1u << r))) continue;
+      if (stepped && ind->kind[r] != 2) {
+        ind->kind[r] = 1;
+        ind->step[r] += delta;
+      } else {
+        ind->kind[r] = 2;
+      }
+    }
+  }
+}
+
+// ---- classification ----
+
+static MemClass classify(const RegState *st, const Induction *ind, const Operand *o,
+                         int64_t *stride, int *has_stride) {
+  uint8_t b = o->mem.base, x = o->mem.index;
+  *has_stride = 0;
+  if (b == MEM_RIP) return MA_RIP;
+  if (x >= 16 && (b == GPR_SP || b == GPR_BP)) return MA_STACK;
+  if (x < 16 && st->loaded[x]) return MA_GATHER;
+  if (b < 16 && st->loaded[b]) return MA_CHASE;
+  if (ind && (b >= 16 || ind->kind[b] != 2) && (x >= 16 || ind->kind[x] != 2)) {
+    int64_t s = 0;
+    if (b < 16) s += ind->step[b];
+    if (x < 16) s += ind->step[x] * o->mem.scale;
+    if (s != 0) {
+      *stride = s;
+      *has_stride = 1;
+      return MA_STRIDE;
+    }
+  }
+  return x < 16 ? MA_STRIDE : MA_OTHER;
+}
+
+static void add_stride(MemStats *ms, int64_t s) {
+  for (size_t i = 0; i < ms->nstrides; i++) if (ms->strides[i] == s) return;
+  if (ms->nstrides < MEM_STRIDES) ms->strides[ms->nstrides++] = s;
+  else ms->more_strides = 1;
+}
+
+// Walks v[a..b] once, updating st; counts into ms unless it is NULL.
+static void walk(const Insn *v, size_t a, size_t b, RegState *st, const Induction *ind,
+                 MemStats *ms) {
+  for (size_t i = a; i <= b; i++) {
+    const Insn *in = &v[i];
+    if (ms) {
+      switch (in->op) {
+        case OP_PUSH: case OP_CALL_REL: case OP_CALL_RM:
+          ms->stores++; ms->cls[MA_STACK]++; break;
+        case OP_POP: case OP_RET: case OP_LEAVE:
+          ms->loads++; ms->cls[MA_STACK]++; break;
+        default:
+          break;
+      }
+      for (uint8_t k = 0; k < in->op_count; k++) {
+        const Operand *o = &in->ops[k];
+        if (o->kind != O_MEM) continue;
+        int load, store;
+        mem_dir(in, k, &load, &store);
+        if (!load && !store) continue;
+        ms->loads += (uint64_t)load;
+        ms->stores += (uint64_t)store;
+        int64_t s = 0;
+        int has_stride;
+        ms->cls[classify(st, ind, o, &s, &has_stride)]++;
+        if (o->mem.base < 16) ms->bases |= (uint16_t)(1u << o->mem.base);
+        if (has_stride) add_stride(ms, s);
+      }
+    }
+    reg_update(st, in);
+  }
+}
+
+// Pass 1 finds what an iteration leaves behind (and loop-carried chasing),
+// pass 2 classifies with that state as the loop entry.
+static void loop_stats(const Insn *v, size_t head, size_t tail, MemStats *ms) {
+  memset(ms, 0, sizeof(*ms));
+  Induction ind;
+  find_induction(v, head, tail, &ind);
+  RegState st;
+  state_init(&st);
+  walk(v, head, tail, &st, &ind, NULL);
+  for (int r = 0; r < 16; r++) {
+    if (st.deref[r] & (1u << r)) ms->chase = 1;
+  }
+  walk(v, head, tail, &st, &ind, ms);
+}
+
+// ---- report ----
+
+static void print_row(FILE *out, const char *label, const char *kind, const MemStats *ms,
+                      const char *carry, uint64_t head, uint64_t insns, const char *name,
+                      uint64_t loops) {
+  char strides[64];
+  size_t at = 0;
+  strides[0] = 0;
+  for (size_t i = 0; i < ms->nstrides; i++) {
+    at += (size_t)snprintf(strides + at, sizeof(strides) - at, "%s%lld", i ? "," : "",
+                           (long long)ms->strides[i]);
+  }
+  if (ms->more_strides) snprintf(strides + at, sizeof(strides) - at, ",...");
+  if (!ms->nstrides) snprintf(strides, sizeof(strides), "-");
+
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%-6s %6llu %6llu %5llu %5llu %5llu %6llu %6llu %5llu %5d  %-5s  %-14s %016llx %6llu  %s",
+    kind, (unsigned long long)ms->loads, (unsigned long long)ms->stores,
+    (unsigned long long)ms->cls[MA_RIP], (unsigned long long)ms->cls[MA_STACK],
+    (unsigned long long)ms->cls[MA_CHASE], (unsigned long long)ms->cls[MA_GATHER],
+    (unsigned long long)ms->cls[MA_STRIDE], (unsigned long long)ms->cls[MA_OTHER],
+    __builtin_popcount(ms->bases), carry, strides, (unsigned long long)head,
+    (unsigned long long)insns, name);
+  if (loops != UINT64_MAX) fprintf(out, "  (%llu loops)", (unsigned long long)loops);
+  fprintf(out, "\n");
+}
+
+void mem_report(FILE *out, const Image *img, const char *label) {
+  Arena *sa = arena_thread();
+  InsnVec vec = {0};
+  Loop *loops = NULL;
+  size_t loops_cap = 0;
+
+  fprintf(out, "# kind %6s %6s %5s %5s %5s %6s %6s %5s %5s  %-5s  %-14s %-16s %6s  %s\n",
+    "loads", "stores", "rip", "stack", "chase", "gather", "stride", "other", "bases",
+    "carry", "strides", "head", "insns", "function");
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+
+    for (size_t r = 0; r < nr; r++) {
+      if (!insn_vec_decode(&vec, img->buf + regs[r].offset, regs[r].size, regs[r].addr)) break;
+      if (vec.n == 0) continue;
+
+      char gap[40];
+      const char *name = region_name(regs[r].name, regs[r].addr, gap, sizeof(gap));
+
+      MemStats fn;
+      memset(&fn, 0, sizeof(fn));
+      size_t nl = flow_find_loops(&vec, &loops, &loops_cap);
+      for (size_t l = 0; l < nl; l++) {
+        MemStats ms;
+        loop_stats(vec.v, loops[l].head, loops[l].tail, &ms);
+        for (size_t i = 0; i < ms.nstrides; i++) add_stride(&fn, ms.strides[i]);
+        fn.more_strides |= ms.more_strides;
+        fn.chase += ms.chase;
+        print_row(out, label, "loop", &ms, ms.chase ? "chase" : "-", vec.v[loops[l].head].addr,
+                  loops[l].tail - loops[l].head + 1, name, UINT64_MAX);
+      }
+
+      RegState st;
+      state_init(&st);
+      walk(vec.v, 0, vec.n - 1, &st, NULL, &fn);
+      char carry[24];
+      if (fn.chase) snprintf(carry, sizeof(carry), "%d", fn.chase);
+      else snprintf(carry, sizeof(carry), "-");
+      print_row(out, label, "func", &fn, carry, regs[r].addr, vec.n, name, nl);
+    }
+    arena_reset(sa, mark);
+  }
+
+  free(loops);
+  insn_vec_free(&vec);
+}
@@ -30,6 +30,19 @@ const OpEntry g_ops[] = {
   {OT_1, 0x83, 0x00, OP_INVALID, (uint16_t)(OF_MODRM | OF_GRP83)},
   {OT_1, 0x85, 0x00, OP_TEST,    (uint16_t)(OF_MODRM)},
 
+  // op eax, imm (ax with 66: imm16)
+  {OT_1, 0x05, 0x00, OP_ADD,  OF_ACC_IMM},
+  {OT_1, 0x0D, 0x00, OP_OR,   OF_ACC_IMM},
+  {OT_1, 0x25, 0x00, OP_AND,  OF_ACC_IMM},
+  {OT_1, 0x2D, 0x00, OP_SUB,  OF_ACC_IMM},
+  {OT_1, 0x35, 0x00, OP_XOR,  OF_ACC_IMM},
+  {OT_1, 0x3D, 0x00, OP_CMP,  OF_ACC_IMM},
+  {OT_1, 0xA9, 0x00, OP_TEST, OF_ACC_IMM},
+
+  // imul r, r/m, imm
+  {OT_1, 0x69, 0x00, OP_IMUL, (uint16_t)(OF_MODRM | OF_IMUL_IMM)},
+  {OT_1, 0x6B, 0x00, OP_IMUL, (uint16_t)(OF_MODRM | OF_IMUL_IMM)},
+
   // mov reg, imm
   {OT_1, 0xB8, 0x00, OP_MOV, (uint16_t)(OF_REG_RANGE | OF_MOV_IMM_REG)},
 
@@ -41,8 +54,9 @@ const OpEntry g_ops[] = {
   // OR r/m8, r8
   {OT_1, 0x08, 0x00, OP_OR,  (uint16_t)(OF_MODRM | OF_BYTE)},
 
-  // C6 /0: mov r/m8, imm8
+  // C6 /0: mov r/m8, imm8; C7 /0: mov r/m, imm16/32
   {OT_1, 0xC6, 0x00, OP_MOV, (uint16_t)(OF_MODRM | OF_GRP_C6 | OF_BYTE)},
+  {OT_1, 0xC7, 0x00, OP_MOV, (uint16_t)(OF_MODRM | OF_GRP_C6)},
 
   // FF group: /2 CALL r/m64, /4 JMP r/m64
   {OT_1, 0xFF, 0x00, OP_INVALID, (uint16_t)(OF_MODRM | OF_GRP_FF)},
@@ -50,12 +64,176 @@ const OpEntry g_ops[] = {
   // SETcc: 0F 90..9F /r
   {OT_2, 0x0F, 0x90, OP_SETCC, (uint16_t)(OF_MODRM | OF_CC | OF_REG_RANGE | OF_SETCC)},
 
-  // PXOR xmm, xmm/m128 : 66 0F EF /r
-  {OT_2, 0x0F, 0xEF, OP_PXOR, (uint16_t)(OF_MODRM)},
-
   {OT_1, 0xC9, 0x00, OP_LEAVE, OF_NONE},
 
   {OT_2, 0x0F, 0x40, OP_CMOVCC, (uint16_t)(OF_MODRM | OF_CC | OF_REG_RANGE)},
+
+  // F6/F7 group: /0 /1 TEST r/m, imm; /6 DIV r/m, /7 IDIV r/m
+  {OT_1, 0xF6, 0x00, OP_INVALID, (uint16_t)(OF_MODRM | OF_GRP_F7 | OF_BYTE)},
+  {OT_1, 0xF7, 0x00, OP_INVALID, (uint16_t)(OF_MODRM | OF_GRP_F7)},
+
+  // CMPXCHG / XADD r/m, r (usually lock-prefixed)
+  {OT_2, 0x0F, 0xB1, OP_CMPXCHG, (uint16_t)(OF_MODRM)},
+  {OT_2, 0x0F, 0xC1, OP_XADD,    (uint16_t)(OF_MODRM)},
 };
 
 const unsigned g_ops_count = sizeof(g_ops)/sizeof(g_ops[0]);
+
+#define FP4(opc, ps, pd, ss, sd, form) \
+  {VM_0F, opc, VP_NP, VW_ANY, ps, form, 4, VX_NONE},   \
+  {VM_0F, opc, VP_66, VW_ANY, pd, form, 8, VX_NONE},   \
+  {VM_0F, opc, VP_F3, VW_ANY, ss, VF_RVM, 4, VX_SCALAR}, \
+  {VM_0F, opc, VP_F2, VW_ANY, sd, VF_RVM, 8, VX_SCALAR}
+
+#define FMA4(opc, ps, pd, ss, sd) \
+  {VM_0F38, opc,     VP_66, VW_0, ps, VF_RVM, 4, VX_VEX_ONLY}, \
+  {VM_0F38, opc,     VP_66, VW_1, pd, VF_RVM, 8, VX_VEX_ONLY}, \
+  {VM_0F38, opc + 1, VP_66, VW_0, ss, VF_RVM, 4, (uint16_t)(VX_VEX_ONLY | VX_SCALAR)}, \
+  {VM_0F38, opc + 1, VP_66, VW_1, sd, VF_RVM, 8, (uint16_t)(VX_VEX_ONLY | VX_SCALAR)}
+
+const VecEntry g_vops[] = {
+  // moves
+  {VM_0F, 0x10, VP_NP, VW_ANY, OP_MOVUPS, VF_RM, 4, VX_NONE},
+  {VM_0F, 0x10, VP_66, VW_ANY, OP_MOVUPD, VF_RM, 8, VX_NONE},
+  {VM_0F, 0x10, VP_F3, VW_ANY, OP_MOVSS,  VF_RM, 4, (uint16_t)(VX_SCALAR | VX_MERGE_REG)},
+  {VM_0F, 0x10, VP_F2, VW_ANY, OP_MOVSD,  VF_RM, 8, (uint16_t)(VX_SCALAR | VX_MERGE_REG)},
+  {VM_0F, 0x11, VP_NP, VW_ANY, OP_MOVUPS, VF_MR, 4, VX_NONE},
+  {VM_0F, 0x11, VP_66, VW_ANY, OP_MOVUPD, VF_MR, 8, VX_NONE},
+  {VM_0F, 0x11, VP_F3, VW_ANY, OP_MOVSS,  VF_MR, 4, (uint16_t)(VX_SCALAR | VX_MERGE_REG)},
+  {VM_0F, 0x11, VP_F2, VW_ANY, OP_MOVSD,  VF_MR, 8, (uint16_t)(VX_SCALAR | VX_MERGE_REG)},
+  {VM_0F, 0x28, VP_NP, VW_ANY, OP_MOVAPS, VF_RM, 4, VX_NONE},
+  {VM_0F, 0x28, VP_66, VW_ANY, OP_MOVAPD, VF_RM, 8, VX_NONE},
+  {VM_0F, 0x29, VP_NP, VW_ANY, OP_MOVAPS, VF_MR, 4, VX_NONE},
+  {VM_0F, 0x29, VP_66, VW_ANY, OP_MOVAPD, VF_MR, 8, VX_NONE},
+  {VM_0F, 0x6E, VP_66, VW_0,   OP_MOVD,   VF_RM, 4, (uint16_t)(VX_SCALAR | VX_RM_GPR)},
+  {VM_0F, 0x6E, VP_66, VW_1,   OP_MOVQ,   VF_RM, 8, (uint16_t)(VX_SCALAR | VX_RM_GPR)},
+  {VM_0F, 0x7E, VP_66, VW_0,   OP_MOVD,   VF_MR, 4, (uint16_t)(VX_SCALAR | VX_RM_GPR)},
+  {VM_0F, 0x7E, VP_66, VW_1,   OP_MOVQ,   VF_MR, 8, (uint16_t)(VX_SCALAR | VX_RM_GPR)},
+  {VM_0F, 0x7E, VP_F3, VW_ANY, OP_MOVQ,   VF_RM, 8, VX_SCALAR},
+  {VM_0F, 0xD6, VP_66, VW_ANY, OP_MOVQ,   VF_MR, 8, VX_SCALAR},
+  {VM_0F, 0x6F, VP_66, VW_ANY, OP_MOVDQA, VF_RM, 4, VX_ESIZE_W},
+  {VM_0F, 0x6F, VP_F3, VW_ANY, OP_MOVDQU, VF_RM, 4, VX_ESIZE_W},
+  {VM_0F, 0x6F, VP_F2, VW_0,   OP_MOVDQU, VF_RM, 1, VX_EVEX_ONLY},
+  {VM_0F, 0x6F, VP_F2, VW_1,   OP_MOVDQU, VF_RM, 2, VX_EVEX_ONLY},
+  {VM_0F, 0x7F, VP_66, VW_ANY, OP_MOVDQA, VF_MR, 4, VX_ESIZE_W},
+  {VM_0F, 0x7F, VP_F3, VW_ANY, OP_MOVDQU, VF_MR, 4, VX_ESIZE_W},
+  {VM_0F, 0x7F, VP_F2, VW_0,   OP_MOVDQU, VF_MR, 1, VX_EVEX_ONLY},
+  {VM_0F, 0x7F, VP_F2, VW_1,   OP_MOVDQU, VF_MR, 2, VX_EVEX_ONLY},
+
+  // compares into EFLAGS
+  {VM_0F, 0x2E, VP_NP, VW_ANY, OP_UCOMISS, VF_RM, 4, VX_SCALAR},
+  {VM_0F, 0x2E, VP_66, VW_ANY, OP_UCOMISD, VF_RM, 8, VX_SCALAR},
+  {VM_0F, 0x2F, VP_NP, VW_ANY, OP_COMISS,  VF_RM, 4, VX_SCALAR},
+  {VM_0F, 0x2F, VP_66, VW_ANY, OP_COMISD,  VF_RM, 8, VX_SCALAR},
+
+  // floating point arithmetic / logic
+  {VM_0F, 0x51, VP_NP, VW_ANY, OP_SQRTPS, VF_RM,  4, VX_NONE},
+  {VM_0F, 0x51, VP_66, VW_ANY, OP_SQRTPD, VF_RM,  8, VX_NONE},
+  {VM_0F, 0x51, VP_F3, VW_ANY, OP_SQRTSS, VF_RVM, 4, VX_SCALAR},
+  {VM_0F, 0x51, VP_F2, VW_ANY, OP_SQRTSD, VF_RVM, 8, VX_SCALAR},
+  {VM_0F, 0x54, VP_NP, VW_ANY, OP_ANDPS,  VF_RVM, 4, VX_NONE},
+  {VM_0F, 0x54, VP_66, VW_ANY, OP_ANDPD,  VF_RVM, 8, VX_NONE},
+  {VM_0F, 0x55, VP_NP, VW_ANY, OP_ANDNPS, VF_RVM, 4, VX_NONE},
+  {VM_0F, 0x55, VP_66, VW_ANY, OP_ANDNPD, VF_RVM, 8, VX_NONE},
+  {VM_0F, 0x56, VP_NP, VW_ANY, OP_ORPS,   VF_RVM, 4, VX_NONE},
+  {VM_0F, 0x56, VP_66, VW_ANY, OP_ORPD,   VF_RVM, 8, VX_NONE},
+  {VM_0F, 0x57, VP_NP, VW_ANY, OP_XORPS,  VF_RVM, 4, VX_NONE},
+  {VM_0F, 0x57, VP_66, VW_ANY, OP_XORPD,  VF_RVM, 8, VX_NONE},
+  FP4(0x58, OP_ADDPS, OP_ADDPD, OP_ADDSS, OP_ADDSD, VF_RVM),
+  FP4(0x59, OP_MULPS, OP_MULPD, OP_MULSS, OP_MULSD, VF_RVM),
+  FP4(0x5C, OP_SUBPS, OP_SUBPD, OP_SUBSS, OP_SUBSD, VF_RVM),
+  FP4(0x5D, OP_MINPS, OP_MINPD, OP_MINSS, OP_MINSD, VF_RVM),
+  FP4(0x5E, OP_DIVPS, OP_DIVPD, OP_DIVSS, OP_DIVSD, VF_RVM),
+  FP4(0x5F, OP_MAXPS, OP_MAXPD, OP_MAXSS, OP_MAXSD, VF_RVM),
+  // EVEX cmpps writes a mask register: left to the unknown-opcode sizing
+  {VM_0F, 0xC2, VP_NP, VW_ANY, OP_CMPPS, VF_RVMI, 4, VX_NO_EVEX},
+  {VM_0F, 0xC2, VP_66, VW_ANY, OP_CMPPD, VF_RVMI, 8, VX_NO_EVEX},
+  {VM_0F, 0xC2, VP_F3, VW_ANY, OP_CMPSS, VF_RVMI, 4, (uint16_t)(VX_NO_EVEX | VX_SCALAR)},
+  {VM_0F, 0xC2, VP_F2, VW_ANY, OP_CMPSD, VF_RVMI, 8, (uint16_t)(VX_NO_EVEX | VX_SCALAR)},
+  {VM_0F, 0x14, VP_NP, VW_ANY, OP_UNPCKLPS, VF_RVM,  4, VX_NONE},
+  {VM_0F, 0x14, VP_66, VW_ANY, OP_UNPCKLPD, VF_RVM,  8, VX_NONE},
+  {VM_0F, 0x15, VP_NP, VW_ANY, OP_UNPCKHPS, VF_RVM,  4, VX_NONE},
+  {VM_0F, 0x15, VP_66, VW_ANY, OP_UNPCKHPD, VF_RVM,  8, VX_NONE},
+  {VM_0F, 0xC6, VP_NP, VW_ANY, OP_SHUFPS,   VF_RVMI, 4, VX_NONE},
+  {VM_0F, 0xC6, VP_66, VW_ANY, OP_SHUFPD,   VF_RVMI, 8, VX_NONE},
+
+  // packed integer
+  {VM_0F,   0x70, VP_66, VW_ANY, OP_PSHUFD,   VF_RMI,  4, VX_NONE},
+  {VM_0F,   0x70, VP_F3, VW_ANY, OP_PSHUFHW,  VF_RMI,  2, VX_NONE},
+  {VM_0F,   0x70, VP_F2, VW_ANY, OP_PSHUFLW,  VF_RMI,  2, VX_NONE},
+  {VM_0F,   0xC4, VP_66, VW_ANY, OP_PINSRW,   VF_RVMI, 2, (uint16_t)(VX_SCALAR | VX_RM_GPR)},
+  {VM_0F,   0xC5, VP_66, VW_ANY, OP_PEXTRW,   VF_RMI,  2, (uint16_t)(VX_SCALAR | VX_REG_GPR)},
+  {VM_0F38, 0x00, VP_66, VW_ANY, OP_PSHUFB,   VF_RVM,  1, VX_NONE},
+  {VM_0F3A, 0x0F, VP_66, VW_ANY, OP_PALIGNR,  VF_RVMI, 1, VX_NONE},
+  {VM_0F,   0x74, VP_66, VW_ANY, OP_PCMPEQB,  VF_RVM,  1, VX_NO_EVEX},
+  {VM_0F,   0x75, VP_66, VW_ANY, OP_PCMPEQW,  VF_RVM,  2, VX_NO_EVEX},
+  {VM_0F,   0x76, VP_66, VW_ANY, OP_PCMPEQD,  VF_RVM,  4, VX_NO_EVEX},
+  {VM_0F,   0xD7, VP_66, VW_ANY, OP_PMOVMSKB, VF_RM,   1, (uint16_t)(VX_NO_EVEX | VX_REG_GPR)},
+  {VM_0F,   0xDB, VP_66, VW_ANY, OP_PAND,     VF_RVM,  4, VX_ESIZE_W},
+  {VM_0F,   0xDF, VP_66, VW_ANY, OP_PANDN,    VF_RVM,  4, VX_ESIZE_W},
+  {VM_0F,   0xEB, VP_66, VW_ANY, OP_POR,      VF_RVM,  4, VX_ESIZE_W},
+  {VM_0F,   0xEF, VP_66, VW_ANY, OP_PXOR,     VF_RVM,  4, VX_ESIZE_W},
+  {VM_0F,   0xFC, VP_66, VW_ANY, OP_PADDB,    VF_RVM,  1, VX_NONE},
+  {VM_0F,   0xFD, VP_66, VW_ANY, OP_PADDW,    VF_RVM,  2, VX_NONE},
+  {VM_0F,   0xFE, VP_66, VW_ANY, OP_PADDD,    VF_RVM,  4, VX_NONE},
+  {VM_0F,   0xD4, VP_66, VW_ANY, OP_PADDQ,    VF_RVM,  8, VX_NONE},
+  {VM_0F,   0xF8, VP_66, VW_ANY, OP_PSUBB,    VF_RVM,  1, VX_NONE},
+  {VM_0F,   0xF9, VP_66, VW_ANY, OP_PSUBW,    VF_RVM,  2, VX_NONE},
+  {VM_0F,   0xFA, VP_66, VW_ANY, OP_PSUBD,    VF_RVM,  4, VX_NONE},
+  {VM_0F,   0xFB, VP_66, VW_ANY, OP_PSUBQ,    VF_RVM,  8, VX_NONE},
+  {VM_0F38, 0x40, VP_66, VW_0,   OP_PMULLD,   VF_RVM,  4, VX_NONE},
+  {VM_0F,   0xF4, VP_66, VW_ANY, OP_PMULUDQ,  VF_RVM,  8, VX_NONE},
+  {VM_0F,   0x71, VP_66, VW_ANY, OP_INVALID,  VF_VMI,  2, VX_GRP_SHIFT},
+  {VM_0F,   0x72, VP_66, VW_ANY, OP_INVALID,  VF_VMI,  4, VX_GRP_SHIFT},
+  {VM_0F,   0x73, VP_66, VW_ANY, OP_INVALID,  VF_VMI,  8, VX_GRP_SHIFT},
+
+  // AVX / AVX2 only
+  {VM_0F,   0x77, VP_NP, VW_ANY, OP_VZEROUPPER,   VF_NONE, 0, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX)},
+  {VM_0F38, 0x18, VP_66, VW_0,   OP_VBROADCASTSS, VF_RM,   4, (uint16_t)(VX_VEX_ONLY | VX_BCAST_SRC)},
+  {VM_0F38, 0x19, VP_66, VW_ANY, OP_VBROADCASTSD, VF_RM,   8, (uint16_t)(VX_VEX_ONLY | VX_BCAST_SRC)},
+  {VM_0F38, 0x78, VP_66, VW_0,   OP_VPBROADCASTB, VF_RM,   1, (uint16_t)(VX_VEX_ONLY | VX_BCAST_SRC)},
+  {VM_0F38, 0x79, VP_66, VW_0,   OP_VPBROADCASTW, VF_RM,   2, (uint16_t)(VX_VEX_ONLY | VX_BCAST_SRC)},
+  {VM_0F38, 0x58, VP_66, VW_0,   OP_VPBROADCASTD, VF_RM,   4, (uint16_t)(VX_VEX_ONLY | VX_BCAST_SRC)},
+  {VM_0F38, 0x59, VP_66, VW_ANY, OP_VPBROADCASTQ, VF_RM,   8, (uint16_t)(VX_VEX_ONLY | VX_BCAST_SRC)},
+  {VM_0F38, 0x36, VP_66, VW_0,   OP_VPERMD,       VF_RVM,  4, VX_VEX_ONLY},
+  {VM_0F3A, 0x06, VP_66, VW_0,   OP_VPERM2F128,   VF_RVMI, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX)},
+  {VM_0F3A, 0x46, VP_66, VW_0,   OP_VPERM2I128,   VF_RVMI, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX)},
+  {VM_0F3A, 0x18, VP_66, VW_ANY, OP_VINSERTF128,  VF_RVMI, 4, (uint16_t)(VX_VEX_ONLY | VX_RM_X128 | VX_ESIZE_W)},
+  {VM_0F3A, 0x19, VP_66, VW_ANY, OP_VEXTRACTF128, VF_MRI,  4, (uint16_t)(VX_VEX_ONLY | VX_RM_X128 | VX_ESIZE_W)},
+  {VM_0F3A, 0x38, VP_66, VW_ANY, OP_VINSERTI128,  VF_RVMI, 4, (uint16_t)(VX_VEX_ONLY | VX_RM_X128 | VX_ESIZE_W)},
+  {VM_0F3A, 0x39, VP_66, VW_ANY, OP_VEXTRACTI128, VF_MRI,  4, (uint16_t)(VX_VEX_ONLY | VX_RM_X128 | VX_ESIZE_W)},
+  FMA4(0x98, OP_VFMADD132PS, OP_VFMADD132PD, OP_VFMADD132SS, OP_VFMADD132SD),
+  FMA4(0xA8, OP_VFMADD213PS, OP_VFMADD213PD, OP_VFMADD213SS, OP_VFMADD213SD),
+  FMA4(0xB8, OP_VFMADD231PS, OP_VFMADD231PD, OP_VFMADD231SS, OP_VFMADD231SD),
+
+  // AVX-512 only
+  {VM_0F3A, 0x25, VP_66, VW_0, OP_VPTERNLOGD, VF_RVMI, 4, VX_EVEX_ONLY},
+  {VM_0F3A, 0x25, VP_66, VW_1, OP_VPTERNLOGQ, VF_RVMI, 8, VX_EVEX_ONLY},
+
+  // AVX-512 mask registers (VEX encoded)
+  {VM_0F, 0x90, VP_NP, VW_0, OP_KMOV, VF_RM, 2, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x90, VP_66, VW_0, OP_KMOV, VF_RM, 1, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x90, VP_NP, VW_1, OP_KMOV, VF_RM, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x90, VP_66, VW_1, OP_KMOV, VF_RM, 4, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x91, VP_NP, VW_0, OP_KMOV, VF_MR, 2, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x91, VP_66, VW_0, OP_KMOV, VF_MR, 1, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x91, VP_NP, VW_1, OP_KMOV, VF_MR, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x91, VP_66, VW_1, OP_KMOV, VF_MR, 4, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x92, VP_NP, VW_0, OP_KMOV, VF_RM, 2, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_GPR)},
+  {VM_0F, 0x92, VP_66, VW_0, OP_KMOV, VF_RM, 1, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_GPR)},
+  {VM_0F, 0x92, VP_F2, VW_0, OP_KMOV, VF_RM, 4, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_GPR)},
+  {VM_0F, 0x92, VP_F2, VW_1, OP_KMOV, VF_RM, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_GPR)},
+  {VM_0F, 0x93, VP_NP, VW_0, OP_KMOV, VF_RM, 2, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_GPR | VX_RM_K)},
+  {VM_0F, 0x93, VP_66, VW_0, OP_KMOV, VF_RM, 1, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_GPR | VX_RM_K)},
+  {VM_0F, 0x93, VP_F2, VW_0, OP_KMOV, VF_RM, 4, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_GPR | VX_RM_K)},
+  {VM_0F, 0x93, VP_F2, VW_1, OP_KMOV, VF_RM, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_GPR | VX_RM_K)},
+  {VM_0F, 0x98, VP_NP, VW_0, OP_KORTEST, VF_RM, 2, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x98, VP_66, VW_0, OP_KORTEST, VF_RM, 1, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x98, VP_NP, VW_1, OP_KORTEST, VF_RM, 8, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+  {VM_0F, 0x98, VP_66, VW_1, OP_KORTEST, VF_RM, 4, (uint16_t)(VX_VEX_ONLY | VX_NO_EVEX | VX_REG_K | VX_RM_K)},
+};
+
+#undef FP4
+#undef FMA4
+
+const unsigned g_vops_count = sizeof(g_vops)/sizeof(g_vops[0]);
@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/pagemap.h"
+#include "opdump/decode.h"
+#include "opdump/arena.h"
+
+enum { PAGE_BATCH = 4096, PAGE_NAMES = 3 };
+
+typedef struct {
+  uint64_t addr;
+  uint64_t lo, hi;    // part of the page inside code segments (their span if several)
+  uint64_t used;      // decoded, non-fill bytes
+  uint64_t pad;       // nop / int3 / zero fill
+  uint64_t weight;
+  uint64_t funcs;
+  const char *names[PAGE_NAMES];
+} Page;
+
+// One row per page, sorted by address: segments sharing a page share its row.
+typedef struct {
+  Page *v;
+  size_t n, cap;
+  unsigned shift;
+  const char *kind;
+} PageSet;
+
+// First page at or above addr.
+static size_t page_lower_bound(const PageSet *ps, uint64_t addr) {
+  size_t lo = 0, hi = ps->n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (ps->v[mid].addr < addr) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// Pages covering [a0, a1) of one segment, added to ps or widened where
+// another segment already has them; *base is the index of the first.
+static int pages_init(PageSet *ps, uint64_t a0, uint64_t a1, size_t *base) {
+  uint64_t first = a0 >> ps->shift, last = (a1 - 1) >> ps->shift;
+  for (uint64_t pg = first; pg <= last; pg++) {
+    uint64_t addr = pg << ps->shift, end = addr + ((uint64_t)1 << ps->shift);
+    uint64_t lo = addr > a0 ? addr : a0, hi = end < a1 ? end : a1;
+    size_t i = page_lower_bound(ps, addr);
+    if (i < ps->n && ps->v[i].addr == addr) {
+      if (lo < ps->v[i].lo) ps->v[i].lo = lo;
+      if (hi > ps->v[i].hi) ps->v[i].hi = hi;
+      continue;
+    }
+    if (ps->n == ps->cap) {
+      size_t nc = ps->cap ? ps->cap * 2 : 64;
+      if (nc < ps->n + (size_t)(last - pg + 1)) nc = ps->n + (size_t)(last - pg + 1);
+      Page *nv = (Page*)realloc(ps->v, nc * sizeof(Page));
+      if (!nv) return 0;
+      ps->v = nv;
+      ps->cap = nc;
+    }
+    memmove(ps->v + i + 1, ps->v + i, (ps->n - i) * sizeof(Page));
+    memset(&ps->v[i], 0, sizeof(Page));
+    ps->v[i].addr = addr;
+    ps->v[i].lo = lo;
+    ps->v[i].hi = hi;
+    ps->n++;
+  }
+  *base = page_lower_bound(ps, first << ps->shift);
+  return 1;
+}
+
+// Adds [a, a+len) to used or pad, split at page boundaries; base is the
+// index of the segment's first page.
+static void pages_add(PageSet *ps, size_t base, uint64_t a, uint64_t len, int fill) {
+  uint64_t first = ps->v[base].addr >> ps->shift;
+  while (len) {
+    uint64_t pg = a >> ps->shift;
+    uint64_t end = (pg + 1) << ps->shift;
+    uint64_t k = end - a < len ? end - a : len;
+    Page *p = &ps->v[base + (size_t)(pg - first)];
+    if (fill) p->pad += k;
+    else      p->used += k;
+    a += k;
+    len -= k;
+  }
+}
+
+static void pages_add_func(PageSet *ps, size_t base, const Region *r) {
+  if (!r->name || r->size == 0) return;
+  uint64_t first = ps->v[base].addr >> ps->shift;
+  for (uint64_t pg = r->addr >> ps->shift; pg <= (r->addr + r->size - 1) >> ps->shift; pg++) {
+    Page *p = &ps->v[base + (size_t)(pg - first)];
+    if (p->funcs < PAGE_NAMES) p->names[p->funcs] = r->name;
+    p->funcs++;
+  }
+}
+
+static void scan_segment(const Image *img, const ElfExecSeg *seg, Insn *batch,
+                         PageSet *ps, size_t nps) {
+  size_t base[2];
+  for (size_t k = 0; k < nps; k++) {
+    if (!pages_init(&ps[k], seg->vaddr, seg->vaddr + seg->filesz, &base[k])) return;
+  }
+
+  Arena *sa = arena_thread();
+  ArenaMark mark = arena_mark(sa);
+  Region *regs = NULL;
+  size_t nr = elf_split_regions(seg, img->syms, img->sym_count, sa, &regs);
+  for (size_t r = 0; r < nr; r++) {
+    for (size_t k = 0; k < nps; k++) pages_add_func(&ps[k], base[k], &regs[r]);
+
+    DecodeCtx ctx = {0};
+    ctx.is64 = 1;
+    const uint8_t *p = img->buf + regs[r].offset;
+    uint64_t off = 0;
+    while (off < regs[r].size) {
+      size_t used = 0;
+      size_t got = decode_batch(&ctx, p + off, (size_t)(regs[r].size - off), regs[r].addr + off,
+                                batch, PAGE_BATCH, &used);
+      off += used;
+      for (size_t i = 0; i < got; i++) {
+        int fill = insn_is_fill(&batch[i]);
+        for (size_t k = 0; k < nps; k++) pages_add(&ps[k], base[k], batch[i].addr, batch[i].size, fill);
+      }
+    }
+  }
+  arena_reset(sa, mark);
+}
+
+static void print_page(FILE *out, const PageSet *ps, const Page *p, const SampleIndex *smp,
+                       const char *label) {
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%-3s %016llx %8llu %7llu  ", ps->kind, (unsigned long long)p->addr,
+    (unsigned long long)p->used, (unsigned long long)p->pad);
+  if (smp && smp->total) fprintf(out, "%6.2f%%", 100.0 * (double)p->weight / (double)smp->total);
+  else                   fprintf(out, "%7s", "-");
+  fprintf(out, " %6llu", (unsigned long long)p->funcs);
+  for (uint64_t i = 0; i < p->funcs && i < PAGE_NAMES; i++) fprintf(out, i ? " %s" : "  %s", p->names[i]);
+  if (p->funcs > PAGE_NAMES) fprintf(out, " +%llu", (unsigned long long)(p->funcs - PAGE_NAMES));
+  fprintf(out, "\n");
+}
+
+static _Thread_local const Page *g_pages; // qsort has no context argument
+
+static int cmp_weight(const void *a, const void *b) {
+  const Page *x = &g_pages[*(const size_t*)a], *y = &g_pages[*(const size_t*)b];
+  if (x->weight != y->weight) return (x->weight < y->weight) - (x->weight > y->weight);
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+// Heaviest pages first until cover_pct of the in-code weight is reached.
+static void print_cover(FILE *out, const PageSet *ps, double cover_pct, const SampleIndex *smp,
+                        const char *label) {
+  uint64_t hot = 0;
+  size_t nz = 0;
+  for (size_t i = 0; i < ps->n; i++) { hot += ps->v[i].weight; nz += ps->v[i].weight != 0; }
+
+  size_t *idx = (size_t*)malloc((ps->n ? ps->n : 1) * sizeof(size_t));
+  if (!idx) return;
+  for (size_t i = 0; i < ps->n; i++) idx[i] = i;
+  g_pages = ps->v;
+  qsort(idx, ps->n, sizeof(size_t), cmp_weight);
+
+  size_t k = 0;
+  uint64_t cum = 0;
+  const double want = (double)hot * cover_pct / 100.0;
+  while (k < ps->n && hot && (double)cum < want) cum += ps->v[idx[k++]].weight;
+
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# cover %.1f%% of %.2f%% in-code samples: %llu of %llu %s pages (%llu with samples)\n",
+    cover_pct, smp->total ? 100.0 * (double)hot / (double)smp->total : 0.0,
+    (unsigned long long)k, (unsigned long long)ps->n, ps->kind, (unsigned long long)nz);
+
+  uint64_t run = 0;
+  for (size_t i = 0; i < k; i++) {
+    const Page *p = &ps->v[idx[i]];
+    run += p->weight;
+    if (label) fprintf(out, "%s: ", label);
+    fprintf(out, "hot%-3s %016llx %6.2f%% %6.2f%%\n", ps->kind, (unsigned long long)p->addr,
+      100.0 * (double)p->weight / (double)hot, 100.0 * (double)run / (double)hot);
+  }
+  free(idx);
+}
+
+void page_map(FILE *out, const Image *img, const SampleIndex *smp, double cover_pct,
+              const char *label) {
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, PAGE_BATCH * sizeof(Insn));
+  if (!batch) return;
+
+  PageSet ps[2] = { { NULL, 0, 0, 12, "4k" }, { NULL, 0, 0, 21, "2m" } };
+  for (size_t s = 0; s < img->seg_count; s++) {
+    if (img->segs[s].filesz) scan_segment(img, &img->segs[s], batch, ps, 2);
+  }
+  arena_reset(sa, batch_mark);
+
+  fprintf(out, "# pg  address               used     pad  samples  funcs  functions\n");
+  for (size_t k = 0; k < 2; k++) {
+    for (size_t i = 0; i < ps[k].n; i++) {
+      Page *p = &ps[k].v[i];
+      if (smp) p->weight = samples_range(smp, p->lo, p->hi);
+      print_page(out, &ps[k], p, smp, label);
+    }
+  }
+  if (smp) {
+    for (size_t k = 0; k < 2; k++) print_cover(out, &ps[k], cover_pct, smp, label);
+  }
+  free(ps[0].v);
+  free(ps[1].v);
+}
@@ -0,0 +1,107 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "opdump/procmem.h"
+
+enum { PROC_CHUNK = 1 << 20, PROC_IOVS = 64, PROC_PAGE = 4096 };
+
+size_t proc_exec_maps(int pid, ProcMap **out) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+  FILE *f = fopen(path, "r");
+  if (!f) return (size_t)-1;
+
+  *out = NULL;
+  size_t n = 0, cap = 0;
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long long start, end, off;
+    char perm[8];
+    int name_at = 0;
+    if (sscanf(line, "%llx-%llx %7s %llx %*s %*s %n", &start, &end, perm, &off, &name_at) < 4) continue;
+    if (perm[2] != 'x') continue;
+
+    if (n == cap) {
+      size_t nc = cap ? cap * 2 : 32;
+      ProcMap *nm = (ProcMap*)realloc(*out, nc * sizeof(ProcMap));
+      if (!nm) break;
+      *out = nm;
+      cap = nc;
+    }
+    ProcMap *m = &(*out)[n++];
+    m->start = start;
+    m->end = end;
+    m->offset = off;
+    m->path[0] = 0;
+    if (name_at > 0) {
+      const char *name = line + name_at;
+      size_t len = strcspn(name, "\n");
+      if (len >= sizeof(m->path)) len = sizeof(m->path) - 1;
+      memcpy(m->path, name, len);
+      m->path[len] = 0;
+    }
+  }
+  fclose(f);
+  return n;
+}
+
+// One process_vm_readv call over up to PROC_IOVS chunks; stops at the
+// first unreadable byte.
+static size_t read_batch(int pid, uint64_t addr, size_t len, uint8_t *buf) {
+  struct iovec local, remote[PROC_IOVS];
+  size_t nr = 0, off = 0;
+  while (off < len && nr < PROC_IOVS) {
+    size_t k = len - off < PROC_CHUNK ? len - off : PROC_CHUNK;
+    remote[nr].iov_base = (void*)(uintptr_t)(addr + off);
+    remote[nr].iov_len = k;
+    nr++;
+    off += k;
+  }
+  local.iov_base = buf;
+  local.iov_len = off;
+  ssize_t got = process_vm_readv(pid, &local, 1, remote, nr, 0);
+  return got > 0 ? (size_t)got : 0;
+}
+
+static size_t read_mem_file(int fd, uint64_t addr, size_t len, uint8_t *buf) {
+  ssize_t got = pread(fd, buf, len, (off_t)addr);
+  return got > 0 ? (size_t)got : 0;
+}
+
+size_t proc_read(int pid, uint64_t addr, size_t len, uint8_t *buf) {
+  int fd = -1;
+  int use_vm = 1;
+  size_t total = 0, off = 0;
+
+  while (off < len) {
+    size_t got = 0;
+    if (use_vm) {
+      got = read_batch(pid, addr + off, len - off, buf + off);
+      if (got == 0 && off == 0 && total == 0) {
+        // e.g. seccomp / no CAP_SYS_PTRACE semantics for the syscall: try /proc/PID/mem
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+        fd = open(path, O_RDONLY);
+        if (fd >= 0) use_vm = 0;
+      }
+    }
+    if (!use_vm) got = read_mem_file(fd, addr + off, len - off, buf + off);
+
+    if (got == 0) {
+      // skip the unreadable page
+      size_t k = PROC_PAGE - (size_t)((addr + off) & (PROC_PAGE - 1));
+      if (k > len - off) k = len - off;
+      memset(buf + off, 0, k);
+      off += k;
+      continue;
+    }
+    total += got;
+    off += got;
+  }
+  if (fd >= 0) close(fd);
+  return total;
+}
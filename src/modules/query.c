@@ -0,0 +1,495 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/query.h"
+#include "opdump/format.h"
+
+typedef enum {
+  QF_OP, QF_CC, QF_SIZE, QF_NOPS, QF_REL, QF_HASMEM,
+  QF_KIND, QF_WIDTH, QF_REG, QF_BASE, QF_INDEX, QF_SCALE, QF_DISP, QF_IMM
+} QField;
+
+typedef enum { QS_NONE, QS_O0, QS_O1, QS_O2, QS_O3, QS_MEM } QSel;
+
+typedef enum { QC_FLAG, QC_EQ, QC_NE, QC_LT, QC_LE, QC_GT, QC_GE } QCmp;
+
+typedef struct {
+  uint64_t w[4]; // one bit per Op value
+} OpSet;
+
+typedef struct {
+  uint8_t field;
+  uint8_t sel;
+  uint8_t cmp;
+  int8_t  cc;     // QF_OP only: required condition, -1 = any
+  int64_t val;
+  OpSet   ops;    // QF_OP only
+} QLeaf;
+
+typedef enum { QI_LEAF, QI_AND, QI_OR, QI_NOT } QInsnKind;
+
+typedef struct {
+  uint8_t  kind;
+  uint16_t leaf;
+} QInsn;
+
+typedef struct {
+  unsigned begin, end; // program range
+  unsigned window;     // max distance from previous step (0 for step 0)
+  OpSet    prefilter;  // ops that can possibly satisfy the step
+} QStep;
+
+enum { QUERY_MAX_PROG = 256, QUERY_MAX_DEPTH = 60 };
+
+struct Query {
+  QLeaf  leaves[QUERY_MAX_PROG];
+  QInsn  prog[QUERY_MAX_PROG];
+  QStep  steps[QUERY_MAX_STEPS];
+  unsigned nleaves, nprog, nsteps;
+};
+
+// ---- op sets ----
+
+static int opset_has(const OpSet *s, unsigned op) {
+  return (int)((s->w[op >> 6] >> (op & 63)) & 1u);
+}
+static void opset_add(OpSet *s, unsigned op) { s->w[op >> 6] |= (uint64_t)1 << (op & 63); }
+static void opset_all(OpSet *s) {
+  memset(s, 0, sizeof(*s));
+  for (unsigned o = 0; o < OP__COUNT; o++) opset_add(s, o);
+}
+
+// ---- parser ----
+
+typedef struct {
+  const char *src;
+  const char *p;
+  Query *q;
+  char *err;
+  size_t errcap;
+  int failed;
+} Parser;
+
+static void fail(Parser *ps, const char *msg) {
+  if (ps->failed) return;
+  ps->failed = 1;
+  if (ps->err && ps->errcap)
+    snprintf(ps->err, ps->errcap, "%s at offset %u", msg, (unsigned)(ps->p - ps->src));
+}
+
+static void skip_ws(Parser *ps) {
+  while (*ps->p && isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+static int is_word_ch(char c) {
+  return isalnum((unsigned char)c) || c == '_' || c == '.' || c == '-';
+}
+
+// reads [A-Za-z0-9_.-]+ into buf; returns length (0 = none)
+static size_t read_word(Parser *ps, char *buf, size_t cap) {
+  skip_ws(ps);
+  size_t len = 0;
+  while (is_word_ch(ps->p[len])) len++;
+  if (len == 0 || len >= cap) return 0;
+  memcpy(buf, ps->p, len);
+  buf[len] = 0;
+  return len;
+}
+
+static int accept_kw(Parser *ps, const char *kw) {
+  skip_ws(ps);
+  size_t k = strlen(kw);
+  if (strncmp(ps->p, kw, k) != 0) return 0;
+  if (isalpha((unsigned char)kw[0]) && is_word_ch(ps->p[k])) return 0;
+  ps->p += k;
+  return 1;
+}
+
+static void emit(Parser *ps, QInsnKind kind, unsigned leaf) {
+  if (ps->q->nprog >= QUERY_MAX_PROG) { fail(ps, "query too long"); return; }
+  ps->q->prog[ps->q->nprog].kind = (uint8_t)kind;
+  ps->q->prog[ps->q->nprog].leaf = (uint16_t)leaf;
+  ps->q->nprog++;
+}
+
+static int parse_int(const char *s, int64_t *out) {
+  char *end = NULL;
+  long long v = strtoll(s, &end, 0);
+  if (!end || *end) return 0;
+  *out = (int64_t)v;
+  return 1;
+}
+
+static int parse_cc(const char *s) {
+  for (int c = 0; c < 16; c++) if (strcmp(s, cc_name((Cond)c)) == 0) return c;
+  return -1;
+}
+
+static int parse_reg(const char *s, int64_t *out) {
+  if (strcmp(s, "none") == 0) { *out = 0xFF; return 1; }
+  for (unsigned r = 0; r <= 16; r++) {
+    if (strcmp(s, reg_name64((uint8_t)r)) == 0) { *out = r; return 1; }
+  }
+  return 0;
+}
+
+static int parse_op(const char *s, QLeaf *l) {
+  memset(&l->ops, 0, sizeof(l->ops));
+  l->cc = -1;
+  for (unsigned o = 0; o < OP__COUNT; o++) {
+    if (strcmp(s, op_name((Op)o)) == 0) opset_add(&l->ops, o);
+  }
+  if (l->ops.w[0] | l->ops.w[1] | l->ops.w[2] | l->ops.w[3]) return 1;
+
+  // VEX/EVEX spellings share the SSE op: vaddps -> addps
+  if (s[0] == 'v' && s[1] && parse_op(s + 1, l)) return 1;
+
+  // condition-suffixed mnemonics: je, setne, cmovg ...
+  static const struct { const char *pfx; Op op; } cc_forms[] = {
+    {"cmov", OP_CMOVCC}, {"set", OP_SETCC}, {"j", OP_JCC_REL},
+  };
+  for (size_t i = 0; i < sizeof(cc_forms)/sizeof(cc_forms[0]); i++) {
+    size_t k = strlen(cc_forms[i].pfx);
+    if (strncmp(s, cc_forms[i].pfx, k) != 0) continue;
+    int cc = parse_cc(s + k);
+    if (cc < 0) continue;
+    opset_add(&l->ops, cc_forms[i].op);
+    l->cc = (int8_t)cc;
+    return 1;
+  }
+  return 0;
+}
+
+static int parse_field(const char *name, QLeaf *l) {
+  static const struct { const char *name; QSel sel; } sels[] = {
+    {"dst", QS_O0}, {"o0", QS_O0}, {"src", QS_O1}, {"o1", QS_O1},
+    {"o2", QS_O2}, {"o3", QS_O3}, {"mem", QS_MEM},
+  };
+  static const struct { const char *name; QField f; } plain[] = {
+    {"op", QF_OP}, {"cc", QF_CC}, {"size", QF_SIZE}, {"nops", QF_NOPS},
+    {"rel", QF_REL}, {"mem", QF_HASMEM},
+  };
+  static const struct { const char *name; QField f; } opnd[] = {
+    {"kind", QF_KIND}, {"width", QF_WIDTH}, {"reg", QF_REG}, {"base", QF_BASE},
+    {"index", QF_INDEX}, {"scale", QF_SCALE}, {"disp", QF_DISP}, {"imm", QF_IMM},
+  };
+
+  const char *dot = strchr(name, '.');
+  if (!dot) {
+    for (size_t i = 0; i < sizeof(plain)/sizeof(plain[0]); i++) {
+      if (strcmp(name, plain[i].name) == 0) {
+        l->field = (uint8_t)plain[i].f;
+        l->sel = QS_NONE;
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  size_t k = (size_t)(dot - name);
+  int sel = -1;
+  for (size_t i = 0; i < sizeof(sels)/sizeof(sels[0]); i++) {
+    if (strlen(sels[i].name) == k && strncmp(name, sels[i].name, k) == 0) sel = (int)sels[i].sel;
+  }
+  if (sel < 0) return 0;
+  for (size_t i = 0; i < sizeof(opnd)/sizeof(opnd[0]); i++) {
+    if (strcmp(dot + 1, opnd[i].name) == 0) {
+      l->field = (uint8_t)opnd[i].f;
+      l->sel = (uint8_t)sel;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static QCmp read_cmp(Parser *ps) {
+  skip_ws(ps);
+  if (accept_kw(ps, "==")) return QC_EQ;
+  if (accept_kw(ps, "!=")) return QC_NE;
+  if (accept_kw(ps, "<=")) return QC_LE;
+  if (accept_kw(ps, ">=")) return QC_GE;
+  if (accept_kw(ps, "<"))  return QC_LT;
+  if (accept_kw(ps, ">"))  return QC_GT;
+  if (accept_kw(ps, "="))  return QC_EQ;
+  return QC_FLAG;
+}
+
+static void parse_leaf(Parser *ps) {
+  char name[32], val[32];
+  if (!read_word(ps, name, sizeof(name))) { fail(ps, "expected field"); return; }
+  const char *at = ps->p;
+  ps->p += strlen(name);
+
+  Query *q = ps->q;
+  if (q->nleaves >= QUERY_MAX_PROG) { fail(ps, "query too long"); return; }
+  QLeaf *l = &q->leaves[q->nleaves];
+  memset(l, 0, sizeof(*l));
+  l->cc = -1;
+
+  if (!parse_field(name, l)) { ps->p = at; fail(ps, "unknown field"); return; }
+
+  l->cmp = (uint8_t)read_cmp(ps);
+  if (l->cmp == QC_FLAG) {
+    if (l->field != QF_REL && l->field != QF_HASMEM) { fail(ps, "field needs a comparison"); return; }
+  } else {
+    if (l->field == QF_REL || l->field == QF_HASMEM) { fail(ps, "flag field takes no comparison"); return; }
+    if (!read_word(ps, val, sizeof(val))) { fail(ps, "expected value"); return; }
+    const char *vat = ps->p;
+    ps->p += strlen(val);
+
+    int named = (l->field == QF_OP || l->field == QF_CC || l->field == QF_KIND ||
+                 l->field == QF_REG || l->field == QF_BASE || l->field == QF_INDEX);
+    if (named && l->cmp != QC_EQ && l->cmp != QC_NE) { fail(ps, "only = and != apply to names"); return; }
+
+    int ok = 0;
+    switch ((QField)l->field) {
+      case QF_OP: ok = parse_op(val, l); break;
+      case QF_CC: { int c = parse_cc(val); ok = (c >= 0); l->val = c; } break;
+      case QF_KIND:
+        ok = 1;
+        if      (strcmp(val, "reg") == 0)  l->val = O_REG;
+        else if (strcmp(val, "imm") == 0)  l->val = O_IMM;
+        else if (strcmp(val, "mem") == 0)  l->val = O_MEM;
+        else if (strcmp(val, "kreg") == 0) l->val = O_KREG;
+        else if (strcmp(val, "none") == 0) l->val = O_NONE;
+        else ok = 0;
+        break;
+      case QF_REG: case QF_BASE: case QF_INDEX: ok = parse_reg(val, &l->val); break;
+      default: ok = parse_int(val, &l->val); break;
+    }
+    if (!ok) { ps->p = vat; fail(ps, "bad value"); return; }
+  }
+
+  emit(ps, QI_LEAF, q->nleaves++);
+}
+
+static void parse_expr(Parser *ps, unsigned depth);
+
+static void parse_unary(Parser *ps, unsigned depth) {
+  if (depth > QUERY_MAX_DEPTH) { fail(ps, "nesting too deep"); return; }
+  skip_ws(ps);
+  if (accept_kw(ps, "!") || accept_kw(ps, "not")) {
+    parse_unary(ps, depth + 1);
+    emit(ps, QI_NOT, 0);
+    return;
+  }
+  if (accept_kw(ps, "(")) {
+    parse_expr(ps, depth + 1);
+    if (!accept_kw(ps, ")")) fail(ps, "expected ')'");
+    return;
+  }
+  parse_leaf(ps);
+}
+
+static void parse_term(Parser *ps, unsigned depth) {
+  parse_unary(ps, depth);
+  while (!ps->failed && (accept_kw(ps, "&&") || accept_kw(ps, "and"))) {
+    parse_unary(ps, depth);
+    emit(ps, QI_AND, 0);
+  }
+}
+
+static void parse_expr(Parser *ps, unsigned depth) {
+  parse_term(ps, depth);
+  while (!ps->failed && (accept_kw(ps, "||") || accept_kw(ps, "or"))) {
+    parse_term(ps, depth);
+    emit(ps, QI_OR, 0);
+  }
+}
+
+// Conservative set of ops for which prog[begin,end) can be true.
+static void compute_prefilter(const Query *q, QStep *st) {
+  OpSet stack[QUERY_MAX_PROG];
+  unsigned sp = 0;
+  for (unsigned i = st->begin; i < st->end; i++) {
+    const QInsn *pi = &q->prog[i];
+    OpSet s;
+    switch ((QInsnKind)pi->kind) {
+      case QI_LEAF: {
+        const QLeaf *l = &q->leaves[pi->leaf];
+        if (l->field == QF_OP && l->cmp == QC_EQ) {
+          s = l->ops;
+        } else if (l->field == QF_OP && l->cc < 0) {
+          opset_all(&s);
+          for (int w = 0; w < 4; w++) s.w[w] &= ~l->ops.w[w];
+        } else {
+          opset_all(&s);
+        }
+        stack[sp++] = s;
+      } break;
+      case QI_NOT:
+        opset_all(&stack[sp - 1]);
+        break;
+      case QI_AND:
+        sp--;
+        for (int w = 0; w < 4; w++) stack[sp - 1].w[w] &= stack[sp].w[w];
+        break;
+      case QI_OR:
+        sp--;
+        for (int w = 0; w < 4; w++) stack[sp - 1].w[w] |= stack[sp].w[w];
+        break;
+    }
+  }
+  st->prefilter = stack[0];
+}
+
+Query* query_compile(const char *src, char *err, size_t errcap) {
+  if (err && errcap) err[0] = 0;
+  Query *q = (Query*)calloc(1, sizeof(*q));
+  if (!q) return NULL;
+
+  Parser ps = { src, src, q, err, errcap, 0 };
+
+  unsigned window = 0;
+  for (;;) {
+    if (q->nsteps >= QUERY_MAX_STEPS) { fail(&ps, "too many sequence steps"); break; }
+    QStep *st = &q->steps[q->nsteps];
+    st->begin = q->nprog;
+    st->window = window;
+    parse_expr(&ps, 0);
+    st->end = q->nprog;
+    if (ps.failed) break;
+    compute_prefilter(q, st);
+    q->nsteps++;
+
+    if (accept_kw(&ps, "then")) { window = 1; continue; }
+    if (accept_kw(&ps, "within")) {
+      char num[16];
+      int64_t v = 0;
+      if (!read_word(&ps, num, sizeof(num)) || !parse_int(num, &v) ||
+          v < 1 || v > QUERY_MAX_WINDOW) {
+        fail(&ps, "within expects 1..64");
+        break;
+      }
+      ps.p += strlen(num);
+      window = (unsigned)v;
+      continue;
+    }
+    break;
+  }
+
+  skip_ws(&ps);
+  if (!ps.failed && *ps.p) fail(&ps, "unexpected input");
+  if (ps.failed) { free(q); return NULL; }
+  return q;
+}
+
+void query_free(Query *q) { free(q); }
+
+unsigned query_span(const Query *q) {
+  unsigned span = 1;
+  for (unsigned i = 1; i < q->nsteps; i++) span += q->steps[i].window;
+  return span;
+}
+
+// ---- evaluation ----
+
+static const Operand* pick_operand(const Insn *in, uint8_t sel) {
+  switch ((QSel)sel) {
+    case QS_O0: return in->op_count > 0 ? &in->ops[0] : NULL;
+    case QS_O1: return in->op_count > 1 ? &in->ops[1] : NULL;
+    case QS_O2: return in->op_count > 2 ? &in->ops[2] : NULL;
+    case QS_O3: return in->op_count > 3 ? &in->ops[3] : NULL;
+    case QS_MEM:
+      for (uint8_t i = 0; i < in->op_count; i++)
+        if (in->ops[i].kind == O_MEM) return &in->ops[i];
+      return NULL;
+    default: return NULL;
+  }
+}
+
+static int compare(int64_t v, uint8_t cmp, int64_t want) {
+  switch ((QCmp)cmp) {
+    case QC_EQ: return v == want;
+    case QC_NE: return v != want;
+    case QC_LT: return v <  want;
+    case QC_LE: return v <= want;
+    case QC_GT: return v >  want;
+    case QC_GE: return v >= want;
+    default:    return v != 0;
+  }
+}
+
+static int leaf_eval(const QLeaf *l, const Insn *in) {
+  int64_t v = 0;
+  switch ((QField)l->field) {
+    case QF_OP: {
+      int r = opset_has(&l->ops, (unsigned)in->op) &&
+              (l->cc < 0 || (in->has_cc && (int)in->cc == l->cc));
+      return l->cmp == QC_NE ? !r : r;
+    }
+    case QF_CC:
+      if (!in->has_cc) return 0;
+      v = in->cc;
+      break;
+    case QF_SIZE:   v = in->size; break;
+    case QF_NOPS:   v = in->op_count; break;
+    case QF_REL:    return in->has_rel;
+    case QF_HASMEM: return pick_operand(in, QS_MEM) != NULL;
+    default: {
+      const Operand *o = pick_operand(in, l->sel);
+      if (!o) return 0;
+      switch ((QField)l->field) {
+        case QF_KIND:  v = o->kind; break;
+        case QF_WIDTH: v = o->width; break;
+        case QF_REG:   if (o->kind != O_REG) return 0; v = o->reg; break;
+        case QF_BASE:  if (o->kind != O_MEM) return 0; v = o->mem.base; break;
+        case QF_INDEX: if (o->kind != O_MEM) return 0; v = o->mem.index; break;
+        case QF_SCALE: if (o->kind != O_MEM) return 0; v = o->mem.scale; break;
+        case QF_DISP:  if (o->kind != O_MEM) return 0; v = o->mem.disp; break;
+        case QF_IMM:   if (o->kind != O_IMM) return 0; v = o->imm; break;
+        default: return 0;
+      }
+    } break;
+  }
+  return compare(v, l->cmp, l->val);
+}
+
+static int step_eval(const Query *q, const QStep *st, const Insn *in) {
+  if (!opset_has(&st->prefilter, (unsigned)in->op)) return 0;
+
+  uint64_t stack = 0; // bit stack, top = bit 0
+  for (unsigned i = st->begin; i < st->end; i++) {
+    const QInsn *pi = &q->prog[i];
+    switch ((QInsnKind)pi->kind) {
+      case QI_LEAF: stack = (stack << 1) | (uint64_t)leaf_eval(&q->leaves[pi->leaf], in); break;
+      case QI_NOT:  stack ^= 1u; break;
+      case QI_AND:  stack = (stack >> 1) & (stack | ~(uint64_t)1); break;
+      case QI_OR:   stack = (stack >> 1) | (stack & 1u); break;
+    }
+  }
+  return (int)(stack & 1u);
+}
+
+void query_cursor_init(QueryCursor *c) {
+  c->seq = 0;
+  for (unsigned i = 0; i < QUERY_MAX_STEPS; i++) { c->at[i] = -1; c->start[i] = -1; }
+}
+
+size_t query_feed(const Query *q, QueryCursor *c, const Insn *ins, size_t count,
+                  QueryHitFn hit, void *user) {
+  size_t hits = 0;
+  const unsigned last = q->nsteps - 1;
+
+  for (size_t k = 0; k < count; k++) {
+    const int64_t t = (int64_t)c->seq++;
+
+    // later steps first so one instruction never advances two steps
+    for (unsigned j = last + 1; j-- > 0;) {
+      const QStep *st = &q->steps[j];
+      if (j > 0 && (c->at[j - 1] < 0 || t - c->at[j - 1] > (int64_t)st->window)) continue;
+      if (!step_eval(q, st, &ins[k])) continue;
+
+      int64_t first = (j == 0) ? t : c->start[j - 1];
+      if (j == last) {
+        hits++;
+        if (hit) hit(user, (uint64_t)first, (uint64_t)t);
+      } else {
+        c->at[j] = t;
+        c->start[j] = first;
+      }
+    }
+  }
+  return hits;
+}
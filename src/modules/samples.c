@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/samples.h"
+
+typedef struct {
+  uint64_t addr;
+  uint64_t count;
+} Sample;
+
+static int hexval(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Whole token [b, e) as hex (optional 0x). Returns 1 on success.
+static int parse_hex(const char *b, const char *e, uint64_t *out) {
+  if (e - b > 2 && b[0] == '0' && (b[1] == 'x' || b[1] == 'X')) b += 2;
+  if (b == e || e - b > 16) return 0;
+  uint64_t v = 0;
+  for (; b < e; b++) {
+    int h = hexval(*b);
+    if (h < 0) return 0;
+    v = (v << 4) | (uint64_t)h;
+  }
+  *out = v;
+  return 1;
+}
+
+static int parse_dec(const char *b, const char *e, uint64_t *out) {
+  if (b == e || e - b > 19) return 0;
+  uint64_t v = 0;
+  for (; b < e; b++) {
+    if (*b < '0' || *b > '9') return 0;
+    v = v * 10 + (uint64_t)(*b - '0');
+  }
+  *out = v;
+  return 1;
+}
+
+enum { MAX_TOK = 16 };
+
+// Splits on blanks; returns token count (at most MAX_TOK).
+static size_t tokenize(const char *line, const char **tb, const char **te) {
+  size_t nt = 0;
+  const char *p = line;
+  while (*p && nt < MAX_TOK) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    if (!*p) break;
+    tb[nt] = p;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    te[nt++] = p;
+  }
+  return nt;
+}
+
+static int parse_line(const char *line, Sample *out) {
+  const char *tb[MAX_TOK], *te[MAX_TOK];
+  size_t nt = tokenize(line, tb, te);
+  if (nt == 0 || tb[0][0] == '#') return 0;
+
+  // ADDR [COUNT]
+  out->count = 1;
+  int hex0 = parse_hex(tb[0], te[0], &out->addr);
+  if (hex0 && (nt == 1 || (nt == 2 && parse_dec(tb[1], te[1], &out->count)))) return 1;
+
+  // perf script default: the IP follows the "event:" token (the timestamp
+  // before it also ends in ':' but has no letters). Checked before the
+  // IP-first form: a comm such as "cc" or "1234" parses as hex too.
+  for (size_t t = 1; t + 1 < nt; t++) {
+    if (te[t][-1] != ':') continue;
+    int alpha = 0;
+    for (const char *c = tb[t]; c < te[t]; c++) {
+      if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')) alpha = 1;
+    }
+    if (alpha && parse_hex(tb[t + 1], te[t + 1], &out->addr)) return 1;
+  }
+
+  // perf script -F ip,sym: "IP sym+off (dso)"
+  uint64_t num;
+  if (!hex0 || parse_dec(tb[1], te[1], &num)) return 0;
+  return parse_hex(tb[0], te[0], &out->addr);
+}
+
+// LSD radix sort on addr, one byte per pass; passes where every key has
+// the same byte (the high bytes, usually) are skipped.
+static int sort_samples(Sample *v, size_t n) {
+  if (n < 2) return 1;
+  Sample *tmp = (Sample*)malloc(n * sizeof(Sample));
+  if (!tmp) return 0;
+
+  Sample *src = v, *dst = tmp;
+  for (unsigned shift = 0; shift < 64; shift += 8) {
+    size_t cnt[256] = {0};
+    for (size_t i = 0; i < n; i++) cnt[(src[i].addr >> shift) & 0xFF]++;
+    if (cnt[(src[0].addr >> shift) & 0xFF] == n) continue;
+
+    size_t pos = 0;
+    for (size_t b = 0; b < 256; b++) { size_t c = cnt[b]; cnt[b] = pos; pos += c; }
+    for (size_t i = 0; i < n; i++) dst[cnt[(src[i].addr >> shift) & 0xFF]++] = src[i];
+    Sample *t = src; src = dst; dst = t;
+  }
+  if (src != v) memcpy(v, src, n * sizeof(Sample));
+  free(tmp);
+  return 1;
+}
+
+int samples_load(const char *path, SampleIndex *out) {
+  memset(out, 0, sizeof(*out));
+  FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+  if (!f) return 0;
+
+  size_t n = 0, cap = 1u << 16;
+  Sample *v = (Sample*)malloc(cap * sizeof(Sample));
+  if (!v) { if (f != stdin) fclose(f); return 0; }
+
+  char line[1024];
+  while (fgets(line, sizeof(line), f)) {
+    Sample s;
+    if (!parse_line(line, &s) || s.count == 0) continue;
+    if (n == cap) {
+      Sample *nv = (Sample*)realloc(v, 2 * cap * sizeof(Sample));
+      if (!nv) { free(v); if (f != stdin) fclose(f); return 0; }
+      v = nv;
+      cap *= 2;
+    }
+    v[n++] = s;
+  }
+  if (f != stdin) fclose(f);
+
+  if (!sort_samples(v, n)) { free(v); return 0; }
+
+  // aggregate duplicates into parallel arrays
+  size_t u = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (u && v[u - 1].addr == v[i].addr) v[u - 1].count += v[i].count;
+    else v[u++] = v[i];
+  }
+
+  out->addr  = (uint64_t*)malloc((u ? u : 1) * sizeof(uint64_t));
+  out->count = (uint64_t*)malloc((u ? u : 1) * sizeof(uint64_t));
+  if (!out->addr || !out->count) { free(v); samples_free(out); return 0; }
+  for (size_t i = 0; i < u; i++) {
+    out->addr[i] = v[i].addr;
+    out->count[i] = v[i].count;
+    out->total += v[i].count;
+  }
+  out->n = u;
+  free(v);
+  return 1;
+}
+
+void samples_free(SampleIndex *s) {
+  free(s->addr);
+  free(s->count);
+  memset(s, 0, sizeof(*s));
+}
+
+size_t samples_lower_bound(const SampleIndex *s, uint64_t a) {
+  size_t lo = 0, hi = s->n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (s->addr[mid] < a) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+uint64_t samples_range(const SampleIndex *s, uint64_t a0, uint64_t a1) {
+  uint64_t sum = 0;
+  for (size_t i = samples_lower_bound(s, a0); i < s->n && s->addr[i] < a1; i++) sum += s->count[i];
+  return sum;
+}
+
+size_t samples_top(const SampleIndex *s, size_t k, size_t *out) {
+  if (k > s->n) k = s->n;
+  if (k == 0) return 0;
+
+  // keep a sorted top-k array; k is small compared to n
+  size_t have = 0;
+  for (size_t i = 0; i < s->n; i++) {
+    if (have == k && s->count[i] <= s->count[out[k - 1]]) continue;
+    size_t j = (have < k) ? have++ : k - 1;
+    while (j > 0 && s->count[out[j - 1]] < s->count[i]) { out[j] = out[j - 1]; j--; }
+    out[j] = i;
+  }
+  return have;
+}
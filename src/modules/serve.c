@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "opdump/serve.h"
+#include "opdump/image.h"
+#include "opdump/decode.h"
+#include "opdump/format.h"
+#include "opdump/boundary.h"
+
+enum { SERVE_LINE = 4096, SERVE_BATCH = 256, SERVE_MAX_INSNS = 1 << 20 };
+
+// ---- LRU cache of mapped binaries ----
+
+typedef struct {
+  char *path;
+  dev_t dev;
+  ino_t ino;
+  struct timespec mtime;
+  off_t size;
+
+  Image img;
+  size_t *by_name;     // symbol indexes sorted by name
+
+  unsigned refs;
+  uint64_t last_use;
+  int dead;            // evicted while in use; freed on last release
+} CacheEntry;
+
+typedef struct {
+  pthread_mutex_t mu;
+  CacheEntry **v;
+  size_t n, cap;       // cap: entries kept mapped
+  uint64_t tick, hits, misses;
+} Cache;
+
+static Cache g_cache = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0, 0, 0 };
+
+static const ElfSym *g_name_syms; // only touched under name_mu
+static pthread_mutex_t name_mu = PTHREAD_MUTEX_INITIALIZER;
+
+static int cmp_sym_name(const void *a, const void *b) {
+  return strcmp(g_name_syms[*(const size_t*)a].name, g_name_syms[*(const size_t*)b].name);
+}
+
+static void entry_free(CacheEntry *e) {
+  image_free(&e->img);
+  free(e->by_name);
+  free(e->path);
+  free(e);
+}
+
+static CacheEntry* entry_load(const char *path, const struct stat *st, int *err) {
+  CacheEntry *e = (CacheEntry*)calloc(1, sizeof(CacheEntry));
+  if (!e) { *err = IMG_ERR_READ; return NULL; }
+  e->path = (char*)malloc(strlen(path) + 1);
+  if (!e->path) { free(e); *err = IMG_ERR_READ; return NULL; }
+  strcpy(e->path, path);
+  e->dev = st->st_dev;
+  e->ino = st->st_ino;
+  e->mtime = st->st_mtim;
+  e->size = st->st_size;
+
+  *err = image_map(e->path, &e->img);
+  if (*err != IMG_OK) { free(e->path); free(e); return NULL; }
+  image_load_symbols(&e->img);
+
+  e->by_name = (size_t*)malloc((e->img.sym_count ? e->img.sym_count : 1) * sizeof(size_t));
+  if (!e->by_name) { entry_free(e); *err = IMG_ERR_READ; return NULL; }
+  for (size_t i = 0; i < e->img.sym_count; i++) e->by_name[i] = i;
+  pthread_mutex_lock(&name_mu);
+  g_name_syms = e->img.syms;
+  qsort(e->by_name, e->img.sym_count, sizeof(size_t), cmp_sym_name);
+  pthread_mutex_unlock(&name_mu);
+  return e;
+}
+
+static int entry_matches(const CacheEntry *e, const char *path, const struct stat *st) {
+  return e->ino == st->st_ino && e->dev == st->st_dev && e->size == st->st_size &&
+         e->mtime.tv_sec == st->st_mtim.tv_sec && e->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+         strcmp(e->path, path) == 0;
+}
+
+// Drops v[i] from the cache (caller holds the lock).
+static void cache_remove(Cache *c, size_t i) {
+  CacheEntry *e = c->v[i];
+  c->v[i] = c->v[--c->n];
+  if (e->refs) e->dead = 1;
+  else entry_free(e);
+}
+
+static CacheEntry* cache_get(Cache *c, const char *path, int *err) {
+  struct stat st;
+  if (stat(path, &st) != 0) { *err = IMG_ERR_READ; return NULL; }
+
+  pthread_mutex_lock(&c->mu);
+  for (size_t i = 0; i < c->n; i++) {
+    if (!entry_matches(c->v[i], path, &st)) continue;
+    CacheEntry *e = c->v[i];
+    e->refs++;
+    e->last_use = ++c->tick;
+    c->hits++;
+    pthread_mutex_unlock(&c->mu);
+    return e;
+  }
+  c->misses++;
+  pthread_mutex_unlock(&c->mu);
+
+  // load outside the lock; another worker may race us to the same file
+  CacheEntry *e = entry_load(path, &st, err);
+  if (!e) return NULL;
+
+  pthread_mutex_lock(&c->mu);
+  for (size_t i = 0; i < c->n; i++) {
+    if (entry_matches(c->v[i], path, &st)) {
+      entry_free(e);
+      e = c->v[i];
+      e->refs++;
+      e->last_use = ++c->tick;
+      pthread_mutex_unlock(&c->mu);
+      return e;
+    }
+  }
+  // older versions of the same path are stale
+  for (size_t i = c->n; i-- > 0;) {
+    if (strcmp(c->v[i]->path, path) == 0) cache_remove(c, i);
+  }
+  while (c->n >= c->cap) {
+    size_t lru = (size_t)-1;
+    for (size_t i = 0; i < c->n; i++) {
+      if (lru == (size_t)-1 || c->v[i]->last_use < c->v[lru]->last_use) lru = i;
+    }
+    if (lru == (size_t)-1) break;
+    cache_remove(c, lru);
+  }
+  c->v[c->n++] = e;
+  e->refs = 1;
+  e->last_use = ++c->tick;
+  pthread_mutex_unlock(&c->mu);
+  return e;
+}
+
+static void cache_put(Cache *c, CacheEntry *e) {
+  pthread_mutex_lock(&c->mu);
+  if (--e->refs == 0 && e->dead) entry_free(e);
+  pthread_mutex_unlock(&c->mu);
+}
+
+// ---- requests ----
+
+static const ElfExecSeg* find_seg(const Image *img, uint64_t addr) {
+  for (size_t i = 0; i < img->seg_count; i++) {
+    const ElfExecSeg *s = &img->segs[i];
+    if (addr >= s->vaddr && addr < s->vaddr + s->filesz) return s;
+  }
+  return NULL;
+}
+
+static const ElfSym* find_name(const CacheEntry *e, const char *name) {
+  size_t lo = 0, hi = e->img.sym_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = strcmp(e->img.syms[e->by_name[mid]].name, name);
+    if (c == 0) return &e->img.syms[e->by_name[mid]];
+    if (c < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return NULL;
+}
+
+// Lists instructions from a0 until a1 or max_insns; a0 must be an
+// instruction boundary inside seg.
+static void list_insns(FILE *out, const Image *img, const ElfExecSeg *seg,
+                       uint64_t a0, uint64_t a1, size_t max_insns) {
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+  Insn batch[SERVE_BATCH];
+
+  uint64_t seg_end = seg->vaddr + seg->filesz;
+  if (a1 > seg_end) a1 = seg_end;
+  size_t listed = 0;
+  uint64_t a = a0;
+  while (a < a1 && listed < max_insns) {
+    size_t used = 0;
+    size_t cap = max_insns - listed < SERVE_BATCH ? max_insns - listed : SERVE_BATCH;
+    size_t got = decode_batch(&ctx, img->buf + seg->offset + (a - seg->vaddr), (size_t)(a1 - a),
+                              a, batch, cap, &used);
+    for (size_t k = 0; k < got; k++) format_line(out, &batch[k]);
+    listed += got;
+    a += used;
+  }
+}
+
+static void do_range(FILE *out, const CacheEntry *e, char **tok, size_t ntok) {
+  if (ntok != 4) { fprintf(out, "err usage: range PATH START END\n"); return; }
+  uint64_t a0 = strtoull(tok[2], NULL, 16), a1 = strtoull(tok[3], NULL, 16);
+  const ElfExecSeg *seg = find_seg(&e->img, a0);
+  if (!seg) { fprintf(out, "err address not in code\n"); return; }
+  fprintf(out, "ok\n");
+  list_insns(out, &e->img, seg, a0, a1, SERVE_MAX_INSNS);
+}
+
+static void do_sym(FILE *out, const CacheEntry *e, char **tok, size_t ntok) {
+  if (ntok != 3) { fprintf(out, "err usage: sym PATH NAME\n"); return; }
+  const ElfSym *s = find_name(e, tok[2]);
+  const ElfExecSeg *seg = s ? find_seg(&e->img, s->addr) : NULL;
+  if (!seg) { fprintf(out, "err no such function\n"); return; }
+  fprintf(out, "ok\n");
+  list_insns(out, &e->img, seg, s->addr, s->addr + s->size, SERVE_MAX_INSNS);
+}
+
+static void do_addr(FILE *out, const CacheEntry *e, char **tok, size_t ntok) {
+  if (ntok != 3 && ntok != 4) { fprintf(out, "err usage: addr PATH ADDR [N]\n"); return; }
+  uint64_t addr = strtoull(tok[2], NULL, 16);
+  size_t count = ntok == 4 ? (size_t)strtoull(tok[3], NULL, 10) : 1;
+  if (count > SERVE_MAX_INSNS) count = SERVE_MAX_INSNS;
+  const ElfExecSeg *seg = find_seg(&e->img, addr);
+  if (!seg) { fprintf(out, "err address not in code\n"); return; }
+
+  // sweep from the function start to stay on instruction boundaries
+  const ElfSym *s = elf_sym_lookup(e->img.syms, e->img.sym_count, addr);
+  uint64_t a = (s && s->addr >= seg->vaddr) ? s->addr : addr;
+  a += insn_sync(e->img.buf + seg->offset + (a - seg->vaddr),
+                 (size_t)(seg->vaddr + seg->filesz - a), (size_t)(addr - a));
+
+  fprintf(out, "ok\n");
+  if (s) fprintf(out, "%s+0x%llx\n", s->name, (unsigned long long)(addr - s->addr));
+  else   fprintf(out, "<none>\n");
+  list_insns(out, &e->img, seg, a, seg->vaddr + seg->filesz, count);
+}
+
+static void handle(FILE *out, char *line) {
+  char *tok[8], *save = NULL;
+  size_t ntok = 0;
+  for (char *t = strtok_r(line, " \t\r\n", &save); t && ntok < 8; t = strtok_r(NULL, " \t\r\n", &save)) {
+    tok[ntok++] = t;
+  }
+  if (ntok == 0) return;
+
+  if (strcmp(tok[0], "stats") == 0) {
+    pthread_mutex_lock(&g_cache.mu);
+    fprintf(out, "ok\nentries %llu\nhits %llu\nmisses %llu\n", (unsigned long long)g_cache.n,
+      (unsigned long long)g_cache.hits, (unsigned long long)g_cache.misses);
+    pthread_mutex_unlock(&g_cache.mu);
+  } else if (ntok < 2 || (strcmp(tok[0], "range") && strcmp(tok[0], "sym") && strcmp(tok[0], "addr"))) {
+    fprintf(out, "err unknown request\n");
+  } else {
+    int err = IMG_OK;
+    CacheEntry *e = cache_get(&g_cache, tok[1], &err);
+    if (!e) {
+      fprintf(out, "err %s\n", image_strerror(err));
+    } else {
+      if (tok[0][0] == 'r')      do_range(out, e, tok, ntok);
+      else if (tok[0][0] == 's') do_sym(out, e, tok, ntok);
+      else                       do_addr(out, e, tok, ntok);
+      cache_put(&g_cache, e);
+    }
+  }
+  fprintf(out, ".\n");
+  fflush(out);
+}
+
+static void* worker(void *arg) {
+  int lfd = *(const int*)arg;
+  char line[SERVE_LINE];
+  for (;;) {
+    int fd = accept(lfd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      return NULL;
+    }
+    int wfd = dup(fd);
+    FILE *in = fdopen(fd, "r");
+    FILE *out = wfd >= 0 ? fdopen(wfd, "w") : NULL;
+    if (!in || !out) {
+      if (in) fclose(in); else close(fd);
+      if (out) fclose(out); else if (wfd >= 0) close(wfd);
+      continue;
+    }
+    while (fgets(line, sizeof(line), in)) handle(out, line);
+    fclose(in);
+    fclose(out);
+  }
+}
+
+int serve(const char *sock_path, const ServeOptions *opt) {
+  struct sockaddr_un sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  if (strlen(sock_path) >= sizeof(sa.sun_path)) {
+    fprintf(stderr, "Error: socket path too long\n");
+    return 1;
+  }
+  strcpy(sa.sun_path, sock_path);
+
+  int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (lfd < 0) { perror("socket"); return 1; }
+  unlink(sock_path);
+  if (bind(lfd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(lfd, 64) != 0) {
+    fprintf(stderr, "Error: %s: %s\n", sock_path, strerror(errno));
+    close(lfd);
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  g_cache.cap = opt->cache_entries ? opt->cache_entries : 1;
+  g_cache.v = (CacheEntry**)calloc(g_cache.cap + 1, sizeof(CacheEntry*));
+  if (!g_cache.v) { close(lfd); return 1; }
+
+  size_t nth = opt->threads ? opt->threads : 1;
+  for (size_t i = 1; i < nth; i++) {
+    pthread_t th;
+    if (pthread_create(&th, NULL, worker, &lfd) == 0) pthread_detach(th);
+  }
+  worker(&lfd);
+  close(lfd);
+  return 1;
+}
@@ -0,0 +1,452 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "opdump/shard.h"
+#include "opdump/archive.h"
+#include "opdump/boundary.h"
+#include "opdump/decode.h"
+#include "opdump/arena.h"
+
+enum { PLAN_LINE = 4200 };
+
+static const uint64_t k_fnv_basis = 0xcbf29ce484222325ull;
+
+static uint64_t fnv(uint64_t h, const char *s) {
+  for (; *s; s++) { h ^= (uint8_t)*s; h *= 0x100000001b3ull; }
+  return h;
+}
+
+typedef struct {
+  uint64_t size;
+  const char *path;
+} PlanFile;
+
+typedef struct {
+  size_t shard, file, seg;
+  uint64_t start, end;
+} PlanPiece;
+
+typedef struct {
+  Arena arena;
+  uint64_t id;
+  size_t nshards;
+  PlanFile *files;
+  size_t nfiles;
+  PlanPiece *pieces;
+  size_t npieces;
+} Plan;
+
+// ---- planning ----
+
+typedef struct {
+  size_t file, seg;
+  uint64_t base;      // bytes of all earlier segments
+} PlanSeg;
+
+// Region start nearest to want in (lo, hi), or want when there is none.
+static uint64_t snap_cut(const Region *r, size_t nr, uint64_t want, uint64_t lo, uint64_t hi) {
+  size_t a = 0, b = nr;
+  while (a < b) {
+    size_t mid = a + (b - a) / 2;
+    if (r[mid].addr <= want) a = mid + 1;
+    else b = mid;
+  }
+  uint64_t best = want, dist = UINT64_MAX;
+  if (a > 0 && r[a - 1].addr > lo && r[a - 1].addr < hi) {
+    best = r[a - 1].addr;
+    dist = want - best;
+  }
+  if (a < nr && r[a].addr > lo && r[a].addr < hi && r[a].addr - want < dist) best = r[a].addr;
+  return best;
+}
+
+// Shard k starts at byte cut(k) of the concatenated segments.
+static uint64_t cut_at(uint64_t total, size_t n, size_t k) {
+  return total / n * k + total % n * k / n;
+}
+
+static void emit_piece(FILE *body, uint64_t *id, size_t *np, size_t shard, const PlanSeg *ps,
+                       uint64_t a0, uint64_t a1, uint64_t *shard_bytes, size_t *shard_pieces) {
+  char line[PLAN_LINE];
+  snprintf(line, sizeof(line), "piece %zu %zu %zu %zu 0x%llx 0x%llx", *np, shard, ps->file,
+           ps->seg, (unsigned long long)a0, (unsigned long long)a1);
+  *id = fnv(*id, line);
+  fprintf(body, "%s\n", line);
+  shard_bytes[shard] += a1 - a0;
+  shard_pieces[shard]++;
+  (*np)++;
+}
+
+int shard_plan(FILE *out, const char *const *paths, size_t npaths, size_t nshards) {
+  if (nshards == 0) nshards = 1;
+  Image *imgs = (Image*)calloc(npaths ? npaths : 1, sizeof(Image));
+  uint64_t *shard_bytes = (uint64_t*)calloc(nshards, sizeof(uint64_t));
+  size_t *shard_pieces = (size_t*)calloc(nshards, sizeof(size_t));
+  PlanSeg *segs = NULL;
+  size_t nsegs = 0, cap = 0, loaded = 0;
+  char *text = NULL;
+  size_t text_len = 0;
+  FILE *body = NULL;
+  int rc = IMG_ERR_READ;
+  if (!imgs || !shard_bytes || !shard_pieces) goto done;
+
+  uint64_t total = 0;
+  for (; loaded < npaths; loaded++) {
+    if (archive_probe(paths[loaded])) {
+      fprintf(stderr, "Error: %s: --plan takes ELF files, not archives\n", paths[loaded]);
+      rc = IMG_ERR_ELF;
+      goto done;
+    }
+    int err = image_map(paths[loaded], &imgs[loaded]);
+    if (err != IMG_OK) {
+      fprintf(stderr, "Error: %s: %s\n", paths[loaded], image_strerror(err));
+      rc = err;
+      goto done;
+    }
+    const Image *img = &imgs[loaded];
+    for (size_t s = 0; s < img->seg_count; s++) {
+      if (img->segs[s].filesz == 0) continue;
+      if (nsegs == cap) {
+        size_t nc = cap ? cap * 2 : 64;
+        PlanSeg *nv = (PlanSeg*)realloc(segs, nc * sizeof(PlanSeg));
+        if (!nv) goto done;
+        segs = nv;
+        cap = nc;
+      }
+      segs[nsegs].file = loaded;
+      segs[nsegs].seg = s;
+      segs[nsegs].base = total;
+      nsegs++;
+      total += img->segs[s].filesz;
+    }
+  }
+
+  body = open_memstream(&text, &text_len);
+  if (!body) goto done;
+  uint64_t id = k_fnv_basis;
+  for (size_t f = 0; f < npaths; f++) {
+    char line[PLAN_LINE];
+    snprintf(line, sizeof(line), "file %zu %llu %s", f, (unsigned long long)imgs[f].n, paths[f]);
+    id = fnv(id, line);
+    fprintf(body, "%s\n", line);
+  }
+
+  Arena *sa = arena_thread();
+  size_t k = 0, np = 0;
+  for (size_t i = 0; i < nsegs; i++) {
+    Image *img = &imgs[segs[i].file];
+    const ElfExecSeg *seg = &img->segs[segs[i].seg];
+    uint64_t base = segs[i].base, at = 0;
+    while (k + 1 < nshards && cut_at(total, nshards, k + 1) <= base) k++;
+
+    image_load_symbols(img);
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(seg, img->syms, img->sym_count, sa, &regs);
+    for (; k + 1 < nshards && cut_at(total, nshards, k + 1) < base + seg->filesz; k++) {
+      uint64_t want = seg->vaddr + (cut_at(total, nshards, k + 1) - base);
+      uint64_t cut = snap_cut(regs, nr, want, seg->vaddr + at, seg->vaddr + seg->filesz) - seg->vaddr;
+      if (cut <= at) continue;   // an earlier cut already moved past this one
+      emit_piece(body, &id, &np, k, &segs[i], seg->vaddr + at, seg->vaddr + cut,
+                 shard_bytes, shard_pieces);
+      at = cut;
+    }
+    emit_piece(body, &id, &np, k, &segs[i], seg->vaddr + at, seg->vaddr + seg->filesz,
+               shard_bytes, shard_pieces);
+    arena_reset(sa, mark);
+  }
+  if (fclose(body) != 0) { body = NULL; goto done; }
+  body = NULL;
+
+  fprintf(out, "# opdump plan v1\n");
+  fprintf(out, "plan %016llx shards %zu files %zu pieces %zu bytes %llu\n", (unsigned long long)id,
+          nshards, npaths, np, (unsigned long long)total);
+  fwrite(text, 1, text_len, out);
+  for (size_t s = 0; s < nshards; s++) {
+    fprintf(out, "shard %zu %llu %zu\n", s, (unsigned long long)shard_bytes[s], shard_pieces[s]);
+  }
+  rc = 0;
+
+done:
+  if (body) fclose(body);
+  free(text);
+  for (size_t f = 0; f < loaded && imgs; f++) image_free(&imgs[f]);
+  free(imgs);
+  free(segs);
+  free(shard_bytes);
+  free(shard_pieces);
+  return rc;
+}
+
+// ---- manifest ----
+
+static int plan_bad(const char *path, size_t lineno) {
+  fprintf(stderr, "Error: %s: bad manifest line %zu\n", path, lineno);
+  return 0;
+}
+
+static void plan_free(Plan *pl) { arena_free(&pl->arena); }
+
+// Shortest well-formed "file" / "piece" lines, newline included: the counts
+// a plan line announces must fit in the manifest before they are allocated.
+enum { FILE_LINE_MIN = 10, PIECE_LINE_MIN = 18 };
+
+// Returns 1 when the manifest is complete and matches its plan id.
+static int plan_read(const char *path, Plan *pl) {
+  memset(pl, 0, sizeof(*pl));
+  arena_init(&pl->arena, 0);
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Error: %s: cannot read manifest\n", path);
+    return 0;
+  }
+
+  struct stat st;
+  size_t msize = fstat(fileno(f), &st) == 0 && st.st_size > 0 ? (size_t)st.st_size : 0;
+
+  char *line = NULL;
+  size_t lcap = 0, lineno = 0, nf = 0, npc = 0;
+  uint64_t id = k_fnv_basis;
+  int have_plan = 0, ok = 1;
+  ssize_t len;
+  while (ok && (len = getline(&line, &lcap, f)) >= 0) {
+    lineno++;
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = 0;
+    if (len == 0 || line[0] == '#') continue;
+
+    if (strncmp(line, "plan ", 5) == 0) {
+      unsigned long long pid, bytes;
+      if (have_plan || sscanf(line, "plan %llx shards %zu files %zu pieces %zu bytes %llu", &pid,
+                              &pl->nshards, &pl->nfiles, &pl->npieces, &bytes) != 5 ||
+          pl->nshards == 0 || pl->nfiles > msize / FILE_LINE_MIN ||
+          pl->npieces > msize / PIECE_LINE_MIN) {
+        ok = plan_bad(path, lineno);
+        break;
+      }
+      pl->id = pid;
+      pl->files = (PlanFile*)arena_alloc(&pl->arena, pl->nfiles * sizeof(PlanFile));
+      pl->pieces = (PlanPiece*)arena_alloc(&pl->arena, pl->npieces * sizeof(PlanPiece));
+      if (!pl->files || !pl->pieces) ok = plan_bad(path, lineno);
+      have_plan = 1;
+    } else if (strncmp(line, "file ", 5) == 0) {
+      size_t idx;
+      unsigned long long size;
+      int at = 0;
+      if (!have_plan || sscanf(line, "file %zu %llu %n", &idx, &size, &at) != 2 || at == 0 ||
+          idx != nf || nf == pl->nfiles) {
+        ok = plan_bad(path, lineno);
+        break;
+      }
+      char *p = (char*)arena_alloc(&pl->arena, strlen(line + at) + 1);
+      if (!p) { ok = plan_bad(path, lineno); break; }
+      strcpy(p, line + at);
+      pl->files[nf].path = p;
+      pl->files[nf].size = size;
+      nf++;
+      id = fnv(id, line);
+    } else if (strncmp(line, "piece ", 6) == 0) {
+      size_t idx;
+      unsigned long long a0, a1;
+      PlanPiece *pc = have_plan && npc < pl->npieces ? &pl->pieces[npc] : NULL;
+      if (!pc || sscanf(line, "piece %zu %zu %zu %zu %llx %llx", &idx, &pc->shard, &pc->file,
+                        &pc->seg, &a0, &a1) != 6 || idx != npc || pc->shard >= pl->nshards ||
+          pc->file >= pl->nfiles || a0 > a1) {
+        ok = plan_bad(path, lineno);
+        break;
+      }
+      pc->start = a0;
+      pc->end = a1;
+      npc++;
+      id = fnv(id, line);
+    } else if (strncmp(line, "shard ", 6) != 0) {
+      ok = plan_bad(path, lineno);
+    }
+  }
+  free(line);
+  fclose(f);
+
+  if (ok && (!have_plan || nf != pl->nfiles || npc != pl->npieces || id != pl->id)) {
+    fprintf(stderr, "Error: %s: manifest is incomplete or does not match its plan id\n", path);
+    ok = 0;
+  }
+  if (!ok) plan_free(pl);
+  return ok;
+}
+
+// ---- one shard ----
+
+// File offset of the first instruction of seg's linear sweep at or after addr.
+static uint64_t resync(const Image *img, const ElfExecSeg *seg, uint64_t addr) {
+  size_t len = (size_t)seg->filesz, rel = (size_t)(addr - seg->vaddr);
+  if (rel == 0 || rel >= len) return seg->offset + (rel < len ? rel : len);
+  const uint8_t *p = img->buf + seg->offset;
+  size_t at = insn_sync(p, len, rel);
+  if (at != rel) {
+    DecodeCtx ctx = {0};
+    ctx.is64 = 1;
+    Insn in;
+    size_t used = decode_one(&ctx, p + at, len - at, seg->vaddr + at, &in);
+    at += used ? used : 1;
+  }
+  return seg->offset + at;
+}
+
+int shard_run(FILE *out, const char *manifest, size_t k, ShardDumpFn fn, void *user) {
+  Plan pl;
+  if (!plan_read(manifest, &pl)) return 1;
+  if (k >= pl.nshards) {
+    fprintf(stderr, "Error: shard %zu out of range (%zu shards)\n", k, pl.nshards);
+    plan_free(&pl);
+    return 1;
+  }
+
+  fprintf(out, "#@ plan %016llx shard %zu\n", (unsigned long long)pl.id, k);
+  Image img;
+  memset(&img, 0, sizeof(img));
+  size_t cur = SIZE_MAX;
+  int rc = 0;
+  for (size_t i = 0; i < pl.npieces && rc == 0; i++) {
+    const PlanPiece *pc = &pl.pieces[i];
+    if (pc->shard != k) continue;
+    const PlanFile *pf = &pl.files[pc->file];
+    if (pc->file != cur) {
+      image_free(&img);
+      cur = pc->file;
+      int err = image_map(pf->path, &img);
+      if (err != IMG_OK) {
+        fprintf(stderr, "Error: %s: %s\n", pf->path, image_strerror(err));
+        rc = err;
+        break;
+      }
+      if (img.n != pf->size) {
+        fprintf(stderr, "Error: %s: changed since the plan was made\n", pf->path);
+        rc = 1;
+        break;
+      }
+    }
+    const ElfExecSeg *seg = pc->seg < img.seg_count ? &img.segs[pc->seg] : NULL;
+    if (!seg || pc->start < seg->vaddr || pc->end > seg->vaddr + seg->filesz) {
+      fprintf(stderr, "Error: %s: piece %zu is outside segment %zu\n", pf->path, i, pc->seg);
+      rc = 1;
+      break;
+    }
+
+    fprintf(out, "#@ piece %zu\n", i);
+    uint64_t off0 = resync(&img, seg, pc->start), off1 = resync(&img, seg, pc->end);
+    if (off0 < off1) fn(out, &img, seg, off0, off1, user);
+  }
+  image_free(&img);
+  plan_free(&pl);
+  return rc;
+}
+
+// ---- merge ----
+
+typedef struct {
+  size_t output;      // SIZE_MAX: not seen yet
+  off_t begin, end;   // listing bytes after the "#@ piece" line
+} PieceSpan;
+
+static int scan_output(const char *path, size_t o, const Plan *pl, PieceSpan *span) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Error: %s: cannot read shard output\n", path);
+    return IMG_ERR_READ;
+  }
+  char *line = NULL;
+  size_t lcap = 0, cur = SIZE_MAX, k = 0;
+  unsigned long long id = 0;
+  int rc = 0;
+  ssize_t len = getline(&line, &lcap, f);
+  if (len < 0 || sscanf(line, "#@ plan %llx shard %zu", &id, &k) != 2 || id != pl->id) {
+    fprintf(stderr, "Error: %s: not a shard output of this plan\n", path);
+    rc = 1;
+  }
+  while (rc == 0) {
+    off_t at = ftello(f);
+    len = getline(&line, &lcap, f);
+    if (len < 0 || strncmp(line, "#@ piece ", 9) == 0) {
+      if (cur != SIZE_MAX) span[cur].end = at;
+      if (len < 0) break;
+      size_t p;
+      if (sscanf(line, "#@ piece %zu", &p) != 1 || p >= pl->npieces || pl->pieces[p].shard != k) {
+        fprintf(stderr, "Error: %s: piece line does not belong to shard %zu\n", path, k);
+        rc = 1;
+        break;
+      }
+      if (span[p].output != SIZE_MAX) {
+        fprintf(stderr, "Error: %s: piece %zu appears twice\n", path, p);
+        rc = 1;
+        break;
+      }
+      span[p].output = o;
+      span[p].begin = ftello(f);
+      cur = p;
+    }
+  }
+  free(line);
+  fclose(f);
+  return rc;
+}
+
+int shard_merge(FILE *out, const char *manifest, const char *const *outputs, size_t noutputs) {
+  Plan pl;
+  if (!plan_read(manifest, &pl)) return 1;
+  PieceSpan *span = (PieceSpan*)arena_alloc(&pl.arena, pl.npieces * sizeof(PieceSpan));
+  if (!span) { plan_free(&pl); return IMG_ERR_READ; }
+  for (size_t p = 0; p < pl.npieces; p++) span[p].output = SIZE_MAX;
+
+  int rc = 0;
+  for (size_t o = 0; o < noutputs && rc == 0; o++) rc = scan_output(outputs[o], o, &pl, span);
+  for (size_t p = 0; p < pl.npieces && rc == 0; p++) {
+    if (span[p].output != SIZE_MAX) continue;
+    fprintf(stderr, "Error: %s: piece %zu (shard %zu) is missing\n", manifest, p,
+            pl.pieces[p].shard);
+    rc = 1;
+  }
+  if (rc) { plan_free(&pl); return rc; }
+
+  FILE *in = NULL;
+  size_t open_output = SIZE_MAX, last_file = SIZE_MAX;
+  uint64_t code = 0, listing = 0;
+  char buf[1 << 16];
+  for (size_t p = 0; p < pl.npieces && rc == 0; p++) {
+    const PieceSpan *s = &span[p];
+    if (s->output != open_output) {
+      if (in) fclose(in);
+      in = fopen(outputs[s->output], "r");
+      open_output = s->output;
+      if (!in) {
+        fprintf(stderr, "Error: %s: cannot read shard output\n", outputs[s->output]);
+        rc = IMG_ERR_READ;
+        break;
+      }
+    }
+    if (pl.nfiles > 1 && pl.pieces[p].file != last_file) {
+      fprintf(out, "%s:\n", pl.files[pl.pieces[p].file].path);
+    }
+    last_file = pl.pieces[p].file;
+    code += pl.pieces[p].end - pl.pieces[p].start;
+
+    off_t left = s->end - s->begin;
+    if (fseeko(in, s->begin, SEEK_SET) != 0) { rc = IMG_ERR_READ; break; }
+    while (left > 0) {
+      size_t want = left < (off_t)sizeof(buf) ? (size_t)left : sizeof(buf);
+      size_t got = fread(buf, 1, want, in);
+      if (got == 0) { rc = IMG_ERR_READ; break; }
+      fwrite(buf, 1, got, out);
+      left -= (off_t)got;
+      listing += got;
+    }
+  }
+  if (in) fclose(in);
+  if (rc == 0) {
+    fprintf(stderr, "# merged %zu pieces of %zu shards from %zu outputs: %zu files, "
+                    "%llu code bytes, %llu listing bytes\n", pl.npieces, pl.nshards, noutputs,
+            pl.nfiles, (unsigned long long)code, (unsigned long long)listing);
+  }
+  plan_free(&pl);
+  return rc;
+}
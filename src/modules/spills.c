@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opdump/spills.h"
+#include "opdump/flow.h"
+#include "opdump/cost.h"
+#include "opdump/arena.h"
+
+// A stack slot as seen by the whole function.
+typedef struct {
+  uint64_t key;        // base << 32 | (uint32_t)disp
+  uint8_t stored, loaded;
+} Slot;
+
+typedef struct {
+  uint64_t head;       // address of the loop head
+  uint64_t insns, spills, reloads, pairs;
+  uint64_t samples;
+  double density, score;
+  const char *name;
+  uint64_t func;       // function address, for unnamed regions
+} SpillLoop;
+
+typedef struct {
+  const char *name;
+  uint64_t addr;
+  uint64_t loops, spills, reloads, pairs;
+} SpillFunc;
+
+// mov between a register and a stack slot
+static int slot_move(const Insn *in, uint64_t *key, int *store) {
+  if (in->op_count != 2) return 0;
+  CostClass c = cost_class(in);
+  if (c != COST_MOV && c != COST_VMOV && c != COST_MOVD) return 0;
+  const Operand *m;
+  if (in->ops[0].kind == O_MEM && in->ops[1].kind == O_REG)      { m = &in->ops[0]; *store = 1; }
+  else if (in->ops[0].kind == O_REG && in->ops[1].kind == O_MEM) { m = &in->ops[1]; *store = 0; }
+  else return 0;
+  if (m->mem.index != 0xFF || (m->mem.base != GPR_SP && m->mem.base != GPR_BP)) return 0;
+  *key = (uint64_t)m->mem.base << 32 | (uint32_t)m->mem.disp;
+  return 1;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+static int cmp_slot(const void *a, const void *b) {
+  return cmp_u64(&((const Slot*)a)->key, &((const Slot*)b)->key);
+}
+
+static const Slot* slot_find(const Slot *s, size_t n, uint64_t key) {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (s[mid].key < key) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < n && s[lo].key == key ? &s[lo] : NULL;
+}
+
+// Every slot the function moves registers to or from, sorted, flags merged.
+static size_t collect_slots(const InsnVec *vec, Arena *sa, Slot **out) {
+  size_t n = 0;
+  Slot *s = (Slot*)arena_alloc(sa, vec->n * sizeof(Slot));
+  *out = s;
+  if (!s) return 0;
+  for (size_t i = 0; i < vec->n; i++) {
+    uint64_t key;
+    int store;
+    if (!slot_move(&vec->v[i], &key, &store)) continue;
+    s[n].key = key;
+    s[n].stored = (uint8_t)store;
+    s[n].loaded = (uint8_t)!store;
+    n++;
+  }
+  if (n) qsort(s, n, sizeof(Slot), cmp_slot);
+  size_t u = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (u && s[u - 1].key == s[i].key) {
+      s[u - 1].stored |= s[i].stored;
+      s[u - 1].loaded |= s[i].loaded;
+    } else {
+      s[u++] = s[i];
+    }
+  }
+  return u;
+}
+
+// Spills / reloads of v[head..tail]; pairs counts slots stored and loaded in the loop.
+static void scan_loop(const Insn *v, size_t head, size_t tail, const Slot *slots, size_t ns,
+                      Arena *sa, SpillLoop *lp) {
+  ArenaMark mark = arena_mark(sa);
+  size_t len = tail - head + 1, nk = 0;
+  uint64_t *keys = (uint64_t*)arena_alloc(sa, len * sizeof(uint64_t));
+  for (size_t i = head; i <= tail; i++) {
+    uint64_t key;
+    int store;
+    if (!slot_move(&v[i], &key, &store)) continue;
+    const Slot *s = slot_find(slots, ns, key);
+    if (!s) continue;
+    if (store && s->loaded) lp->spills++;
+    if (!store && s->stored) lp->reloads++;
+    // bit 0 of the shifted key: 1 = store
+    if (keys) keys[nk++] = key << 1 | (uint64_t)store;
+  }
+  if (keys) {
+    qsort(keys, nk, sizeof(uint64_t), cmp_u64);
+    for (size_t i = 0; i + 1 < nk; i++) {
+      if ((keys[i] >> 1) == (keys[i + 1] >> 1) && !(keys[i] & 1) && (keys[i + 1] & 1)) lp->pairs++;
+    }
+  }
+  arena_reset(sa, mark);
+}
+
+static int cmp_loop_rank(const void *a, const void *b) {
+  const SpillLoop *x = (const SpillLoop*)a, *y = (const SpillLoop*)b;
+  if (x->score != y->score) return x->score < y->score ? 1 : -1;
+  return (x->head > y->head) - (x->head < y->head);
+}
+
+static int cmp_func_rank(const void *a, const void *b) {
+  const SpillFunc *x = (const SpillFunc*)a, *y = (const SpillFunc*)b;
+  uint64_t sx = x->spills + x->reloads, sy = y->spills + y->reloads;
+  if (sx != sy) return sx < sy ? 1 : -1;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+void spill_report(FILE *out, const Image *img, const SampleIndex *smp, const char *label) {
+  Arena *sa = arena_thread();
+  InsnVec vec = {0};
+  Loop *loops = NULL;
+  size_t loops_cap = 0;
+  SpillLoop *rows = NULL;
+  size_t nrows = 0, rows_cap = 0;
+  SpillFunc *funcs = NULL;
+  size_t nfuncs = 0, funcs_cap = 0;
+  uint64_t nloops = 0;
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+
+    for (size_t r = 0; r < nr; r++) {
+      if (!insn_vec_decode(&vec, img->buf + regs[r].offset, regs[r].size, regs[r].addr)) break;
+      size_t nl = vec.n ? flow_find_loops(&vec, &loops, &loops_cap) : 0;
+      if (nl == 0) continue;
+      nloops += nl;
+
+      ArenaMark fmark = arena_mark(sa);
+      Slot *slots = NULL;
+      size_t ns = collect_slots(&vec, sa, &slots);
+      SpillFunc fn = { regs[r].name, regs[r].addr, 0, 0, 0, 0 };
+      for (size_t l = 0; ns && l < nl; l++) {
+        SpillLoop lp;
+        memset(&lp, 0, sizeof(lp));
+        scan_loop(vec.v, loops[l].head, loops[l].tail, slots, ns, sa, &lp);
+        if (lp.spills + lp.reloads == 0) continue;
+
+        const Insn *tail = &vec.v[loops[l].tail];
+        lp.head = vec.v[loops[l].head].addr;
+        lp.insns = loops[l].tail - loops[l].head + 1;
+        lp.density = (double)(lp.spills + lp.reloads) / (double)lp.insns;
+        lp.name = regs[r].name;
+        lp.func = regs[r].addr;
+        if (smp && smp->total) {
+          lp.samples = samples_range(smp, lp.head, tail->addr + tail->size);
+          lp.score = lp.density * (double)lp.samples / (double)smp->total;
+        } else {
+          lp.score = lp.density;
+        }
+        fn.loops++;
+        fn.spills += lp.spills;
+        fn.reloads += lp.reloads;
+        fn.pairs += lp.pairs;
+
+        if (nrows == rows_cap) {
+          size_t nc = rows_cap ? rows_cap * 2 : 256;
+          SpillLoop *nv = (SpillLoop*)realloc(rows, nc * sizeof(SpillLoop));
+          if (!nv) continue;
+          rows = nv;
+          rows_cap = nc;
+        }
+        rows[nrows++] = lp;
+      }
+      arena_reset(sa, fmark);
+
+      if (fn.loops == 0) continue;
+      if (nfuncs == funcs_cap) {
+        size_t nc = funcs_cap ? funcs_cap * 2 : 64;
+        SpillFunc *nv = (SpillFunc*)realloc(funcs, nc * sizeof(SpillFunc));
+        if (!nv) continue;
+        funcs = nv;
+        funcs_cap = nc;
+      }
+      funcs[nfuncs++] = fn;
+    }
+    arena_reset(sa, mark);
+  }
+
+  if (nrows) qsort(rows, nrows, sizeof(SpillLoop), cmp_loop_rank);
+  if (nfuncs) qsort(funcs, nfuncs, sizeof(SpillFunc), cmp_func_rank);
+
+  uint64_t spills = 0, reloads = 0;
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# rank  density  spills reloads  pairs  insns  samples  head              function\n");
+  for (size_t i = 0; i < nrows; i++) {
+    const SpillLoop *lp = &rows[i];
+    char gap[40], pct[16];
+    if (smp && smp->total) snprintf(pct, sizeof(pct), "%6.2f%%", 100.0 * (double)lp->samples / (double)smp->total);
+    else snprintf(pct, sizeof(pct), "%7s", "-");
+    if (label) fprintf(out, "%s: ", label);
+    fprintf(out, "%6zu  %7.3f %7llu %7llu %6llu %6llu  %s  %016llx  %s\n", i + 1, lp->density,
+      (unsigned long long)lp->spills, (unsigned long long)lp->reloads,
+      (unsigned long long)lp->pairs, (unsigned long long)lp->insns, pct,
+      (unsigned long long)lp->head, region_name(lp->name, lp->func, gap, sizeof(gap)));
+  }
+
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# func   loops  spills reloads  pairs  function\n");
+  for (size_t i = 0; i < nfuncs; i++) {
+    const SpillFunc *fn = &funcs[i];
+    char gap[40];
+    spills += fn->spills;
+    reloads += fn->reloads;
+    if (label) fprintf(out, "%s: ", label);
+    fprintf(out, "func  %6llu %7llu %7llu %6llu  %s\n", (unsigned long long)fn->loops,
+      (unsigned long long)fn->spills, (unsigned long long)fn->reloads,
+      (unsigned long long)fn->pairs, region_name(fn->name, fn->addr, gap, sizeof(gap)));
+  }
+
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "# %zu of %llu loops spill, in %zu functions: %llu spills, %llu reloads\n",
+    nrows, (unsigned long long)nloops, nfuncs, (unsigned long long)spills,
+    (unsigned long long)reloads);
+
+  free(rows);
+  free(funcs);
+  free(loops);
+  insn_vec_free(&vec);
+}
@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include "opdump/vecreport.h"
+#include "opdump/decode.h"
+#include "opdump/arena.h"
+
+enum { VEC_BATCH = 4096 };
+
+void vec_stats_add(VecStats *st, const Insn *in) {
+  st->insns++;
+  if (in->vkind == VK_SCALAR) {
+    st->scalar++;
+  } else if (in->vkind == VK_PACKED) {
+    if (in->vl >= 512)      st->zmm++;
+    else if (in->vl >= 256) st->ymm++;
+    else                    st->xmm++;
+  }
+}
+
+const char* vec_stats_width(const VecStats *st) {
+  if (st->zmm)    return "avx512";
+  if (st->ymm)    return "avx2";
+  if (st->xmm)    return "sse";
+  if (st->scalar) return "scalar";
+  return "none";
+}
+
+static void print_row(FILE *out, const VecStats *st, uint64_t addr, const char *name,
+                      const char *label) {
+  if (label) fprintf(out, "%s: ", label);
+  fprintf(out, "%-7s %8llu %8llu %8llu %8llu %8llu  %016llx  %s\n",
+    vec_stats_width(st),
+    (unsigned long long)st->insns, (unsigned long long)st->scalar,
+    (unsigned long long)st->xmm, (unsigned long long)st->ymm,
+    (unsigned long long)st->zmm, (unsigned long long)addr, name);
+}
+
+void vector_report(FILE *out, const Image *img, const char *label) {
+  Arena *sa = arena_thread();
+  ArenaMark batch_mark = arena_mark(sa);
+  Insn *batch = (Insn*)arena_alloc(sa, VEC_BATCH * sizeof(Insn));
+  if (!batch) return;
+
+  DecodeCtx ctx = {0};
+  ctx.is64 = 1;
+
+  VecStats total = {0};
+  fprintf(out, "# width      insns   scalar      sse     avx2   avx512  address           function\n");
+
+  for (size_t s = 0; s < img->seg_count; s++) {
+    ArenaMark mark = arena_mark(sa);
+    Region *regs = NULL;
+    size_t nr = elf_split_regions(&img->segs[s], img->syms, img->sym_count, sa, &regs);
+
+    for (size_t r = 0; r < nr; r++) {
+      VecStats st = {0};
+      const uint8_t *p = img->buf + regs[r].offset;
+      uint64_t off = 0;
+      while (off < regs[r].size) {
+        size_t used = 0;
+        size_t got = decode_batch(&ctx, p + off, (size_t)(regs[r].size - off),
+                                  regs[r].addr + off, batch, VEC_BATCH, &used);
+        for (size_t k = 0; k < got; k++) vec_stats_add(&st, &batch[k]);
+        off += used;
+      }
+
+      total.insns  += st.insns;
+      total.scalar += st.scalar;
+      total.xmm    += st.xmm;
+      total.ymm    += st.ymm;
+      total.zmm    += st.zmm;
+
+      if (st.scalar + st.xmm + st.ymm + st.zmm == 0) continue;
+      char gap[40];
+      const char *name = region_name(regs[r].name, regs[r].addr, gap, sizeof(gap));
+      print_row(out, &st, regs[r].addr, name, label);
+    }
+    arena_reset(sa, mark);
+  }
+
+  print_row(out, &total, 0, "<total>", label);
+  arena_reset(sa, batch_mark);
+}